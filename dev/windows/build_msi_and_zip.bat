@@ -46,7 +46,7 @@ echo Continuing...
 call vcvarsall.bat %ARCH%
 
 set QTDIRS=bearer iconengines imageformats platforms printsupport sqldrivers
-set QTLIBS=Qt5CLucene Qt5Core Qt5Gui Qt5Help Qt5Network Qt5PrintSupport Qt5Sql Qt5Widgets Qt5Xml
+set QTLIBS=Qt5CLucene Qt5Concurrent Qt5Core Qt5Gui Qt5Help Qt5Network Qt5PrintSupport Qt5Sql Qt5Widgets Qt5Xml
 
 set SCRIPTDIR=%cd%
 rem Directory containing engauge.pro
@@ -37,7 +37,7 @@
 #
 # More comments are in the INSTALL file, and below
 
-QT += core gui printsupport widgets xml
+QT += concurrent core gui printsupport widgets xml
 
 !mac {
 QT += help
@@ -72,6 +72,7 @@ HEADERS  += \
     src/Background/BackgroundStateNone.h \
     src/Background/BackgroundStateOriginal.h \
     src/Background/BackgroundStateUnloaded.h \
+    src/util/BitPlane.h \
     src/Callback/CallbackAddPointsInCurvesGraphs.h \
     src/Callback/CallbackAxesCheckerFromAxesPoints.h \
     src/Callback/CallbackAxisPointsAbstract.h \
@@ -131,8 +132,10 @@ HEADERS  += \
     src/Cmd/CmdUndoForTest.h \
     src/Color/ColorConstants.h \
     src/Color/ColorFilter.h \
+    src/Color/ColorFilterEngine.h \
     src/Color/ColorFilterEntry.h \
     src/Color/ColorFilterHistogram.h \
+    src/Color/ColorFilterLookup.h \
     src/Color/ColorFilterMode.h \
     src/Color/ColorFilterSettings.h \
     src/Color/ColorFilterSettingsStrategyAbstractBase.h \
@@ -148,6 +151,7 @@ HEADERS  += \
     src/Color/ColorFilterStrategySaturation.h \
     src/Color/ColorFilterStrategyValue.h \
     src/Color/ColorPalette.h \
+    src/util/ConnectedComponents.h \
     src/Coord/CoordScale.h \
     src/Coord/CoordsType.h \
     src/Coord/CoordSymbol.h \
@@ -269,6 +273,7 @@ HEADERS  += \
     src/Export/ExportValuesOrdinal.h \
     src/Export/ExportValuesXOrY.h \
     src/Export/ExportXThetaValuesMergedFunctions.h \
+    src/util/FftwPlannerLock.h \
     src/FileCmd/FileCmdAbstract.h \
     src/FileCmd/FileCmdClose.h \
     src/FileCmd/FileCmdExport.h \
@@ -363,7 +368,11 @@ HEADERS  += \
     src/Point/PointComparator.h \
     src/Point/PointIdentifiers.h \
     src/Point/PointMatchAlgorithm.h \
+    src/Point/PointMatchCache.h \
+    src/Point/PointMatchDirect.h \
     src/Point/PointMatchPixel.h \
+    src/Point/PointMatchRegion.h \
+    src/Point/PointMatchThread.h \
     src/Point/PointMatchTriplet.h \
     src/Point/Points.h \
     src/Point/PointShape.h \
@@ -372,7 +381,13 @@ HEADERS  += \
     src/ScaleBar/ScaleBarAxisPointsUnite.h \
     src/Segment/Segment.h \
     src/Segment/SegmentFactory.h \
+    src/Segment/SegmentGeometry.h \
+    src/Segment/SegmentIndex.h \
     src/Segment/SegmentLine.h \
+    src/Segment/SegmentRun.h \
+    src/Segment/SegmentScan.h \
+    src/Segment/SegmentScanThread.h \
+    src/Segment/SegmentSimplifier.h \
     src/Settings/Settings.h \
     src/Settings/SettingsForGraph.h \
     src/Spline/Spline.h \
@@ -431,6 +446,7 @@ SOURCES += \
     src/Background/BackgroundStateNone.cpp \
     src/Background/BackgroundStateOriginal.cpp \
     src/Background/BackgroundStateUnloaded.cpp \
+    src/util/BitPlane.cpp \
     src/Callback/CallbackAddPointsInCurvesGraphs.cpp \
     src/Callback/CallbackAxesCheckerFromAxesPoints.cpp \
     src/Callback/CallbackAxisPointsAbstract.cpp \
@@ -488,7 +504,9 @@ SOURCES += \
     src/Cmd/CmdStackShadow.cpp \
     src/Cmd/CmdUndoForTest.cpp \
     src/Color/ColorFilter.cpp \
+    src/Color/ColorFilterEngine.cpp \
     src/Color/ColorFilterHistogram.cpp \
+    src/Color/ColorFilterLookup.cpp \
     src/Color/ColorFilterMode.cpp \
     src/Color/ColorFilterSettings.cpp \
     src/Color/ColorFilterSettingsStrategyAbstractBase.cpp \
@@ -504,6 +522,7 @@ SOURCES += \
     src/Color/ColorFilterStrategySaturation.cpp \
     src/Color/ColorFilterStrategyValue.cpp \
     src/Color/ColorPalette.cpp \
+    src/util/ConnectedComponents.cpp \
     src/Coord/CoordScale.cpp \
     src/Coord/CoordsType.cpp \
     src/Coord/CoordSymbol.cpp \
@@ -618,6 +637,7 @@ SOURCES += \
     src/Export/ExportToClipboard.cpp \
     src/Export/ExportToFile.cpp \
     src/Export/ExportXThetaValuesMergedFunctions.cpp \
+    src/util/FftwPlannerLock.cpp \
     src/FileCmd/FileCmdAbstract.cpp \
     src/FileCmd/FileCmdClose.cpp \
     src/FileCmd/FileCmdExport.cpp \
@@ -703,7 +723,11 @@ SOURCES += \
     src/Point/Point.cpp \
     src/Point/PointIdentifiers.cpp \
     src/Point/PointMatchAlgorithm.cpp \
+    src/Point/PointMatchCache.cpp \
+    src/Point/PointMatchDirect.cpp \
     src/Point/PointMatchPixel.cpp \
+    src/Point/PointMatchRegion.cpp \
+    src/Point/PointMatchThread.cpp \
     src/Point/PointMatchTriplet.cpp \
     src/Point/PointShape.cpp \
     src/Point/PointStyle.cpp \
@@ -711,7 +735,11 @@ SOURCES += \
     src/ScaleBar/ScaleBarAxisPointsUnite.cpp \
     src/Segment/Segment.cpp \
     src/Segment/SegmentFactory.cpp \
+    src/Segment/SegmentIndex.cpp \
     src/Segment/SegmentLine.cpp \
+    src/Segment/SegmentScan.cpp \
+    src/Segment/SegmentScanThread.cpp \
+    src/Segment/SegmentSimplifier.cpp \
     src/Settings/Settings.cpp \
     src/Settings/SettingsForGraph.cpp \
     src/Spline/Spline.cpp \
@@ -819,7 +847,7 @@ win32-msvc* {
     LIBS +=  -L$$(FFTW_HOME)/lib
     QMAKE_LFLAGS += -Wl,--stack,32000000
   }
-  LIBS += -lfftw3
+  LIBS += -lfftw3_threads -lfftw3
   !log4cpp_null {
     LIBS += -llog4cpp
   }
@@ -9,17 +9,21 @@
 #include "BackgroundStateNone.h"
 #include "BackgroundStateOriginal.h"
 #include "BackgroundStateUnloaded.h"
+#include "ColorFilter.h"
 #include "DocumentModelColorFilter.h"
 #include "DocumentModelGridRemoval.h"
 #include "EngaugeAssert.h"
 #include "GraphicsView.h"
 #include "Logger.h"
 #include "MainWindow.h"
+#include <QColor>
 #include <QGraphicsPixmapItem>
 #include "Transformation.h"
 
 BackgroundStateContext::BackgroundStateContext(MainWindow &mainWindow) :
-  m_mainWindow (mainWindow)
+  m_mainWindow (mainWindow),
+  m_rgbMarginColor (QColor (Qt::white).rgb ()),
+  m_marginColorCacheKey (0)
 {
   LOG4CPP_INFO_S ((*mainCat)) << "BackgroundStateContext::BackgroundStateContext";
 
@@ -85,9 +89,17 @@ void BackgroundStateContext::fitInView (GraphicsView &view)
 
 }
 
-QImage BackgroundStateContext::imageForCurveState () const
+const BitPlane &BackgroundStateContext::bitPlaneForCurveState () const
 {
-  return m_states [BACKGROUND_STATE_CURVE]->image();
+  const BackgroundStateCurve *stateCurve = dynamic_cast<const BackgroundStateCurve*> (m_states [BACKGROUND_STATE_CURVE]);
+  ENGAUGE_CHECK_PTR (stateCurve);
+
+  return stateCurve->bitPlaneFiltered ();
+}
+
+QRgb BackgroundStateContext::marginColor () const
+{
+  return m_rgbMarginColor;
 }
 
 void BackgroundStateContext::requestStateTransition (BackgroundState backgroundState)
@@ -156,6 +168,16 @@ void BackgroundStateContext::setPixmap (bool isGnuplot,
                               << " image=" << pixmapOriginal.width() << "x" << pixmapOriginal.height()
                               << " currentState=" << m_states [m_currentState]->state().toLatin1().data();
 
+  // Margin color is computed before the states are updated, since BackgroundStateCurve needs it. Repeated calls
+  // with the same image do not recompute it
+  if (pixmapOriginal.cacheKey () != m_marginColorCacheKey) {
+
+    QImage imageOriginal = pixmapOriginal.toImage ();
+    ColorFilter filter;
+    m_rgbMarginColor = filter.marginColor (&imageOriginal);
+    m_marginColorCacheKey = pixmapOriginal.cacheKey ();
+  }
+
   for (int backgroundState = 0; backgroundState < NUM_BACKGROUND_STATES; backgroundState++) {
 
     m_states [backgroundState]->setPixmap (isGnuplot,
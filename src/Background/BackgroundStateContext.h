@@ -9,6 +9,8 @@
 
 #include "BackgroundImage.h"
 #include "BackgroundStateAbstractBase.h"
+#include "BitPlane.h"
+#include <QRgb>
 #include <QVector>
 
 class DocumentModelColorFilter;
@@ -41,8 +43,13 @@ class BackgroundStateContext
   /// Zoom so background fills the window
   void fitInView (GraphicsView &view);
 
-  /// Image for the Curve state, even if the current state is different
-  QImage imageForCurveState () const;
+  /// Packed image for the Curve state, even if the current state is different
+  const BitPlane &bitPlaneForCurveState () const;
+
+
+  /// Most common color in the margins of the original image. This is computed once per image, in setPixmap, and then
+  /// shared by the color filtering, the color filter histogram and the color picker
+  QRgb marginColor () const;
 
   /// Initiate state transition to be performed later, when BackgroundState is off the stack
   void requestStateTransition (BackgroundState backgroundState);
@@ -83,6 +90,10 @@ class BackgroundStateContext
   QVector<BackgroundStateAbstractBase*> m_states;
   BackgroundState m_currentState;
   BackgroundState m_requestedState; // Same as m_currentState until requestStateTransition is called
+
+  // Margin color of the original image, and the cache key of the pixmap it was computed from
+  QRgb m_rgbMarginColor;
+  qint64 m_marginColorCacheKey;
 };
 
 #endif // BACKGROUND_STATE_CONTEXT_H
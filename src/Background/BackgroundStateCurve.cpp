@@ -18,7 +18,15 @@
 BackgroundStateCurve::BackgroundStateCurve(BackgroundStateContext &context,
                                            GraphicsScene &scene) :
   BackgroundStateAbstractBase(context,
-                              scene)
+                              scene),
+  m_colorFilterIsCached (false),
+  m_colorFilterPixmapCacheKey (0),
+  m_colorFilterMode (COLOR_FILTER_MODE_INTENSITY),
+  m_colorFilterLow (0.0),
+  m_colorFilterHigh (0.0),
+  m_colorFilterBackground (0),
+  m_gridRemovalIsCached (false),
+  m_gridRemovalIsGnuplot (false)
 {
 }
 
@@ -29,6 +37,24 @@ void BackgroundStateCurve::begin()
   setImageVisible (true);
 }
 
+const BitPlane &BackgroundStateCurve::bitPlaneFiltered () const
+{
+  return m_bitPlaneFiltered;
+}
+
+bool BackgroundStateCurve::colorFilterCacheIsStale (QRgb rgbBackground,
+                                                    const DocumentModelColorFilter &modelColorFilter,
+                                                    const QString &curveSelected) const
+{
+  return !m_colorFilterIsCached ||
+         (m_colorFilterPixmapCacheKey != m_pixmapOriginal.cacheKey ()) ||
+         (m_colorFilterCurve != curveSelected) ||
+         (m_colorFilterMode != modelColorFilter.colorFilterMode (curveSelected)) ||
+         (m_colorFilterLow != modelColorFilter.low (curveSelected)) ||
+         (m_colorFilterHigh != modelColorFilter.high (curveSelected)) ||
+         (m_colorFilterBackground != rgbBackground);
+}
+
 void BackgroundStateCurve::end()
 {
   LOG4CPP_INFO_S ((*mainCat)) << "BackgroundStateCurve::end";
@@ -43,6 +69,37 @@ void BackgroundStateCurve::fitInView (GraphicsView &view)
   view.fitInView (imageItem ().boundingRect());
 }
 
+bool BackgroundStateCurve::gridRemovalCacheIsStale (bool isGnuplot,
+                                                    const Transformation &transformation,
+                                                    const DocumentModelGridRemoval &modelGridRemoval) const
+{
+  if (!m_gridRemovalIsCached) {
+    return true;
+  }
+
+  // GridRemoval::remove does nothing unless removal is wanted and possible, in which case the other inputs are irrelevant
+  bool isActive = modelGridRemoval.removeDefinedGridLines () &&
+                  transformation.transformIsDefined ();
+  bool wasActive = m_gridRemovalModel.removeDefinedGridLines () &&
+                   m_gridRemovalTransformation.transformIsDefined ();
+  if (!isActive && !wasActive) {
+    return false;
+  }
+
+  return (isActive != wasActive) ||
+         (m_gridRemovalIsGnuplot != isGnuplot) ||
+         (m_gridRemovalTransformation != transformation) ||
+         (m_gridRemovalModel.closeDistance () != modelGridRemoval.closeDistance ()) ||
+         (m_gridRemovalModel.countX () != modelGridRemoval.countX ()) ||
+         (m_gridRemovalModel.countY () != modelGridRemoval.countY ()) ||
+         (m_gridRemovalModel.startX () != modelGridRemoval.startX ()) ||
+         (m_gridRemovalModel.startY () != modelGridRemoval.startY ()) ||
+         (m_gridRemovalModel.stepX () != modelGridRemoval.stepX ()) ||
+         (m_gridRemovalModel.stepY () != modelGridRemoval.stepY ()) ||
+         (m_gridRemovalModel.stopX () != modelGridRemoval.stopX ()) ||
+         (m_gridRemovalModel.stopY () != modelGridRemoval.stopY ());
+}
+
 void BackgroundStateCurve::processImageFromSavedInputs (bool isGnuplot,
                                                         const Transformation &transformation,
                                                         const DocumentModelGridRemoval &modelGridRemoval,
@@ -54,22 +111,63 @@ void BackgroundStateCurve::processImageFromSavedInputs (bool isGnuplot,
   // Use the settings if the selected curve is known
   if (!curveSelected.isEmpty()) {
 
-    // Generate filtered image
     FilterImage filterImage;
-    QPixmap pixmapFiltered = filterImage.filter (isGnuplot,
-                                                 m_pixmapOriginal.toImage(),
-                                                 transformation,
-                                                 curveSelected,
-                                                 modelColorFilter,
-                                                 modelGridRemoval);
+    QRgb rgbBackground = context().marginColor();
+
+    if (colorFilterCacheIsStale (rgbBackground,
+                                 modelColorFilter,
+                                 curveSelected)) {
+
+      // Color filter the whole image. Grid removal has to be redone afterwards
+      m_bitPlaneColorFiltered = filterImage.filterColor (m_pixmapOriginal.toImage(),
+                                                         rgbBackground,
+                                                         curveSelected,
+                                                         modelColorFilter);
+
+      m_colorFilterIsCached = true;
+      m_colorFilterPixmapCacheKey = m_pixmapOriginal.cacheKey ();
+      m_colorFilterCurve = curveSelected;
+      m_colorFilterMode = modelColorFilter.colorFilterMode (curveSelected);
+      m_colorFilterLow = modelColorFilter.low (curveSelected);
+      m_colorFilterHigh = modelColorFilter.high (curveSelected);
+      m_colorFilterBackground = rgbBackground;
+      m_gridRemovalIsCached = false;
+
+    }
+
+    if (gridRemovalCacheIsStale (isGnuplot,
+                                 transformation,
+                                 modelGridRemoval)) {
 
-    setProcessedPixmap (pixmapFiltered);
+      // Remove grid lines from the cached color filtered image
+      m_bitPlaneFiltered = filterImage.removeGrid (isGnuplot,
+                                                   transformation,
+                                                   modelGridRemoval,
+                                                   m_bitPlaneColorFiltered);
+
+      m_gridRemovalIsCached = true;
+      m_gridRemovalIsGnuplot = isGnuplot;
+      m_gridRemovalTransformation = transformation;
+      m_gridRemovalModel = modelGridRemoval;
+
+      setProcessedPixmap (QPixmap::fromImage (m_bitPlaneFiltered.toImage ()));
+
+    } else {
+
+      LOG4CPP_INFO_S ((*mainCat)) << "BackgroundStateCurve::processImageFromSavedInputs reusing cached filtered image";
+
+    }
 
   } else {
 
     // Set the image in case BackgroundStateContext::fitInView is called, so the bounding rect is available
+    m_bitPlaneFiltered = BitPlane (m_pixmapOriginal.toImage());
     setProcessedPixmap (m_pixmapOriginal);
 
+    // Processed pixmap no longer matches the caches
+    m_colorFilterIsCached = false;
+    m_gridRemovalIsCached = false;
+
   }
 }
 
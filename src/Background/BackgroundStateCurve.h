@@ -8,6 +8,11 @@
 #define BACKGROUND_STATE_CURVE_H
 
 #include "BackgroundStateAbstractBase.h"
+#include "BitPlane.h"
+#include "ColorFilterMode.h"
+#include "DocumentModelGridRemoval.h"
+#include <QRgb>
+#include "Transformation.h"
 
 /// Background image state for showing filter image from current curve
 class BackgroundStateCurve : public BackgroundStateAbstractBase
@@ -18,6 +23,11 @@ class BackgroundStateCurve : public BackgroundStateAbstractBase
                        GraphicsScene &scene);
 
   virtual void begin();
+
+  /// Packed filtered image, or the thresholded original image if no curve is selected. This is what the displayed
+  /// image shows, in the format used by segment fill and point match
+  const BitPlane &bitPlaneFiltered () const;
+
   virtual void end();
   virtual void fitInView (GraphicsView &view);
   virtual void setCurveSelected (bool isGnuplot,
@@ -41,6 +51,12 @@ class BackgroundStateCurve : public BackgroundStateAbstractBase
  private:
   BackgroundStateCurve();
 
+  bool colorFilterCacheIsStale (QRgb rgbBackground,
+                                const DocumentModelColorFilter &modelColorFilter,
+                                const QString &curveSelected) const;
+  bool gridRemovalCacheIsStale (bool isGnuplot,
+                                const Transformation &transformation,
+                                const DocumentModelGridRemoval &modelGridRemoval) const;
   void processImageFromSavedInputs(bool isGnuplot,
                                    const Transformation &transformation,
                                    const DocumentModelGridRemoval &modelGridRemoval,
@@ -49,6 +65,26 @@ class BackgroundStateCurve : public BackgroundStateAbstractBase
 
   // Data saved for use by processImageFromSavedInputs
   QPixmap m_pixmapOriginal;
+
+  BitPlane m_bitPlaneFiltered;
+
+  // Cache of the color filter stage, which is the expensive one. Commands that do not change the settings below, like
+  // adding points, reuse it as is
+  bool m_colorFilterIsCached;
+  qint64 m_colorFilterPixmapCacheKey;
+  QString m_colorFilterCurve;
+  ColorFilterMode m_colorFilterMode;
+  double m_colorFilterLow;
+  double m_colorFilterHigh;
+  QRgb m_colorFilterBackground;
+  BitPlane m_bitPlaneColorFiltered;
+
+  // Cache of the grid removal stage, whose output is m_bitPlaneFiltered. When just these inputs change, only grid removal
+  // is redone on m_bitPlaneColorFiltered
+  bool m_gridRemovalIsCached;
+  bool m_gridRemovalIsGnuplot;
+  Transformation m_gridRemovalTransformation;
+  DocumentModelGridRemoval m_gridRemovalModel;
 };
 
 #endif // BACKGROUND_STATE_CURVE_H
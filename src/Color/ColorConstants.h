@@ -28,5 +28,6 @@ const int VALUE_MIN = 0;
 const int VALUE_MAX = 100;
 const int VALUE_LOW_DEFAULT = 0;
 const int VALUE_HIGH_DEFAULT = 50;
+const int BLACK_WHITE_THRESHOLD = 255 / 2; // Gray levels below the middle of the range are black
 
 #endif // CURVE_CONSTANTS_H
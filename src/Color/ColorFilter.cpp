@@ -4,8 +4,10 @@
  * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
  ******************************************************************************************************/
 
+#include "BitPlane.h"
 #include "ColorConstants.h"
 #include "ColorFilter.h"
+#include "ColorFilterEngine.h"
 #include "ColorFilterStrategyForeground.h"
 #include "ColorFilterStrategyHue.h"
 #include "ColorFilterStrategyIntensity.h"
@@ -16,6 +18,9 @@
 #include <QDebug>
 #include <qmath.h>
 #include <QImage>
+#include <QVector>
+
+const int MARGIN_COLOR_BUCKETS = 16 * 16 * 16;
 
 ColorFilter::ColorFilter()
 {
@@ -29,6 +34,20 @@ bool ColorFilter::colorCompare (QRgb rgb1,
   return (rgb1 & MASK) == (rgb2 & MASK);
 }
 
+ColorFilterEngine *ColorFilter::createEngine (ColorFilterMode colorFilterMode,
+                                              double low,
+                                              double high,
+                                              QRgb rgbBackground) const
+{
+  ENGAUGE_ASSERT (m_strategies.contains (colorFilterMode));
+
+  return new ColorFilterEngine (*m_strategies [colorFilterMode],
+                                colorFilterMode,
+                                low,
+                                high,
+                                rgbBackground);
+}
+
 void ColorFilter::createStrategies ()
 {
   m_strategies [COLOR_FILTER_MODE_FOREGROUND] = new ColorFilterStrategyForeground ();
@@ -43,44 +62,72 @@ void ColorFilter::filterImage (const QImage &imageOriginal,
                                ColorFilterMode colorFilterMode,
                                double low,
                                double high,
-                               QRgb rgbBackground)
+                               QRgb rgbBackground,
+                               int threadCount)
 {
   ENGAUGE_ASSERT (imageOriginal.width () == imageFiltered.width());
   ENGAUGE_ASSERT (imageOriginal.height() == imageFiltered.height());
   ENGAUGE_ASSERT (imageFiltered.format () == QImage::Format_RGB32);
 
-  for (int x = 0; x < imageOriginal.width(); x++) {
-    for (int y = 0; y < imageOriginal.height (); y++) {
+  if (m_strategies.contains (colorFilterMode)) {
 
-      QColor pixel = imageOriginal.pixel (x, y);
-      bool isOn = false;
-      if (pixel.rgb() != rgbBackground) {
+    // Strategy and thresholds are resolved once, rather than for every pixel
+    ColorFilterEngine engine (*m_strategies [colorFilterMode],
+                              colorFilterMode,
+                              low,
+                              high,
+                              rgbBackground);
+    engine.filterImage (imageOriginal,
+                        imageFiltered,
+                        threadCount);
 
-        isOn = pixelUnfilteredIsOn (colorFilterMode,
-                                    pixel,
-                                    rgbBackground,
-                                    low,
-                                    high);
-      }
+  } else {
+
+    ENGAUGE_ASSERT (false);
+
+  }
+}
+
+void ColorFilter::filterImage (const QImage &imageOriginal,
+                               BitPlane &bitPlaneFiltered,
+                               ColorFilterMode colorFilterMode,
+                               double low,
+                               double high,
+                               QRgb rgbBackground,
+                               int threadCount)
+{
+  ENGAUGE_ASSERT (imageOriginal.size () == bitPlaneFiltered.size ());
+
+  if (m_strategies.contains (colorFilterMode)) {
+
+    ColorFilterEngine engine (*m_strategies [colorFilterMode],
+                              colorFilterMode,
+                              low,
+                              high,
+                              rgbBackground);
+    engine.filterImage (imageOriginal,
+                        bitPlaneFiltered,
+                        threadCount);
+
+  } else {
+
+    ENGAUGE_ASSERT (false);
 
-      imageFiltered.setPixel (x, y, (isOn ?
-                                     QColor (Qt::black).rgb () :
-                                     QColor (Qt::white).rgb ()));
-    }
   }
 }
 
 QRgb ColorFilter::marginColor(const QImage *image) const
 {
-  // Add unique colors to colors list
+  // Add unique colors to colors list. Colors are listed in the order they are first seen
   ColorList colorCounts;
+  QVector<int> bucketToIndex (MARGIN_COLOR_BUCKETS, -1);
   for (int x = 0; x < image->width (); x++) {
-    mergePixelIntoColorCounts (image->pixel (x, 0), colorCounts);
-    mergePixelIntoColorCounts (image->pixel (x, image->height () - 1), colorCounts);
+    mergePixelIntoColorCounts (image->pixel (x, 0), colorCounts, bucketToIndex);
+    mergePixelIntoColorCounts (image->pixel (x, image->height () - 1), colorCounts, bucketToIndex);
   }
   for (int y = 0; y < image->height (); y++) {
-    mergePixelIntoColorCounts (image->pixel (0, y), colorCounts);
-    mergePixelIntoColorCounts (image->pixel (image->width () - 1, y), colorCounts);
+    mergePixelIntoColorCounts (image->pixel (0, y), colorCounts, bucketToIndex);
+    mergePixelIntoColorCounts (image->pixel (image->width () - 1, y), colorCounts, bucketToIndex);
   }
 
   // Margin color is the most frequent color
@@ -96,24 +143,24 @@ QRgb ColorFilter::marginColor(const QImage *image) const
 }
 
 void ColorFilter::mergePixelIntoColorCounts (QRgb pixel,
-                                             ColorList &colorCounts) const
+                                             ColorList &colorCounts,
+                                             QVector<int> &bucketToIndex) const
 {
   ColorFilterEntry entry;
   entry.color = pixel;
   entry.count = 0;
 
-  // Look for previous entry
-  bool found = false;
-  for (ColorList::iterator itr = colorCounts.begin (); itr != colorCounts.end (); itr++) {
-    if (colorCompare (entry.color.rgb(),
-                      (*itr).color.rgb())) {
-      found = true;
-      ++(*itr).count;
-      break;
-    }
-  }
+  // Colors that colorCompare considers the same share a bucket, which is indexed by the four high bits of red,
+  // green and blue. Alpha is not included since it is dropped by QColor
+  QRgb rgb = entry.color.rgb();
+  int bucket = ((qRed (rgb) & 0xf0) << 4) | (qGreen (rgb) & 0xf0) | (qBlue (rgb) >> 4);
 
-  if (!found) {
+  // Look for previous entry
+  int index = bucketToIndex [bucket];
+  if (index >= 0) {
+    ++colorCounts [index].count;
+  } else {
+    bucketToIndex [bucket] = colorCounts.count ();
     colorCounts.append (entry);
   }
 }
@@ -131,7 +178,6 @@ bool ColorFilter::pixelFilteredIsOn (const QImage &image,
 
     // Pixel is on if it is closer to black than white in gray scale. This test must be performed
     // on little endian and big endian systems, with or without alpha bits (which are typically high bits);
-    const int BLACK_WHITE_THRESHOLD = 255 / 2; // Put threshold in middle of range
     int gray = qGray (pixelRGB (image, x, y));
     rtn = (gray < BLACK_WHITE_THRESHOLD);
 
@@ -146,26 +192,13 @@ bool ColorFilter::pixelUnfilteredIsOn (ColorFilterMode colorFilterMode,
                                        double low0To1,
                                        double high0To1) const
 {
-  bool rtn = false;
-
   double s = pixelToZeroToOneOrMinusOne (colorFilterMode,
                                          pixel,
                                          rgbBackground);
-  if (s >= 0.0) {
-    if (low0To1 <= high0To1) {
-
-      // Single valid range
-      rtn = (low0To1 <= s) && (s <= high0To1);
-
-    } else {
 
-      // Two ranges
-      rtn = (s <= high0To1) || (low0To1 <= s);
-
-    }
-  }
-
-  return rtn;
+  return ColorFilterEngine::zeroToOneIsOn (s,
+                                           low0To1,
+                                           high0To1);
 }
 
 double ColorFilter::pixelToZeroToOneOrMinusOne (ColorFilterMode colorFilterMode,
@@ -12,7 +12,10 @@
 #include <QList>
 #include <QMap>
 #include <QRgb>
+#include <QVector>
 
+class BitPlane;
+class ColorFilterEngine;
 class ColorFilterStrategyAbstractBase;
 class QImage;
 
@@ -27,17 +30,37 @@ public:
   bool colorCompare (QRgb rgb1,
                      QRgb rgb2) const;
 
-  /// Filter the original image according to the specified filtering parameters.
+  /// Create an engine for filtering many pixels with the specified filtering parameters. The engine refers to
+  /// strategies owned by this object, which must outlive it. Caller takes ownership
+  ColorFilterEngine *createEngine (ColorFilterMode colorFilterMode,
+                                   double low,
+                                   double high,
+                                   QRgb rgbBackground) const;
+
+  /// Filter the original image according to the specified filtering parameters. The rows are split into bands
+  /// that are filtered in parallel when threadCount is greater than one
   void filterImage (const QImage &imageOriginal,
                     QImage &imageFiltered,
                     ColorFilterMode colorFilterMode,
                     double low,
                     double high,
-                    QRgb rgbBackground);
+                    QRgb rgbBackground,
+                    int threadCount);
+
+  /// Filter the original image into a packed bit plane of the same size, which is the format used by segment fill,
+  /// point match and grid removal
+  void filterImage (const QImage &imageOriginal,
+                    BitPlane &bitPlaneFiltered,
+                    ColorFilterMode colorFilterMode,
+                    double low,
+                    double high,
+                    QRgb rgbBackground,
+                    int threadCount);
 
   /// Identify the margin color of the image, which is defined as the most common color in the four margins. For speed,
   /// only pixels in the four borders are examined, with the results from those borders safely representing the most
-  /// common color of the entire margin areas.
+  /// common color of the entire margin areas. Colors are counted in a histogram of buckets matching colorCompare.
+  /// BackgroundStateContext::marginColor caches the result for the current document image.
   QRgb marginColor(const QImage *image) const;
 
   /// Return true if specified filtered pixel is on
@@ -69,7 +92,8 @@ private:
   typedef QList<ColorFilterEntry> ColorList;
 
   void mergePixelIntoColorCounts (QRgb pixel,
-                                  ColorList &colorCounts) const;
+                                  ColorList &colorCounts,
+                                  QVector<int> &bucketToIndex) const;
 
   // Strategies for mode-specific computations
   QMap<ColorFilterMode, ColorFilterStrategyAbstractBase*> m_strategies;
@@ -0,0 +1,662 @@
+/******************************************************************************************************
+ * (C) 2014 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#include "BitPlane.h"
+#include "ColorFilterEngine.h"
+#include "ColorFilterStrategyAbstractBase.h"
+#include "EngaugeAssert.h"
+#include <QColor>
+#include <qmath.h>
+#include <QtConcurrentMap>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COLOR_FILTER_ENGINE_SSE2
+#include <emmintrin.h>
+#endif
+
+// AVX2 is compiled with a function level target attribute and selected at runtime, so the rest of the
+// application does not have to be built for AVX2 capable cpus
+#if defined(COLOR_FILTER_ENGINE_SSE2) && (defined(__GNUC__) || defined(__clang__)) && \
+  (defined(__x86_64__) || defined(__i386__))
+#define COLOR_FILTER_ENGINE_AVX2
+#include <immintrin.h>
+#endif
+
+const QRgb RGB_ON = 0xff000000; // Black
+const QRgb RGB_OFF = 0xffffffff; // White
+const QRgb ALPHA_MASK = 0xff000000;
+
+// Bands per thread. More than one evens out the load when some bands are slower, like bands with many hue
+// transitions. Very short bands are not worth their scheduling overhead
+const int BANDS_PER_THREAD = 4;
+const int MIN_ROWS_PER_BAND = 16;
+
+const int KEY_MAX_DISTANCE = 3 * 255 * 255;
+const int KEY_MAX_VALUE = 255;
+
+/// Rows of an image that are filtered by one QtConcurrent task
+struct ColorFilterBand
+{
+  const ColorFilterEngine *engine;
+  const uchar *bitsIn;
+  int bytesPerLineIn;
+  uchar *bitsOut;
+  int bytesPerLineOut;
+  bool isBitPlane; // Output is BitPlane words instead of Format_RGB32 pixels
+  int width;
+  int yStart;
+  int yStop;
+};
+
+static void filterBand (const ColorFilterBand &band)
+{
+  if (band.isBitPlane) {
+    band.engine->filterRowsToBitPlane (band.bitsIn,
+                                       band.bytesPerLineIn,
+                                       (quint32*) band.bitsOut,
+                                       band.bytesPerLineOut / sizeof (quint32),
+                                       band.width,
+                                       band.yStart,
+                                       band.yStop);
+  } else {
+    band.engine->filterRows (band.bitsIn,
+                             band.bytesPerLineIn,
+                             band.bitsOut,
+                             band.bytesPerLineOut,
+                             band.width,
+                             band.yStart,
+                             band.yStop);
+  }
+}
+
+#ifdef COLOR_FILTER_ENGINE_SSE2
+
+// Squared distances from the reference color of four pixels
+static inline __m128i keysDistanceSse2 (__m128i pixels,
+                                        __m128i reference,
+                                        __m128i channelMask)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+
+  __m128i lo = _mm_sub_epi16 (_mm_and_si128 (_mm_unpacklo_epi8 (pixels, zero), channelMask), reference);
+  __m128i hi = _mm_sub_epi16 (_mm_and_si128 (_mm_unpackhi_epi8 (pixels, zero), channelMask), reference);
+  lo = _mm_madd_epi16 (lo, lo); // Blue squared plus green squared, then red squared, for pixels 0 and 1
+  hi = _mm_madd_epi16 (hi, hi); // Same for pixels 2 and 3
+
+  __m128i even = _mm_castps_si128 (_mm_shuffle_ps (_mm_castsi128_ps (lo),
+                                                   _mm_castsi128_ps (hi),
+                                                   _MM_SHUFFLE (2, 0, 2, 0)));
+  __m128i odd = _mm_castps_si128 (_mm_shuffle_ps (_mm_castsi128_ps (lo),
+                                                  _mm_castsi128_ps (hi),
+                                                  _MM_SHUFFLE (3, 1, 3, 1)));
+  return _mm_add_epi32 (even, odd);
+}
+
+// Maximum of red, green and blue of four pixels
+static inline __m128i keysValueSse2 (__m128i pixels)
+{
+  __m128i maxChannel = _mm_max_epu8 (pixels, _mm_srli_epi32 (pixels, 8));
+  maxChannel = _mm_max_epu8 (maxChannel, _mm_srli_epi32 (pixels, 16));
+  return _mm_and_si128 (maxChannel, _mm_set1_epi32 (0xff));
+}
+
+// Returns the number of pixels processed, which is a multiple of four. The caller handles the remainder
+static int filterRowSse2 (bool isDistance,
+                          const QRgb *in,
+                          QRgb *out,
+                          int width,
+                          QRgb rgbBackground,
+                          QRgb rgbReference,
+                          int keyLow,
+                          int keyHigh,
+                          bool keyInvert)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i allOnes = _mm_set1_epi32 (-1);
+  const __m128i alphaMask = _mm_set1_epi32 ((int) ALPHA_MASK);
+  const __m128i rgbMask = _mm_set1_epi32 ((int) ~ALPHA_MASK);
+  const __m128i background = _mm_set1_epi32 ((int) rgbBackground);
+  const __m128i reference = _mm_unpacklo_epi8 (_mm_set1_epi32 ((int) (rgbReference & ~ALPHA_MASK)), zero);
+  const __m128i channelMask = _mm_set_epi16 (0, -1, -1, -1, 0, -1, -1, -1); // Drops alpha
+  const __m128i keyLowMinusOne = _mm_set1_epi32 (keyLow - 1);
+  const __m128i keyHighVector = _mm_set1_epi32 (keyHigh);
+  const __m128i invert = (keyInvert ? allOnes : zero);
+
+  int x = 0;
+  for (; x + 4 <= width; x += 4) {
+
+    __m128i pixels = _mm_loadu_si128 ((const __m128i*) (in + x));
+    __m128i keys = (isDistance ?
+                    keysDistanceSse2 (pixels, reference, channelMask) :
+                    keysValueSse2 (pixels));
+
+    __m128i inside = _mm_andnot_si128 (_mm_cmpgt_epi32 (keys, keyHighVector),
+                                       _mm_cmpgt_epi32 (keys, keyLowMinusOne));
+    __m128i isBackground = _mm_cmpeq_epi32 (_mm_or_si128 (pixels, alphaMask), background);
+    __m128i isOn = _mm_andnot_si128 (isBackground, _mm_xor_si128 (inside, invert));
+
+    _mm_storeu_si128 ((__m128i*) (out + x),
+                      _mm_xor_si128 (allOnes, _mm_and_si128 (isOn, rgbMask)));
+  }
+
+  return x;
+}
+
+#endif // COLOR_FILTER_ENGINE_SSE2
+
+#ifdef COLOR_FILTER_ENGINE_AVX2
+
+// Eight pixel version of filterRowSse2. The unpack, multiply-add and shuffle instructions work within each
+// 128 bit lane, so the keys come out in the same order as the pixels
+__attribute__((target("avx2")))
+static int filterRowAvx2 (bool isDistance,
+                          const QRgb *in,
+                          QRgb *out,
+                          int width,
+                          QRgb rgbBackground,
+                          QRgb rgbReference,
+                          int keyLow,
+                          int keyHigh,
+                          bool keyInvert)
+{
+  const __m256i zero = _mm256_setzero_si256 ();
+  const __m256i allOnes = _mm256_set1_epi32 (-1);
+  const __m256i alphaMask = _mm256_set1_epi32 ((int) ALPHA_MASK);
+  const __m256i rgbMask = _mm256_set1_epi32 ((int) ~ALPHA_MASK);
+  const __m256i byteMask = _mm256_set1_epi32 (0xff);
+  const __m256i background = _mm256_set1_epi32 ((int) rgbBackground);
+  const __m256i reference = _mm256_unpacklo_epi8 (_mm256_set1_epi32 ((int) (rgbReference & ~ALPHA_MASK)), zero);
+  const __m256i channelMask = _mm256_set_epi16 (0, -1, -1, -1, 0, -1, -1, -1,
+                                                0, -1, -1, -1, 0, -1, -1, -1);
+  const __m256i keyLowMinusOne = _mm256_set1_epi32 (keyLow - 1);
+  const __m256i keyHighVector = _mm256_set1_epi32 (keyHigh);
+  const __m256i invert = (keyInvert ? allOnes : zero);
+
+  int x = 0;
+  for (; x + 8 <= width; x += 8) {
+
+    __m256i pixels = _mm256_loadu_si256 ((const __m256i*) (in + x));
+    __m256i keys;
+    if (isDistance) {
+
+      __m256i lo = _mm256_sub_epi16 (_mm256_and_si256 (_mm256_unpacklo_epi8 (pixels, zero), channelMask), reference);
+      __m256i hi = _mm256_sub_epi16 (_mm256_and_si256 (_mm256_unpackhi_epi8 (pixels, zero), channelMask), reference);
+      lo = _mm256_madd_epi16 (lo, lo);
+      hi = _mm256_madd_epi16 (hi, hi);
+      __m256i even = _mm256_castps_si256 (_mm256_shuffle_ps (_mm256_castsi256_ps (lo),
+                                                             _mm256_castsi256_ps (hi),
+                                                             _MM_SHUFFLE (2, 0, 2, 0)));
+      __m256i odd = _mm256_castps_si256 (_mm256_shuffle_ps (_mm256_castsi256_ps (lo),
+                                                            _mm256_castsi256_ps (hi),
+                                                            _MM_SHUFFLE (3, 1, 3, 1)));
+      keys = _mm256_add_epi32 (even, odd);
+
+    } else {
+
+      __m256i maxChannel = _mm256_max_epu8 (pixels, _mm256_srli_epi32 (pixels, 8));
+      maxChannel = _mm256_max_epu8 (maxChannel, _mm256_srli_epi32 (pixels, 16));
+      keys = _mm256_and_si256 (maxChannel, byteMask);
+
+    }
+
+    __m256i inside = _mm256_andnot_si256 (_mm256_cmpgt_epi32 (keys, keyHighVector),
+                                          _mm256_cmpgt_epi32 (keys, keyLowMinusOne));
+    __m256i isBackground = _mm256_cmpeq_epi32 (_mm256_or_si256 (pixels, alphaMask), background);
+    __m256i isOn = _mm256_andnot_si256 (isBackground, _mm256_xor_si256 (inside, invert));
+
+    _mm256_storeu_si256 ((__m256i*) (out + x),
+                         _mm256_xor_si256 (allOnes, _mm256_and_si256 (isOn, rgbMask)));
+  }
+
+  return x;
+}
+
+#endif // COLOR_FILTER_ENGINE_AVX2
+
+ColorFilterEngine::ColorFilterEngine (const ColorFilterStrategyAbstractBase &strategy,
+                                      ColorFilterMode colorFilterMode,
+                                      double low0To1,
+                                      double high0To1,
+                                      QRgb rgbBackground) :
+  m_strategy (strategy),
+  m_instructionSet (bestInstructionSet ()),
+  m_low0To1 (low0To1),
+  m_high0To1 (high0To1),
+  m_rgbBackground (rgbBackground),
+  m_rgbReference (rgbBackground),
+  m_keyLow (0),
+  m_keyHigh (-1),
+  m_keyInvert (false)
+{
+  switch (colorFilterMode) {
+  case COLOR_FILTER_MODE_FOREGROUND:
+    m_kernel = KERNEL_DISTANCE;
+    loadKeyInterval (KEY_MAX_DISTANCE);
+    break;
+
+  case COLOR_FILTER_MODE_INTENSITY:
+    m_kernel = KERNEL_DISTANCE;
+    m_rgbReference = qRgb (0, 0, 0); // Intensity is the distance from black
+    loadKeyInterval (KEY_MAX_DISTANCE);
+    break;
+
+  case COLOR_FILTER_MODE_VALUE:
+    m_kernel = KERNEL_VALUE;
+    loadKeyInterval (KEY_MAX_VALUE);
+    break;
+
+  case COLOR_FILTER_MODE_SATURATION:
+    m_kernel = KERNEL_MAX_MIN_TABLE;
+    loadMaxMinTable ();
+    break;
+
+  default:
+    m_kernel = KERNEL_LOOKUP;
+    m_lookup = ColorFilterLookup::lookupFor (colorFilterMode,
+                                             rgbBackground);
+    loadBinTable ();
+    break;
+  }
+}
+
+ColorFilterEngine::InstructionSet ColorFilterEngine::bestInstructionSet ()
+{
+#ifdef COLOR_FILTER_ENGINE_AVX2
+  if (__builtin_cpu_supports ("avx2")) {
+    return INSTRUCTION_SET_AVX2;
+  }
+#endif
+
+#ifdef COLOR_FILTER_ENGINE_SSE2
+  return INSTRUCTION_SET_SSE2;
+#else
+  return INSTRUCTION_SET_SCALAR;
+#endif
+}
+
+void ColorFilterEngine::filterBands (const uchar *bitsIn,
+                                     int bytesPerLineIn,
+                                     uchar *bitsOut,
+                                     int bytesPerLineOut,
+                                     bool isBitPlane,
+                                     int width,
+                                     int height,
+                                     int threadCount) const
+{
+  int bandCount = 1;
+  if (threadCount > 1) {
+    bandCount = qMax (1, qMin (threadCount * BANDS_PER_THREAD,
+                               height / MIN_ROWS_PER_BAND));
+  }
+
+  QList<ColorFilterBand> bands;
+  for (int band = 0; band < bandCount; band++) {
+
+    ColorFilterBand colorFilterBand;
+    colorFilterBand.engine = this;
+    colorFilterBand.bitsIn = bitsIn;
+    colorFilterBand.bytesPerLineIn = bytesPerLineIn;
+    colorFilterBand.bitsOut = bitsOut;
+    colorFilterBand.bytesPerLineOut = bytesPerLineOut;
+    colorFilterBand.isBitPlane = isBitPlane;
+    colorFilterBand.width = width;
+    colorFilterBand.yStart = (band * height) / bandCount;
+    colorFilterBand.yStop = ((band + 1) * height) / bandCount;
+
+    bands << colorFilterBand;
+  }
+
+  if (bandCount == 1) {
+    filterBand (bands.first ());
+  } else {
+    QtConcurrent::blockingMap (bands,
+                               filterBand);
+  }
+}
+
+void ColorFilterEngine::filterImage (const QImage &imageOriginal,
+                                     QImage &imageFiltered,
+                                     int threadCount) const
+{
+  ENGAUGE_ASSERT (imageOriginal.width () == imageFiltered.width());
+  ENGAUGE_ASSERT (imageOriginal.height() == imageFiltered.height());
+  ENGAUGE_ASSERT (imageFiltered.format () == QImage::Format_RGB32);
+
+  QImage imageScanned = imageForScanning (imageOriginal);
+
+  // Raw pointers are obtained here, on the calling thread, so the worker threads never touch the implicitly
+  // shared QImage objects
+  filterBands (imageScanned.constBits (),
+               imageScanned.bytesPerLine (),
+               imageFiltered.bits (),
+               imageFiltered.bytesPerLine (),
+               false,
+               imageScanned.width (),
+               imageScanned.height (),
+               threadCount);
+}
+
+void ColorFilterEngine::filterImage (const QImage &imageOriginal,
+                                     BitPlane &bitPlaneFiltered,
+                                     int threadCount) const
+{
+  ENGAUGE_ASSERT (imageOriginal.width () == bitPlaneFiltered.width());
+  ENGAUGE_ASSERT (imageOriginal.height() == bitPlaneFiltered.height());
+
+  QImage imageScanned = imageForScanning (imageOriginal);
+
+  // Each band writes whole rows of words, so bands never share a word
+  filterBands (imageScanned.constBits (),
+               imageScanned.bytesPerLine (),
+               (uchar*) bitPlaneFiltered.rowForWriting (0),
+               bitPlaneFiltered.wordsPerRow () * sizeof (quint32),
+               true,
+               imageScanned.width (),
+               imageScanned.height (),
+               threadCount);
+}
+
+void ColorFilterEngine::filterRows (const uchar *bitsIn,
+                                    int bytesPerLineIn,
+                                    uchar *bitsOut,
+                                    int bytesPerLineOut,
+                                    int width,
+                                    int yStart,
+                                    int yStop) const
+{
+  bool isVectorized = (m_kernel == KERNEL_DISTANCE || m_kernel == KERNEL_VALUE);
+
+  for (int y = yStart; y < yStop; y++) {
+
+    const QRgb *in = (const QRgb*) (bitsIn + y * bytesPerLineIn);
+    QRgb *out = (QRgb*) (bitsOut + y * bytesPerLineOut);
+
+    int xStart = 0;
+    if (isVectorized) {
+
+      switch (m_instructionSet) {
+#ifdef COLOR_FILTER_ENGINE_AVX2
+      case INSTRUCTION_SET_AVX2:
+        xStart = filterRowAvx2 (m_kernel == KERNEL_DISTANCE,
+                                in,
+                                out,
+                                width,
+                                m_rgbBackground,
+                                m_rgbReference,
+                                m_keyLow,
+                                m_keyHigh,
+                                m_keyInvert);
+        break;
+#endif
+
+#ifdef COLOR_FILTER_ENGINE_SSE2
+      case INSTRUCTION_SET_SSE2:
+        xStart = filterRowSse2 (m_kernel == KERNEL_DISTANCE,
+                                in,
+                                out,
+                                width,
+                                m_rgbBackground,
+                                m_rgbReference,
+                                m_keyLow,
+                                m_keyHigh,
+                                m_keyInvert);
+        break;
+#endif
+
+      default:
+        break;
+      }
+    }
+
+    // Scalar code handles the remainder of the row, or the entire row if not vectorized
+    filterRowScalar (in,
+                     out,
+                     xStart,
+                     width);
+  }
+}
+
+void ColorFilterEngine::filterRowsToBitPlane (const uchar *bitsIn,
+                                              int bytesPerLineIn,
+                                              quint32 *wordsOut,
+                                              int wordsPerRowOut,
+                                              int width,
+                                              int yStart,
+                                              int yStop) const
+{
+  // Each row goes through the usual kernels into a one row buffer, which stays in the cache, and is then packed
+  QVector<QRgb> rowFiltered (width);
+  uchar *bitsRow = (uchar*) rowFiltered.data ();
+
+  for (int y = yStart; y < yStop; y++) {
+
+    filterRows (bitsIn + y * bytesPerLineIn,
+                0,
+                bitsRow,
+                0,
+                width,
+                0,
+                1);
+
+    quint32 *out = wordsOut + y * wordsPerRowOut;
+    for (int w = 0; w < wordsPerRowOut; w++) {
+
+      int xStart = 32 * w;
+      int xStop = qMin (xStart + 32, width);
+
+      quint32 word = 0;
+      for (int x = xStart; x < xStop; x++) {
+        word |= (quint32) (rowFiltered [x] == RGB_ON) << (x - xStart);
+      }
+
+      out [w] = word;
+    }
+  }
+}
+
+void ColorFilterEngine::filterRowScalar (const QRgb *in,
+                                         QRgb *out,
+                                         int xStart,
+                                         int width) const
+{
+  // Runs of identical pixels, which are very common, skip even the table lookup
+  QRgb rgbPrevious = RGB_OFF;
+  bool isOnPrevious = false;
+  bool isPreviousValid = false;
+
+  for (int x = xStart; x < width; x++) {
+
+    QRgb rgb = in [x] | ALPHA_MASK; // Alpha is ignored, just like QColor does
+    bool isOn = false;
+
+    if (rgb != m_rgbBackground) {
+
+      int r = qRed (rgb), g = qGreen (rgb), b = qBlue (rgb);
+
+      switch (m_kernel) {
+      case KERNEL_DISTANCE:
+        {
+          int dr = r - qRed (m_rgbReference);
+          int dg = g - qGreen (m_rgbReference);
+          int db = b - qBlue (m_rgbReference);
+          int key = dr * dr + dg * dg + db * db;
+          isOn = ((m_keyLow <= key) && (key <= m_keyHigh)) != m_keyInvert;
+        }
+        break;
+
+      case KERNEL_VALUE:
+        {
+          int key = qMax (r, qMax (g, b));
+          isOn = ((m_keyLow <= key) && (key <= m_keyHigh)) != m_keyInvert;
+        }
+        break;
+
+      case KERNEL_MAX_MIN_TABLE:
+        {
+          int maxChannel = qMax (r, qMax (g, b));
+          int minChannel = qMin (r, qMin (g, b));
+          isOn = (m_maxMinTable [(maxChannel << 8) | minChannel] != 0);
+        }
+        break;
+
+      case KERNEL_LOOKUP:
+        if (isPreviousValid && rgb == rgbPrevious) {
+          isOn = isOnPrevious;
+        } else {
+          int bin;
+          if (!m_lookup->lookup (rgb, bin)) {
+            bin = ColorFilterLookup::binOfZeroToOne (m_strategy.pixelToZeroToOne (QColor (rgb),
+                                                                                  m_rgbBackground));
+            m_lookup->store (rgb, bin);
+          }
+          isOn = (m_binTable [bin] != 0);
+          rgbPrevious = rgb;
+          isOnPrevious = isOn;
+          isPreviousValid = true;
+        }
+        break;
+      }
+    }
+
+    out [x] = (isOn ? RGB_ON : RGB_OFF);
+  }
+}
+
+int ColorFilterEngine::firstKeyPassing (double threshold,
+                                        bool inclusive,
+                                        int keyMax) const
+{
+  // Binary search for the first key whose value is at or above (inclusive) or above (exclusive) the threshold,
+  // which works since the value never decreases as the key increases. Returns keyMax + 1 if no key passes
+  int keyLow = 0, keyHigh = keyMax + 1;
+  while (keyLow < keyHigh) {
+
+    int keyMid = (keyLow + keyHigh) / 2;
+    double s = keyToZeroToOne (keyMid);
+    bool passes = (inclusive ? (s >= threshold) : (s > threshold));
+    if (passes) {
+      keyHigh = keyMid;
+    } else {
+      keyLow = keyMid + 1;
+    }
+  }
+
+  return keyLow;
+}
+
+QImage ColorFilterEngine::imageForScanning (const QImage &image)
+{
+  // Conversions are chosen so the raw 32-bit values match what QImage::pixel would return
+  switch (image.format ()) {
+  case QImage::Format_RGB32:
+  case QImage::Format_ARGB32:
+  case QImage::Format_ARGB32_Premultiplied:
+    return image;
+
+  case QImage::Format_Mono:
+  case QImage::Format_MonoLSB:
+  case QImage::Format_Indexed8:
+  case QImage::Format_RGBA8888:
+    return image.convertToFormat (QImage::Format_ARGB32);
+
+  default:
+    return image.convertToFormat (QImage::Format_ARGB32_Premultiplied);
+  }
+}
+
+ColorFilterEngine::InstructionSet ColorFilterEngine::instructionSet () const
+{
+  return m_instructionSet;
+}
+
+double ColorFilterEngine::keyToZeroToOne (int key) const
+{
+  if (m_kernel == KERNEL_DISTANCE) {
+
+    // Same expression as ColorFilterStrategyForeground and ColorFilterStrategyIntensity, whose sum of squared
+    // integer differences is computed exactly in double precision
+    return qSqrt ((double) key) / qSqrt (255.0 * 255.0 + 255.0 * 255.0 + 255.0 * 255.0);
+
+  } else {
+
+    // Value only depends on the largest channel
+    return m_strategy.pixelToZeroToOne (QColor (key, key, key),
+                                        m_rgbBackground);
+
+  }
+}
+
+void ColorFilterEngine::loadBinTable ()
+{
+  m_binTable.resize (ColorFilterLookup::NO_VALUE_BIN + 1);
+
+  for (int bin = 0; bin <= ColorFilterLookup::NO_VALUE_BIN; bin++) {
+    m_binTable [bin] = (zeroToOneIsOn (ColorFilterLookup::zeroToOneOfBin (bin), m_low0To1, m_high0To1) ? 1 : 0);
+  }
+}
+
+void ColorFilterEngine::loadKeyInterval (int keyMax)
+{
+  if (m_low0To1 <= m_high0To1) {
+
+    // Single range, so on inside low <= s <= high
+    m_keyLow = firstKeyPassing (m_low0To1, true, keyMax);
+    m_keyHigh = firstKeyPassing (m_high0To1, false, keyMax) - 1;
+    m_keyInvert = false;
+
+  } else {
+
+    // Two ranges, so off inside high < s < low
+    m_keyLow = firstKeyPassing (m_high0To1, false, keyMax);
+    m_keyHigh = firstKeyPassing (m_low0To1, true, keyMax) - 1;
+    m_keyInvert = true;
+
+  }
+}
+
+void ColorFilterEngine::loadMaxMinTable ()
+{
+  // Saturation only depends on the largest and smallest channels
+  m_maxMinTable.fill (0, 256 * 256);
+
+  for (int maxChannel = 0; maxChannel < 256; maxChannel++) {
+    for (int minChannel = 0; minChannel <= maxChannel; minChannel++) {
+
+      double s = m_strategy.pixelToZeroToOne (QColor (maxChannel, minChannel, minChannel),
+                                              m_rgbBackground);
+      m_maxMinTable [(maxChannel << 8) | minChannel] = (zeroToOneIsOn (s, m_low0To1, m_high0To1) ? 1 : 0);
+    }
+  }
+}
+
+void ColorFilterEngine::setInstructionSet (InstructionSet instructionSet)
+{
+  m_instructionSet = qMin (instructionSet,
+                           bestInstructionSet ());
+}
+
+bool ColorFilterEngine::zeroToOneIsOn (double s,
+                                       double low0To1,
+                                       double high0To1)
+{
+  bool rtn = false;
+
+  if (s >= 0.0) {
+    if (low0To1 <= high0To1) {
+
+      // Single valid range
+      rtn = (low0To1 <= s) && (s <= high0To1);
+
+    } else {
+
+      // Two ranges
+      rtn = (s <= high0To1) || (low0To1 <= s);
+
+    }
+  }
+
+  return rtn;
+}
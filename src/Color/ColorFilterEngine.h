@@ -0,0 +1,147 @@
+/******************************************************************************************************
+ * (C) 2014 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#ifndef COLOR_FILTER_ENGINE_H
+#define COLOR_FILTER_ENGINE_H
+
+#include "ColorFilterLookup.h"
+#include "ColorFilterMode.h"
+#include <QImage>
+#include <QRgb>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+class BitPlane;
+class ColorFilterStrategyAbstractBase;
+
+/// Scanline color filter engine that produces exactly the same output as applying ColorFilter::pixelUnfilteredIsOn
+/// to every pixel, but much faster. The strategy, thresholds and background are resolved once in the constructor
+/// so the inner loops run over raw 32-bit scanlines with no per-pixel QColor, QMap or virtual function overhead.
+///
+/// The foreground, intensity and value modes reduce each pixel to an integer key (squared color distance or maximum
+/// channel) that the converted value increases monotonically with, so the low/high thresholds become a key interval
+/// that is evaluated with SSE2 or AVX2 when available. Saturation uses a lookup table indexed by the maximum and
+/// minimum channels. Hue, whose conversion is the most expensive, is classified by the strategy once per distinct
+/// color and then remembered as a bin in a ColorFilterLookup that is shared with later engines having the same mode and
+/// background. The thresholds are applied to the bin with a table of the on/off state of every bin
+class ColorFilterEngine
+{
+public:
+  /// Instruction sets for the vectorized kernels. The best one supported by the cpu is selected by default
+  enum InstructionSet {
+    INSTRUCTION_SET_SCALAR,
+    INSTRUCTION_SET_SSE2,
+    INSTRUCTION_SET_AVX2
+  };
+
+  /// Single constructor. The low and high values are normalized to zero to one
+  ColorFilterEngine (const ColorFilterStrategyAbstractBase &strategy,
+                     ColorFilterMode colorFilterMode,
+                     double low0To1,
+                     double high0To1,
+                     QRgb rgbBackground);
+
+  /// Best instruction set supported by both the build and the cpu
+  static InstructionSet bestInstructionSet ();
+
+  /// Filter the entire original image into the filtered image, which must be the same size and have Format_RGB32.
+  /// With more than one thread the rows are split into bands that are filtered concurrently by the global QThreadPool.
+  /// Every output pixel depends only on the input pixel at the same position, and each band writes only its own rows,
+  /// so the bands need no overlap and leave no seams
+  void filterImage (const QImage &imageOriginal,
+                    QImage &imageFiltered,
+                    int threadCount) const;
+
+  /// Same as the other filterImage, but producing the packed filtered image directly. The bit plane must be the same
+  /// size as the original image. Bands cover whole rows so they never write to the same word
+  void filterImage (const QImage &imageOriginal,
+                    BitPlane &bitPlaneFiltered,
+                    int threadCount) const;
+
+  /// Filter rows yStart (inclusive) to yStop (exclusive) from raw 32-bit input scanlines to raw Format_RGB32 output
+  /// scanlines. In hue mode, colors seen for the first time are added to the shared ColorFilterLookup for this mode and
+  /// background. That table is filled with atomic bitwise or, and this object is otherwise unchanged, so this method
+  /// can be called concurrently on disjoint row ranges, even by engines sharing the same table
+  void filterRows (const uchar *bitsIn,
+                   int bytesPerLineIn,
+                   uchar *bitsOut,
+                   int bytesPerLineOut,
+                   int width,
+                   int yStart,
+                   int yStop) const;
+
+  /// Same as filterRows, but the output rows are BitPlane words with on pixels set. Every word of each row is
+  /// overwritten, including the padding bits which are set to zero
+  void filterRowsToBitPlane (const uchar *bitsIn,
+                             int bytesPerLineIn,
+                             quint32 *wordsOut,
+                             int wordsPerRowOut,
+                             int width,
+                             int yStart,
+                             int yStop) const;
+
+  /// Return the image itself if filterRows can read its scanlines directly, otherwise a 32-bit converted copy
+  static QImage imageForScanning (const QImage &image);
+
+  /// Instruction set currently used by the kernels
+  InstructionSet instructionSet () const;
+
+  /// Override the instruction set, which is useful for testing and benchmarking. Unsupported choices are downgraded
+  void setInstructionSet (InstructionSet instructionSet);
+
+  /// Same on/off decision as ColorFilter::pixelUnfilteredIsOn, for an already converted value
+  static bool zeroToOneIsOn (double s,
+                             double low0To1,
+                             double high0To1);
+
+private:
+  enum Kernel {
+    KERNEL_DISTANCE, // Key is squared distance from reference color
+    KERNEL_VALUE, // Key is maximum of red, green and blue
+    KERNEL_MAX_MIN_TABLE, // Table indexed by maximum and minimum of red, green and blue
+    KERNEL_LOOKUP // Strategy called once for each distinct color, with bins kept in ColorFilterLookup
+  };
+
+  void filterBands (const uchar *bitsIn,
+                    int bytesPerLineIn,
+                    uchar *bitsOut,
+                    int bytesPerLineOut,
+                    bool isBitPlane,
+                    int width,
+                    int height,
+                    int threadCount) const;
+  int firstKeyPassing (double threshold,
+                       bool inclusive,
+                       int keyMax) const;
+  double keyToZeroToOne (int key) const;
+  void loadBinTable ();
+  void loadKeyInterval (int keyMax);
+  void loadMaxMinTable ();
+  void filterRowScalar (const QRgb *in,
+                        QRgb *out,
+                        int xStart,
+                        int width) const;
+
+  const ColorFilterStrategyAbstractBase &m_strategy;
+  Kernel m_kernel;
+  InstructionSet m_instructionSet;
+  double m_low0To1;
+  double m_high0To1;
+  QRgb m_rgbBackground;
+  QRgb m_rgbReference; // Color that distances are measured from
+
+  // Key is on when it is inside [m_keyLow, m_keyHigh], XORed with m_keyInvert
+  int m_keyLow;
+  int m_keyHigh;
+  bool m_keyInvert;
+
+  QVector<uchar> m_maxMinTable;
+  QVector<uchar> m_binTable; // On/off state of each ColorFilterLookup bin
+  QSharedPointer<ColorFilterLookup> m_lookup;
+};
+
+#endif // COLOR_FILTER_ENGINE_H
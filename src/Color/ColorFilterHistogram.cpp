@@ -5,9 +5,102 @@
  ******************************************************************************************************/
 
 #include "ColorFilter.h"
+#include "ColorFilterEngine.h"
 #include "ColorFilterHistogram.h"
 #include "EngaugeAssert.h"
 #include <QImage>
+#include <QList>
+#include <QtConcurrentMap>
+#include <QThreadPool>
+
+const int BANDS_PER_THREAD = 4; // More bands than threads evens out the load when some threads start late
+const int MIN_ROWS_PER_BAND = 16;
+
+const int RECENT_COLORS = 4096; // Entries in the table of recently seen colors in each band
+const QRgb NO_COLOR = 0xffffffff; // Never matches a color, since alpha is stripped from the colors in the table
+
+/// Recently seen color, with its bin for each counted filter mode
+struct ColorFilterHistogramRecent
+{
+  QRgb rgb;
+  int bins [NUM_COLOR_FILTER_MODES];
+};
+
+/// Rows of an image that are counted by one QtConcurrent task
+struct ColorFilterHistogramBand
+{
+  const ColorFilterHistogram *histogram;
+  const ColorFilter *filter;
+  const bool *isModeCounted;
+  const uchar *bits;
+  int bytesPerLine;
+  int width;
+  int yStart;
+  int yStop;
+  QRgb rgbBackground;
+  QVector<int> counts; // Indexed by ColorFilterMode * HISTOGRAM_BINS + bin
+};
+
+static void countBand (ColorFilterHistogramBand &band)
+{
+  const int HISTOGRAM_BINS = ColorFilterHistogram::HISTOGRAM_BINS ();
+
+  band.counts.fill (0, NUM_COLOR_FILTER_MODES * HISTOGRAM_BINS);
+  int *counts = band.counts.data ();
+
+  QVector<ColorFilterHistogramRecent> recents (RECENT_COLORS);
+  for (int i = 0; i < RECENT_COLORS; i++) {
+    recents [i].rgb = NO_COLOR;
+  }
+
+  for (int y = band.yStart; y < band.yStop; y++) {
+
+    const QRgb *in = (const QRgb*) (band.bits + y * band.bytesPerLine);
+
+    for (int x = 0; x < band.width; x++) {
+
+      QRgb rgb = in [x] & RGB_MASK;
+      ColorFilterHistogramRecent &recent = recents [(rgb ^ (rgb >> 12)) & (RECENT_COLORS - 1)];
+
+      if (recent.rgb != rgb) {
+
+        // First time this color has been seen lately, so run it through the strategies
+        recent.rgb = rgb;
+        QColor pixel (rgb);
+        for (int mode = 0; mode < NUM_COLOR_FILTER_MODES; mode++) {
+          if (band.isModeCounted [mode]) {
+            recent.bins [mode] = band.histogram->binFromPixel (*band.filter,
+                                                               (ColorFilterMode) mode,
+                                                               pixel,
+                                                               band.rgbBackground);
+          }
+        }
+      }
+
+      for (int mode = 0; mode < NUM_COLOR_FILTER_MODES; mode++) {
+        if (band.isModeCounted [mode] && recent.bins [mode] >= 0) {
+          ++(counts [mode * HISTOGRAM_BINS + recent.bins [mode]]);
+        }
+      }
+    }
+  }
+}
+
+static void copyBins (const QVector<int> &counts,
+                      ColorFilterMode colorFilterMode,
+                      double histogramBins [],
+                      int &maxBinCount)
+{
+  const int HISTOGRAM_BINS = ColorFilterHistogram::HISTOGRAM_BINS ();
+
+  maxBinCount = 0;
+  for (int bin = 0; bin < HISTOGRAM_BINS; bin++) {
+    histogramBins [bin] = counts [colorFilterMode * HISTOGRAM_BINS + bin];
+    if (histogramBins [bin] > maxBinCount) {
+      maxBinCount = histogramBins [bin];
+    }
+  }
+}
 
 ColorFilterHistogram::ColorFilterHistogram()
 {
@@ -37,42 +130,108 @@ int ColorFilterHistogram::binFromPixel (const ColorFilter &filter,
   return bin;
 }
 
+void ColorFilterHistogram::countBins (const ColorFilter &filter,
+                                      const bool isModeCounted [],
+                                      const QImage &image,
+                                      QRgb rgbBackground,
+                                      QVector<int> &counts) const
+{
+  QImage imageScanned = ColorFilterEngine::imageForScanning (image);
+
+  int threadCount = QThreadPool::globalInstance()->maxThreadCount();
+  int bandCount = 1;
+  if (threadCount > 1) {
+    bandCount = qMax (1, qMin (threadCount * BANDS_PER_THREAD,
+                               imageScanned.height () / MIN_ROWS_PER_BAND));
+  }
+
+  // Raw pointers are obtained here, on the calling thread, so the worker threads never touch the implicitly
+  // shared QImage
+  QList<ColorFilterHistogramBand> bands;
+  for (int band = 0; band < bandCount; band++) {
+
+    ColorFilterHistogramBand histogramBand;
+    histogramBand.histogram = this;
+    histogramBand.filter = &filter;
+    histogramBand.isModeCounted = isModeCounted;
+    histogramBand.bits = imageScanned.constBits ();
+    histogramBand.bytesPerLine = imageScanned.bytesPerLine ();
+    histogramBand.width = imageScanned.width ();
+    histogramBand.yStart = (band * imageScanned.height ()) / bandCount;
+    histogramBand.yStop = ((band + 1) * imageScanned.height ()) / bandCount;
+    histogramBand.rgbBackground = rgbBackground;
+
+    bands << histogramBand;
+  }
+
+  if (bandCount == 1) {
+    countBand (bands.first ());
+  } else {
+    QtConcurrent::blockingMap (bands,
+                               countBand);
+  }
+
+  // Merge
+  counts.fill (0, NUM_COLOR_FILTER_MODES * HISTOGRAM_BINS ());
+  for (int band = 0; band < bandCount; band++) {
+    const QVector<int> &countsBand = bands.at (band).counts;
+    for (int i = 0; i < counts.count (); i++) {
+      counts [i] += countsBand [i];
+    }
+  }
+}
+
 void ColorFilterHistogram::generate (const ColorFilter &filter,
                                      double histogramBins [],
                                      ColorFilterMode colorFilterMode,
                                      const QImage &image,
+                                     QRgb rgbBackground,
                                      int &maxBinCount) const
 {
-  // Initialize histogram bins
-  int bin;
-  for (bin = 0; bin < HISTOGRAM_BINS (); bin++) {
-    histogramBins [bin] = 0;
+  bool isModeCounted [NUM_COLOR_FILTER_MODES];
+  for (int mode = 0; mode < NUM_COLOR_FILTER_MODES; mode++) {
+    isModeCounted [mode] = (mode == colorFilterMode);
   }
 
-  QRgb rgbBackground = filter.marginColor(&image);
+  QVector<int> counts;
+  countBins (filter,
+             isModeCounted,
+             image,
+             rgbBackground,
+             counts);
+
+  copyBins (counts,
+            colorFilterMode,
+            histogramBins,
+            maxBinCount);
+}
 
-  // Populate histogram bins
-  maxBinCount = 0;
-  for (int x = 0; x < image.width(); x++) {
-    for (int y = 0; y < image.height(); y++) {
-
-      QColor pixel (image.pixel (x, y));
-      int bin = binFromPixel (filter,
-                              colorFilterMode,
-                              pixel,
-                              rgbBackground);
-      if (bin >= 0) {
-
-        ENGAUGE_ASSERT ((FIRST_NON_EMPTY_BIN_AT_START () <= bin) &&
-                        (LAST_NON_EMPTY_BIN_AT_END () >= bin));
-        ++(histogramBins [bin]);
-
-        if (histogramBins [bin] > maxBinCount) {
-          maxBinCount = histogramBins [bin];
-        }
-      }
-    }
+void ColorFilterHistogram::generateAllModes (const ColorFilter &filter,
+                                             const QImage &image,
+                                             QRgb rgbBackground)
+{
+  bool isModeCounted [NUM_COLOR_FILTER_MODES];
+  for (int mode = 0; mode < NUM_COLOR_FILTER_MODES; mode++) {
+    isModeCounted [mode] = true;
   }
+
+  countBins (filter,
+             isModeCounted,
+             image,
+             rgbBackground,
+             m_counts);
+}
+
+void ColorFilterHistogram::histogram (ColorFilterMode colorFilterMode,
+                                      double histogramBins [],
+                                      int &maxBinCount) const
+{
+  ENGAUGE_ASSERT (m_counts.count () == NUM_COLOR_FILTER_MODES * HISTOGRAM_BINS ());
+
+  copyBins (m_counts,
+            colorFilterMode,
+            histogramBins,
+            maxBinCount);
 }
 
 int ColorFilterHistogram::valueFromBin (const ColorFilter &filter,
@@ -7,13 +7,19 @@
 #ifndef COLOR_FILTER_HISTOGRAM_H
 #define COLOR_FILTER_HISTOGRAM_H
 
+#include "ColorFilterMode.h"
 #include <QRgb>
+#include <QVector>
 
 class ColorFilter;
 class QColor;
 class QImage;
 
 /// Class that generates a histogram according to the current filter.
+///
+/// The image is scanned row by row in bands that run concurrently on the global QThreadPool, with each band counting
+/// into its own bins that are merged at the end. Since plots usually contain few distinct colors, each band also
+/// remembers the bins of recently seen colors so the filter strategies are rarely called more than once per color
 class ColorFilterHistogram
 {
 public:
@@ -29,12 +35,26 @@ public:
   /// Generate the histogram. The resolution is coarse since
   /// -# finer resolution is not needed
   /// -# this smooths out the curve
+  ///
+  /// The background color is the cached margin color of the image (see BackgroundStateContext::marginColor)
   void generate (const ColorFilter &filter,
                  double histogramBins [],
                  ColorFilterMode colorFilterMode,
                  const QImage &image,
+                 QRgb rgbBackground,
                  int &maxBinCount) const;
 
+  /// Generate the histograms of all filter modes in a single pass over the image, and keep them in this object
+  /// for later retrieval by histogram. This is much cheaper than calling generate once per mode
+  void generateAllModes (const ColorFilter &filter,
+                         const QImage &image,
+                         QRgb rgbBackground);
+
+  /// Copy the histogram of one filter mode that was computed by generateAllModes. The output is the same as generate
+  void histogram (ColorFilterMode colorFilterMode,
+                  double histogramBins [],
+                  int &maxBinCount) const;
+
   /// Number of histogram bins
   static int HISTOGRAM_BINS () { return 100; }
 
@@ -45,8 +65,17 @@ public:
 
 private:
 
+  void countBins (const ColorFilter &filter,
+                  const bool isModeCounted [],
+                  const QImage &image,
+                  QRgb rgbBackground,
+                  QVector<int> &counts) const;
+
   static int FIRST_NON_EMPTY_BIN_AT_START () { return 1; }
   static int LAST_NON_EMPTY_BIN_AT_END () { return ColorFilterHistogram::HISTOGRAM_BINS () - 2; }
+
+  // Bins from generateAllModes, indexed by ColorFilterMode * HISTOGRAM_BINS + bin
+  QVector<int> m_counts;
 };
 
 #endif // COLOR_FILTER_HISTOGRAM_H
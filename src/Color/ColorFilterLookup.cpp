@@ -0,0 +1,85 @@
+/******************************************************************************************************
+ * (C) 2014 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#include "ColorFilterLookup.h"
+#include "Logger.h"
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+
+const int COLORS_PER_WORD = 2;
+const int NUM_COLORS = 1 << 24;
+
+// The thresholds are not part of the key, so the curves of a document share one table per mode. A second table
+// covers switching between two documents, without hogging memory
+const int MAX_CACHED_LOOKUPS = 2;
+
+/// Entry in the lookup cache
+struct ColorFilterLookupEntry
+{
+  ColorFilterMode colorFilterMode;
+  QRgb rgbBackground;
+  QSharedPointer<ColorFilterLookup> lookup;
+};
+
+// Most recently used entries are at the front
+static QList<ColorFilterLookupEntry> lookupCache;
+static QMutex lookupCacheMutex;
+
+ColorFilterLookup::ColorFilterLookup () :
+  m_words (NUM_COLORS / COLORS_PER_WORD)
+{
+}
+
+int ColorFilterLookup::binOfZeroToOne (double s)
+{
+  if (s < 0) {
+    return NO_VALUE_BIN;
+  }
+
+  return qRound (s * VALUE_BINS);
+}
+
+QSharedPointer<ColorFilterLookup> ColorFilterLookup::lookupFor (ColorFilterMode colorFilterMode,
+                                                                QRgb rgbBackground)
+{
+  QMutexLocker locker (&lookupCacheMutex);
+
+  for (int i = 0; i < lookupCache.count(); i++) {
+
+    const ColorFilterLookupEntry &entry = lookupCache.at (i);
+    if (entry.colorFilterMode == colorFilterMode &&
+        entry.rgbBackground == rgbBackground) {
+
+      lookupCache.move (i, 0);
+      return lookupCache.first ().lookup;
+    }
+  }
+
+  LOG4CPP_INFO_S ((*mainCat)) << "ColorFilterLookup::lookupFor new"
+                              << " mode=" << colorFilterMode;
+
+  ColorFilterLookupEntry entry;
+  entry.colorFilterMode = colorFilterMode;
+  entry.rgbBackground = rgbBackground;
+  entry.lookup = QSharedPointer<ColorFilterLookup> (new ColorFilterLookup);
+
+  lookupCache.prepend (entry);
+  while (lookupCache.count() > MAX_CACHED_LOOKUPS) {
+    lookupCache.removeLast (); // Table is freed once no engine is using it
+  }
+
+  return entry.lookup;
+}
+
+double ColorFilterLookup::zeroToOneOfBin (int bin)
+{
+  if (bin == NO_VALUE_BIN) {
+    return -1.0;
+  }
+
+  return (double) bin / (double) VALUE_BINS;
+}
@@ -0,0 +1,72 @@
+/******************************************************************************************************
+ * (C) 2014 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#ifndef COLOR_FILTER_LOOKUP_H
+#define COLOR_FILTER_LOOKUP_H
+
+#include "ColorFilterMode.h"
+#include <QAtomicInt>
+#include <QRgb>
+#include <QSharedPointer>
+#include <QVector>
+
+/// Lookup table covering all 2^24 colors, for one combination of color filter mode and background color, holding the
+/// converted value of each color as a bin. The low and high thresholds are applied to the bin afterwards, so moving
+/// the threshold sliders keeps using the same table. Each color gets 16 bits so the table is filled in lazily, one
+/// color at a time, the first time that color is encountered. The table takes 32 megabytes.
+///
+/// Entries are only ever added, with atomic bitwise or, so multiple threads can read and fill the same table
+/// without locking. A racing thread at worst converts the same color again and stores the same bits
+class ColorFilterLookup
+{
+public:
+  /// Single constructor. All colors start out unknown
+  ColorFilterLookup ();
+
+  /// Number of bins from zero to one. Converted values must be multiples of 1 / VALUE_BINS for the bins to be exact,
+  /// which holds for hue since QColor keeps hue in hundredths of a degree
+  static const int VALUE_BINS = 36000;
+
+  /// Bin of colors that have no converted value, like achromatic colors for hue. Bins from zero to VALUE_BINS
+  /// hold the converted values
+  static const int NO_VALUE_BIN = VALUE_BINS + 1;
+
+  /// Bin of a converted value, which is NO_VALUE_BIN if the value is negative
+  static int binOfZeroToOne (double s);
+
+  /// Return the table for the specified settings from a small most-recently-used cache, creating an empty one
+  /// if there is no match. Thread safe
+  static QSharedPointer<ColorFilterLookup> lookupFor (ColorFilterMode colorFilterMode,
+                                                      QRgb rgbBackground);
+
+  /// Return true and set bin if the color has been converted, otherwise return false. Alpha is ignored
+  inline bool lookup (QRgb rgb,
+                      int &bin) const
+  {
+    unsigned int index = rgb & 0xffffff;
+    unsigned int code = ((unsigned int) m_words [index >> 1].load () >> ((index & 1) << 4)) & 0xffff;
+    bin = (int) code - 1;
+    return (code != 0);
+  }
+
+  /// Save the bin of a color. Alpha is ignored
+  inline void store (QRgb rgb,
+                     int bin)
+  {
+    unsigned int index = rgb & 0xffffff;
+    unsigned int code = (unsigned int) bin + 1;
+    m_words [index >> 1].fetchAndOrRelaxed ((int) (code << ((index & 1) << 4)));
+  }
+
+  /// Converted value of a bin, which is -1 for NO_VALUE_BIN
+  static double zeroToOneOfBin (int bin);
+
+private:
+  // Two colors per 32-bit word. Each half holds the bin plus one, or zero if the color is not known yet
+  QVector<QAtomicInt> m_words;
+};
+
+#endif // COLOR_FILTER_LOOKUP_H
@@ -6,6 +6,7 @@
 
 #include "Correlation.h"
 #include "EngaugeAssert.h"
+#include "FftwPlannerLock.h"
 #include "fftw3.h"
 #include "Logger.h"
 #include <QDebug>
@@ -20,6 +21,8 @@ Correlation::Correlation(int N) :
   m_outB ((fftw_complex *) fftw_malloc(sizeof(fftw_complex) * (2 * N - 1))),
   m_out ((fftw_complex *) fftw_malloc(sizeof(fftw_complex) * (2 * N - 1)))
 {
+  FftwPlannerLock lock;
+
   m_planA = fftw_plan_dft_1d(2 * N - 1, m_signalA, m_outA, FFTW_FORWARD, FFTW_ESTIMATE);
   m_planB = fftw_plan_dft_1d(2 * N - 1, m_signalB, m_outB, FFTW_FORWARD, FFTW_ESTIMATE);
   m_planX = fftw_plan_dft_1d(2 * N - 1, m_out, m_outShifted, FFTW_BACKWARD, FFTW_ESTIMATE);
@@ -27,6 +30,8 @@ Correlation::Correlation(int N) :
 
 Correlation::~Correlation()
 {
+  FftwPlannerLock lock;
+
   fftw_destroy_plan(m_planA);
   fftw_destroy_plan(m_planB);
   fftw_destroy_plan(m_planX);
@@ -38,7 +43,7 @@ Correlation::~Correlation()
   fftw_free(m_outA);
   fftw_free(m_outB);
 
-  fftw_cleanup();
+  // No fftw_cleanup here, since that would invalidate the plans kept by PointMatchCache
 }
 
 void Correlation::correlateWithShift (int N,
@@ -124,7 +124,8 @@ void CreateActions::createDigitize (MainWindow &mw)
   mw.m_actionDigitizeSegment->setWhatsThis (tr ("Digitize Curve Points With Segment Fill\n\n"
                                                 "Digitizes curve points by placing new points along the highlighted "
                                                 "segment under the cursor. Use this mode to quickly digitize multiple points along a "
-                                                "curve with a single click.\n\n"
+                                                "curve with a single click. Hold down the Shift key while clicking to place new points along "
+                                                "every highlighted segment at once.\n\n"
                                                 "New points will be assigned to the currently selected curve."));
   connect (mw.m_actionDigitizeSegment, SIGNAL (triggered ()), &mw, SLOT (slotDigitizeSegment ()));
 
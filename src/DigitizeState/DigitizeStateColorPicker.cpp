@@ -67,7 +67,7 @@ bool DigitizeStateColorPicker::computeFilterFromPixel (CmdMediator *cmdMediator,
   // Filter for background color now, and then later, once filter mode is set, processing of image
   ColorFilter filter;
   QImage image = cmdMediator->document().pixmap().toImage();
-  QRgb rgbBackground = filter.marginColor(&image);
+  QRgb rgbBackground = context().mainWindow().marginColor(); // Cached when image was loaded
 
   // Adjust screen position so truncation gives round-up behavior
   QPointF posScreenPlusHalf = posScreen - QPointF (0.5, 0.5);
@@ -108,6 +108,7 @@ bool DigitizeStateColorPicker::computeFilterFromPixel (CmdMediator *cmdMediator,
                               histogramBins,
                               modelColorFilterAfter.colorFilterMode (curveName),
                               image,
+                              rgbBackground,
                               maxBinCount);
 
     // Bin for pixel
@@ -4,9 +4,9 @@
  * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
  ******************************************************************************************************/
 
+#include "BitPlane.h"
 #include "CmdAddPointGraph.h"
 #include "CmdMediator.h"
-#include "ColorFilter.h"
 #include "CurveStyles.h"
 #include "DigitizeStateContext.h"
 #include "DigitizeStatePointMatch.h"
@@ -18,13 +18,13 @@
 #include "Logger.h"
 #include "MainWindow.h"
 #include "OrdinalGenerator.h"
-#include "PointMatchAlgorithm.h"
+#include "PointMatchThread.h"
 #include "PointStyle.h"
 #include <QApplication>
 #include <QCursor>
 #include <QGraphicsEllipseItem>
+#include <QGraphicsRectItem>
 #include <QGraphicsScene>
-#include <QImage>
 #include <qmath.h>
 #include <QMessageBox>
 #include <QPen>
@@ -36,12 +36,20 @@ const double Z_VALUE = 200.0;
 DigitizeStatePointMatch::DigitizeStatePointMatch (DigitizeStateContext &context) :
   DigitizeStateAbstractBase (context),
   m_outline (0),
-  m_candidatePoint (0)
+  m_regionOutline (0),
+  m_candidatePoint (0),
+  m_isPressed (false),
+  m_cmdMediator (0),
+  m_matchThread (0),
+  m_matchId (0)
 {
+  // This state lasts until the application shuts down, and is not deleted then
+  connect (qApp, SIGNAL (aboutToQuit ()), this, SLOT (slotAboutToQuit ()));
 }
 
 DigitizeStatePointMatch::~DigitizeStatePointMatch ()
 {
+  cancelMatch ();
 }
 
 QString DigitizeStatePointMatch::activeCurve () const
@@ -64,6 +72,32 @@ void DigitizeStatePointMatch::begin (CmdMediator *cmdMediator,
   m_outline->setPen (QPen (Qt::black));
   m_outline->setVisible (true);
   m_outline->setZValue (Z_VALUE);
+
+  // Add outline of the drawn rectangle, which is hidden until one is drawn
+  m_regionOutline = new QGraphicsRectItem ();
+  context().mainWindow().scene().addItem (m_regionOutline);
+  m_regionOutline->setPen (QPen (Qt::blue, 0, Qt::DashLine));
+  m_regionOutline->setVisible (false);
+  m_regionOutline->setZValue (Z_VALUE);
+}
+
+void DigitizeStatePointMatch::cancelMatch ()
+{
+  // Signals that were queued before the thread stopped are now stale
+  ++m_matchId;
+
+  if (m_matchThread != 0) {
+
+    LOG4CPP_INFO_S ((*mainCat)) << "DigitizeStatePointMatch::cancelMatch";
+
+    // FFTW planning cannot be interrupted, so waiting for the thread could freeze the gui for a long time. The
+    // thread is left to finish by itself instead, and takes the cache with it
+    m_matchThread->abandon ();
+    m_matchThread = 0;
+    m_pointMatchCache.clear ();
+
+    QApplication::restoreOverrideCursor ();
+  }
 }
 
 bool DigitizeStatePointMatch::canPaste (const Transformation &transformation,
@@ -74,6 +108,7 @@ bool DigitizeStatePointMatch::canPaste (const Transformation &transformation,
 }
 
 void DigitizeStatePointMatch::createPermanentPoint (CmdMediator *cmdMediator,
+                                                    const QString &curveName,
                                                     const QPointF &posScreen)
 {
   // Create command to add point
@@ -82,18 +117,19 @@ void DigitizeStatePointMatch::createPermanentPoint (CmdMediator *cmdMediator,
   const Transformation &transformation = context ().mainWindow ().transformation();
   QUndoCommand *cmd = new CmdAddPointGraph (context ().mainWindow(),
                                             document,
-                                            context ().mainWindow().selectedGraphCurve(),
+                                            curveName,
                                             posScreen,
                                             ordinalGenerator.generateCurvePointOrdinal(document,
                                                                                        transformation,
                                                                                        posScreen,
-                                                                                       activeCurve ()));
+                                                                                       curveName));
   context().appendNewCmd(cmdMediator,
                          cmd);
 
 }
 
 void DigitizeStatePointMatch::createTemporaryPoint (CmdMediator *cmdMediator,
+                                                    const QString &curveName,
                                                     const QPoint &posScreen)
 {
   LOG4CPP_DEBUG_S ((*mainCat)) << "DigitizeStatePointMatch::createTemporaryPoint";
@@ -102,9 +138,9 @@ void DigitizeStatePointMatch::createTemporaryPoint (CmdMediator *cmdMediator,
 
   const DocumentModelPointMatch &modelPointMatch = cmdMediator->document().modelPointMatch();
 
-  // Get point style for current graph, and then override with candidate color
+  // Get point style for the curve of the candidate, and then override with candidate color
   const CurveStyles &curveStyles = cmdMediator->document().modelCurveStyles();
-  PointStyle pointStyle = curveStyles.pointStyle (activeCurve());
+  PointStyle pointStyle = curveStyles.pointStyle (curveName);
   pointStyle.setPaletteColor (modelPointMatch.paletteColorCandidate());
 
   // Temporary point that user can see while DlgEditPoint is active
@@ -118,6 +154,7 @@ void DigitizeStatePointMatch::createTemporaryPoint (CmdMediator *cmdMediator,
   context().mainWindow().scene().addTemporaryPoint (Point::temporaryPointIdentifier(),
                                                     point);
   m_posCandidatePoint = posScreen;
+  m_curveNameCandidatePoint = curveName;
 }
 
 QCursor DigitizeStatePointMatch::cursor(CmdMediator * /* cmdMediator */) const
@@ -131,16 +168,29 @@ void DigitizeStatePointMatch::end ()
 {
   LOG4CPP_INFO_S ((*mainCat)) << "DigitizeStatePointMatch::end";
 
+  cancelMatch ();
+
   // Remove candidate point which may or may not exist at this point
   context().mainWindow().scene().removeTemporaryPointIfExists();
+  m_curveNameCandidatePoint = "";
 
   // Remove outline before leaving state
   ENGAUGE_CHECK_PTR (m_outline);
   context().mainWindow().scene().removeItem (m_outline);
   m_outline = 0;
+
+  ENGAUGE_CHECK_PTR (m_regionOutline);
+  context().mainWindow().scene().removeItem (m_regionOutline);
+  m_regionOutline = 0;
+  m_regionDrawn = QRect ();
+  m_isPressed = false;
+
+  // Release the point match arrays, which can be huge for big images, and the samples, which belong to this image
+  m_pointMatchCache.clear ();
+  m_samplesByCurve.clear ();
 }
 
-QList<PointMatchPixel> DigitizeStatePointMatch::extractSamplePointPixels (const QImage &img,
+QList<PointMatchPixel> DigitizeStatePointMatch::extractSamplePointPixels (const BitPlane &bitPlane,
                                                                           const DocumentModelPointMatch &modelPointMatch,
                                                                           const QPointF &posScreen) const
 {
@@ -153,7 +203,6 @@ QList<PointMatchPixel> DigitizeStatePointMatch::extractSamplePointPixels (const
 
   int radiusMax = modelPointMatch.maxPointSize() / 2;
 
-  ColorFilter colorFilter;
   for (int xOffset = -radiusMax; xOffset <= radiusMax; xOffset++) {
     for (int yOffset = -radiusMax; yOffset <= radiusMax; yOffset++) {
 
@@ -163,9 +212,8 @@ QList<PointMatchPixel> DigitizeStatePointMatch::extractSamplePointPixels (const
 
       if (radius <= radiusMax) {
 
-        bool pixelIsOn = colorFilter.pixelFilteredIsOn (img,
-                                                        x,
-                                                        y);
+        bool pixelIsOn = bitPlane.pixel (x,
+                                         y);
 
         PointMatchPixel point (xOffset,
                                yOffset,
@@ -196,6 +244,9 @@ void DigitizeStatePointMatch::handleContextMenuEventGraph (CmdMediator * /* cmdM
 void DigitizeStatePointMatch::handleCurveChange(CmdMediator * /* cmdMediator */)
 {
   LOG4CPP_INFO_S ((*mainCat)) << "DigitizeStatePointMatch::handleCurveChange";
+
+  // Candidates from a match that is still running would skip the points of the previous curve, not this one
+  cancelMatch ();
 }
 
 void DigitizeStatePointMatch::handleKeyPress (CmdMediator *cmdMediator,
@@ -208,6 +259,19 @@ void DigitizeStatePointMatch::handleKeyPress (CmdMediator *cmdMediator,
   // The selected key button has to be compatible with GraphicsView::keyPressEvent
   if (key == Qt::Key_Right) {
 
+    if (m_matchThread != 0) {
+
+      // There is no candidate point yet
+      context().mainWindow().showTemporaryMessage ("Point match is still running");
+      return;
+    }
+
+    if (m_curveNameCandidatePoint.isEmpty ()) {
+
+      // There is no candidate point, since no match has been run or all candidates have been used up
+      return;
+    }
+
     promoteCandidatePointToPermanentPoint (cmdMediator); // This removes the current temporary point
 
     popCandidatePoint(cmdMediator); // This creates a new temporary point
@@ -227,9 +291,9 @@ void DigitizeStatePointMatch::handleMouseMove (CmdMediator *cmdMediator,
                       modelPointMatch.maxPointSize(),
                       modelPointMatch.maxPointSize());
 
-  const QImage &img = context().mainWindow().imageFiltered();
+  const BitPlane &bitPlane = context().mainWindow().bitPlaneFiltered();
   int radiusLimit = cmdMediator->document().modelGeneral().cursorSize();
-  bool pixelShouldBeOn = pixelIsOnInImage (img,
+  bool pixelShouldBeOn = pixelIsOnInImage (bitPlane,
                                            posScreen.x(),
                                            posScreen.y(),
                                            radiusLimit);
@@ -240,12 +304,26 @@ void DigitizeStatePointMatch::handleMouseMove (CmdMediator *cmdMediator,
     QColor penColorShouldBe (pixelShouldBeOn ? Qt::green : Qt::black);
     m_outline->setPen (QPen (penColorShouldBe));
   }
+
+  // Follow the rectangle being drawn, and only show the drawn rectangle while it is being used
+  bool isRegionRectangle = (modelPointMatch.region() == POINT_MATCH_REGION_RECTANGLE);
+  if (isRegionRectangle &&
+      m_isPressed &&
+      ((posScreen - m_posPress).manhattanLength () >= QApplication::startDragDistance ())) {
+    m_regionOutline->setRect (QRectF (m_posPress, posScreen).normalized ());
+    m_regionOutline->setVisible (true);
+  } else {
+    m_regionOutline->setVisible (isRegionRectangle && !m_regionDrawn.isNull ());
+  }
 }
 
 void DigitizeStatePointMatch::handleMousePress (CmdMediator * /* cmdMediator */,
-                                                QPointF /* posScreen */)
+                                                QPointF posScreen)
 {
-  LOG4CPP_INFO_S ((*mainCat)) << "DigitizeStatePointMatch::handleMousePress";  
+  LOG4CPP_INFO_S ((*mainCat)) << "DigitizeStatePointMatch::handleMousePress";
+
+  m_isPressed = true;
+  m_posPress = posScreen;
 }
 
 void DigitizeStatePointMatch::handleMouseRelease (CmdMediator *cmdMediator,
@@ -253,7 +331,24 @@ void DigitizeStatePointMatch::handleMouseRelease (CmdMediator *cmdMediator,
 {
   LOG4CPP_INFO_S ((*mainCat)) << "DigitizeStatePointMatch::handleMouseRelease";
 
+  const DocumentModelPointMatch &modelPointMatch = cmdMediator->document().modelPointMatch();
+  bool isDrag = m_isPressed &&
+                ((posScreen - m_posPress).manhattanLength () >= QApplication::startDragDistance ());
+  m_isPressed = false;
+
+  if (isDrag && (modelPointMatch.region() == POINT_MATCH_REGION_RECTANGLE)) {
+
+    // Dragging draws the region to match, rather than picking a sample point
+    m_regionDrawn = QRectF (m_posPress, posScreen).normalized ().toRect ();
+    m_regionOutline->setRect (m_regionDrawn);
+    m_regionOutline->setVisible (true);
+
+    context().mainWindow().showTemporaryMessage ("Click on a point to match it inside the rectangle");
+    return;
+  }
+
   createPermanentPoint (cmdMediator,
+                        activeCurve (),
                         posScreen);
 
   findPointsAndShowFirstCandidate (cmdMediator,
@@ -266,9 +361,9 @@ void DigitizeStatePointMatch::findPointsAndShowFirstCandidate (CmdMediator *cmdM
   LOG4CPP_INFO_S ((*mainCat)) << "DigitizeStatePointMatch::findPointsAndShowFirstCandidate";
 
   const DocumentModelPointMatch &modelPointMatch = cmdMediator->document().modelPointMatch();
-  const QImage &img = context().mainWindow().imageFiltered();
+  const BitPlane &bitPlane = context().mainWindow().bitPlaneFiltered();
 
-  QList<PointMatchPixel> samplePointPixels = extractSamplePointPixels (img,
+  QList<PointMatchPixel> samplePointPixels = extractSamplePointPixels (bitPlane,
                                                                        modelPointMatch,
                                                                        posScreen);
 
@@ -276,28 +371,73 @@ void DigitizeStatePointMatch::findPointsAndShowFirstCandidate (CmdMediator *cmdM
   const Document &doc = cmdMediator->document();
   const Curve *curve = doc.curveForCurveName (curveName);
 
-  // The point match algorithm takes a few seconds, so set the cursor so user knows we are processing
-  QApplication::setOverrideCursor(Qt::WaitCursor);
+  // Candidates of the previous sample point no longer apply
+  cancelMatch ();
+  m_candidatePoints.clear ();
+  m_candidateCurveNames.clear ();
+  m_curveNameCandidatePoint = "";
+  context().mainWindow().scene().removeTemporaryPointIfExists();
 
-  PointMatchAlgorithm pointMatchAlgorithm (context().isGnuplot());
-  m_candidatePoints = pointMatchAlgorithm.findPoints (samplePointPixels,
-                                                      img,
-                                                      modelPointMatch,
-                                                      curve->points());
+  // The new sample replaces the previous sample of this curve. If all curves are matched, it is matched along with
+  // the samples of the other curves, and goes first so it wins ties. Existing points of all of those curves are
+  // skipped, and samples of curves that have since been removed are dropped
+  m_samplesByCurve [curveName] = samplePointPixels;
+
+  QList<QList<PointMatchPixel> > samplesPointPixels;
+  Points pointsExisting;
+  m_curveNamesMatched.clear ();
+
+  samplesPointPixels << samplePointPixels;
+  pointsExisting.append (curve->points());
+  m_curveNamesMatched << curveName;
+
+  QMap<QString, QList<PointMatchPixel> >::iterator itr = m_samplesByCurve.begin ();
+  while (modelPointMatch.matchAllCurves () &&
+         (itr != m_samplesByCurve.end ())) {
+
+    const Curve *curveOther = doc.curveForCurveName (itr.key ());
+    if (curveOther == 0) {
+      itr = m_samplesByCurve.erase (itr);
+    } else {
+      if (itr.key () != curveName) {
+        samplesPointPixels << itr.value ();
+        pointsExisting.append (curveOther->points());
+        m_curveNamesMatched << itr.key ();
+      }
+      ++itr;
+    }
+  }
 
-  QApplication::restoreOverrideCursor(); // Heavy duty processing has finished
-  context().mainWindow().showTemporaryMessage ("Right arrow adds next matched point");
+  m_cmdMediator = cmdMediator; // Save for slotPointMatchFinished
+
+  if (m_pointMatchCache.isNull ()) {
+    m_pointMatchCache = QSharedPointer<PointMatchCache> (new PointMatchCache);
+  }
 
-  popCandidatePoint (cmdMediator);
+  // The point match algorithm takes a few seconds, so it runs in the background while the cursor shows that
+  // we are processing
+  QApplication::setOverrideCursor(Qt::BusyCursor);
+
+  m_matchThread = new PointMatchThread (samplesPointPixels,
+                                        bitPlane,
+                                        modelPointMatch,
+                                        pointsExisting,
+                                        regionToMatch (cmdMediator),
+                                        context().isGnuplot(),
+                                        m_pointMatchCache,
+                                        ++m_matchId);
+  connect (m_matchThread, SIGNAL (signalPointMatchFinished (int, QList<QPoint>, QList<int>)),
+           this, SLOT (slotPointMatchFinished (int, QList<QPoint>, QList<int>)));
+  connect (m_matchThread, SIGNAL (signalPointMatchProgress (int, int)),
+           this, SLOT (slotPointMatchProgress (int, int)));
+  m_matchThread->start ();
 }
 
-bool DigitizeStatePointMatch::pixelIsOnInImage (const QImage &img,
+bool DigitizeStatePointMatch::pixelIsOnInImage (const BitPlane &bitPlane,
                                                 int x,
                                                 int y,
                                                 int radiusLimit) const
 {
-  ColorFilter filter;
-
   // Examine all nearby pixels
   bool pixelShouldBeOn = false;
   for (int xOffset = -radiusLimit; xOffset <= radiusLimit; xOffset++) {
@@ -312,12 +452,11 @@ bool DigitizeStatePointMatch::pixelIsOnInImage (const QImage &img,
 
         if ((0 <= xNearby) &&
             (0 <= yNearby) &&
-            (xNearby < img.width()) &&
-            (yNearby < img.height())) {
+            (xNearby < bitPlane.width()) &&
+            (yNearby < bitPlane.height())) {
 
-          if (filter.pixelFilteredIsOn (img,
-                                        xNearby,
-                                        yNearby)) {
+          if (bitPlane.pixel (xNearby,
+                              yNearby)) {
 
             pixelShouldBeOn = true;
             break;
@@ -338,9 +477,12 @@ void DigitizeStatePointMatch::popCandidatePoint (CmdMediator *cmdMediator)
 
     // Pop next point from list onto screen
     QPoint posScreen = m_candidatePoints.first();
+    QString curveName = m_candidateCurveNames.first();
     m_candidatePoints.pop_front ();
+    m_candidateCurveNames.pop_front ();
 
     createTemporaryPoint(cmdMediator,
+                         curveName,
                          posScreen);
 
   } else {
@@ -355,10 +497,108 @@ void DigitizeStatePointMatch::popCandidatePoint (CmdMediator *cmdMediator)
 
 void DigitizeStatePointMatch::promoteCandidatePointToPermanentPoint(CmdMediator *cmdMediator)
 {
+  // The candidate is used up whether or not it is added, so it cannot be added twice
+  QString curveName = m_curveNameCandidatePoint;
+  m_curveNameCandidatePoint = "";
+
+  if (cmdMediator->document().curveForCurveName (curveName) == 0) {
+
+    // Curve of the candidate was removed after the match
+    LOG4CPP_INFO_S ((*mainCat)) << "DigitizeStatePointMatch::promoteCandidatePointToPermanentPoint"
+                                << " skipping point of removed curve=" << curveName.toLatin1 ().data ();
+
+    context().mainWindow().scene().removeTemporaryPointIfExists();
+    return;
+  }
+
   createPermanentPoint (cmdMediator,
+                        curveName,
                         m_posCandidatePoint);
 }
 
+QRect DigitizeStatePointMatch::regionToMatch (CmdMediator *cmdMediator) const
+{
+  const DocumentModelPointMatch &modelPointMatch = cmdMediator->document().modelPointMatch();
+
+  switch (modelPointMatch.region()) {
+    case POINT_MATCH_REGION_AXES:
+      {
+        // Bounding box of the axis points, widened by half a point so the points along its edges still fit
+        Points points = cmdMediator->document().curveAxes().points();
+        if (points.count() < 2) {
+          return QRect ();
+        }
+
+        QPointF posMin = points.first().posScreen();
+        QPointF posMax = posMin;
+        for (int i = 1; i < points.count(); i++) {
+          const QPointF &pos = points.at (i).posScreen();
+          posMin.setX (qMin (posMin.x(), pos.x()));
+          posMin.setY (qMin (posMin.y(), pos.y()));
+          posMax.setX (qMax (posMax.x(), pos.x()));
+          posMax.setY (qMax (posMax.y(), pos.y()));
+        }
+
+        int margin = qCeil (modelPointMatch.maxPointSize() / 2.0);
+        return QRectF (posMin, posMax).toAlignedRect ().adjusted (-margin,
+                                                                  -margin,
+                                                                  margin,
+                                                                  margin);
+      }
+
+    case POINT_MATCH_REGION_RECTANGLE:
+      return m_regionDrawn;
+
+    default:
+      return QRect ();
+  }
+}
+
+void DigitizeStatePointMatch::slotAboutToQuit ()
+{
+  LOG4CPP_INFO_S ((*mainCat)) << "DigitizeStatePointMatch::slotAboutToQuit";
+
+  // Threads still running after the event loop stops would never be deleted, and would be using FFTW while the
+  // application exits
+  cancelMatch ();
+  PointMatchThread::waitForAbandonedThreads ();
+}
+
+void DigitizeStatePointMatch::slotPointMatchFinished (int matchId,
+                                                      QList<QPoint> candidates,
+                                                      QList<int> sampleIndexes)
+{
+  if (matchId != m_matchId) {
+
+    // Match was cancelled after these candidates were sent
+    return;
+  }
+
+  LOG4CPP_INFO_S ((*mainCat)) << "DigitizeStatePointMatch::slotPointMatchFinished"
+                              << " candidates=" << candidates.count();
+
+  // The thread has nothing left to do after sending the candidates, and deletes itself when it finishes
+  m_matchThread = 0;
+
+  QApplication::restoreOverrideCursor(); // Heavy duty processing has finished
+  context().mainWindow().showTemporaryMessage ("Right arrow adds next matched point");
+
+  m_candidatePoints = candidates;
+  m_candidateCurveNames.clear ();
+  for (int i = 0; i < sampleIndexes.count(); i++) {
+    m_candidateCurveNames << m_curveNamesMatched.at (sampleIndexes.at (i));
+  }
+  popCandidatePoint (m_cmdMediator);
+}
+
+void DigitizeStatePointMatch::slotPointMatchProgress (int matchId,
+                                                      int percent)
+{
+  if (matchId == m_matchId) {
+    context().mainWindow().showTemporaryMessage (QString ("Point match %1% done").arg (percent));
+  }
+}
+
 QString DigitizeStatePointMatch::state() const
 {
   return "DigitizeStatePointMatch";
@@ -8,18 +8,39 @@
 #define DIGITIZE_STATE_POINT_MATCH_H
 
 #include "DigitizeStateAbstractBase.h"
+#include "PointMatchCache.h"
 #include "PointMatchPixel.h"
 #include <QList>
+#include <QMap>
+#include <QObject>
 #include <QPoint>
+#include <QPointF>
+#include <QRect>
+#include <QSharedPointer>
+#include <QStringList>
 
+class BitPlane;
 class DocumentModelPointMatch;
+class PointMatchThread;
 class QGraphicsEllipseItem;
 class QGraphicsPixmapItem;
-class QImage;
+class QGraphicsRectItem;
 
-/// Digitizing state for matching Curve Points, one at a time.
-class DigitizeStatePointMatch : public DigitizeStateAbstractBase
+/// Digitizing state for matching Curve Points, one at a time. The matching runs in a PointMatchThread, so the window
+/// stays responsive on large images. Clicking again before the matching has finished cancels it and starts over with
+/// the new sample point.
+///
+/// The last sample point of each curve is remembered. Normally only the sample of the selected curve is matched. If
+/// DocumentModelPointMatch::matchAllCurves is set, all of them are matched in a single pass, and each candidate
+/// belongs to the curve whose sample matched it best, so charts with a different marker on each curve can be
+/// digitized without switching curves between candidates.
+///
+/// The matching can be restricted to the axes bounding box, or to a rectangle that is drawn by dragging the mouse,
+/// according to DocumentModelPointMatch::region
+class DigitizeStatePointMatch : public QObject, public DigitizeStateAbstractBase
 {
+  Q_OBJECT;
+
 public:
   /// Single constructor.
   DigitizeStatePointMatch(DigitizeStateContext &context);
@@ -52,33 +73,77 @@ public:
                                          const DocumentModelDigitizeCurve &modelDigitizeCurve);
   virtual void updateModelSegments(const DocumentModelSegments &modelSegments);
 
+public slots:
+  /// Cancel any match, and wait for the abandoned match threads, before the application exits
+  void slotAboutToQuit ();
+
+  /// Receive the candidate points, and the indexes of the samples they matched best, from PointMatchThread, and
+  /// show the best one. Candidates from a match that has since been replaced are ignored
+  void slotPointMatchFinished (int matchId,
+                               QList<QPoint> candidates,
+                               QList<int> sampleIndexes);
+
+  /// Receive the progress of the PointMatchThread, and show it in the status bar
+  void slotPointMatchProgress (int matchId,
+                               int percent);
+
 private:
   DigitizeStatePointMatch();
 
+  // Abandon the match thread, if there is one, without waiting for it. Signals it already sent will be ignored
+  void cancelMatch ();
+
   void createPermanentPoint (CmdMediator *cmdMediator,
+                             const QString &curveName,
                              const QPointF &posScreen);
   void createTemporaryPoint (CmdMediator *cmdMediator,
+                             const QString &curveName,
                              const QPoint &posScreen);
-  QList<PointMatchPixel> extractSamplePointPixels (const QImage &img,
+  QList<PointMatchPixel> extractSamplePointPixels (const BitPlane &bitPlane,
                                                    const DocumentModelPointMatch &modelPointMatch,
                                                    const QPointF &posScreen) const;
   void findPointsAndShowFirstCandidate (CmdMediator *cmdMediator,
                                         const QPointF &posScreen);
-  bool pixelIsOnInImage (const QImage &img,
+  bool pixelIsOnInImage (const BitPlane &bitPlane,
                          int x,
                          int y,
                          int radiusLimit) const;
   void popCandidatePoint (CmdMediator *cmdMediator);
   void promoteCandidatePointToPermanentPoint(CmdMediator *cmdMediator);
 
+  // Region of the image to match, or a null rectangle for the whole image
+  QRect regionToMatch (CmdMediator *cmdMediator) const;
+
   QGraphicsEllipseItem *m_outline;
+  QGraphicsRectItem *m_regionOutline; // Shows the drawn rectangle
   QGraphicsPixmapItem *m_candidatePoint;
 
   // Candidate points sorted from best match to worst match. Once accepted, each is removed since there
   // is now an "official" point in the Document and GraphicsScene
   QList<QPoint> m_candidatePoints;
+  QStringList m_candidateCurveNames; // Curve of each candidate point
 
   QPoint m_posCandidatePoint;
+  QString m_curveNameCandidatePoint; // Empty when there is no candidate point
+
+  // Last sample point pixels of each curve, which are matched together if DocumentModelPointMatch::matchAllCurves
+  QMap<QString, QList<PointMatchPixel> > m_samplesByCurve;
+
+  // Curve of each sample in the current match, in the order of the sample indexes sent by the match thread
+  QStringList m_curveNamesMatched;
+
+  // Rectangle drawn by dragging, for POINT_MATCH_REGION_RECTANGLE. This is null until one is drawn
+  QRect m_regionDrawn;
+  bool m_isPressed;
+  QPointF m_posPress;
+
+  // Arrays, plans and image transform kept from one match to the next while in this state. This belongs to the
+  // match thread while there is one. An abandoned match thread keeps its cache, so this is null until the next match
+  QSharedPointer<PointMatchCache> m_pointMatchCache;
+
+  CmdMediator *m_cmdMediator;
+  PointMatchThread *m_matchThread;
+  int m_matchId; // Incremented whenever a match is cancelled, so signals from earlier matches can be recognized
 };
 
 #endif // DIGITIZE_STATE_POINT_MATCH_H
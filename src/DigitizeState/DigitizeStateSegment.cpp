@@ -4,6 +4,7 @@
  * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
  ******************************************************************************************************/
 
+#include "BitPlane.h"
 #include "CmdAddPointsGraph.h"
 #include "DigitizeStateContext.h"
 #include "DigitizeStateSegment.h"
@@ -11,21 +12,26 @@
 #include "Logger.h"
 #include "MainWindow.h"
 #include "OrdinalGenerator.h"
+#include <QApplication>
 #include <QGraphicsPixmapItem>
 #include <QGraphicsScene>
-#include <QImage>
 #include <QSize>
 #include "Segment.h"
 #include "SegmentFactory.h"
+#include "SegmentScanThread.h"
 #include "Transformation.h"
 
 DigitizeStateSegment::DigitizeStateSegment (DigitizeStateContext &context) :
-  DigitizeStateAbstractBase (context)
+  DigitizeStateAbstractBase (context),
+  m_segmentHover (0),
+  m_scanThread (0),
+  m_scanId (0)
 {
 }
 
 DigitizeStateSegment::~DigitizeStateSegment ()
 {
+  cancelScan ();
 }
 
 QString DigitizeStateSegment::activeCurve () const
@@ -33,12 +39,55 @@ QString DigitizeStateSegment::activeCurve () const
   return context().mainWindow().selectedGraphCurve();
 }
 
+void DigitizeStateSegment::addPointsAlongSegments (const QList<Segment*> &segments)
+{
+  LOG4CPP_INFO_S ((*mainCat)) << "DigitizeStateSegment::addPointsAlongSegments"
+                              << " segments=" << segments.count();
+
+  // Generate point coordinates. Nothing is created in the GraphicsScene at this point
+  GraphicsScene &scene = context().mainWindow().scene();
+  SegmentFactory segmentFactory ((QGraphicsScene &) scene,
+                                 context().isGnuplot());
+
+  QList<QPoint> points = segmentFactory.fillPoints (m_cmdMediator->document().modelSegments(),
+                                                    segments);
+  if (points.isEmpty ()) {
+
+    // Nothing to add, so do not clutter the undo stack with an empty command
+    return;
+  }
+
+  // Create one ordinal for each point
+  OrdinalGenerator ordinalGenerator;
+  Document &document = m_cmdMediator->document ();
+  const Transformation &transformation = context ().mainWindow ().transformation();
+  QList<double> ordinals;
+  QList<QPoint>::iterator itr;
+  for (itr = points.begin(); itr != points.end(); itr++) {
+
+    QPoint point = *itr;
+    ordinals << ordinalGenerator.generateCurvePointOrdinal(document,
+                                                           transformation,
+                                                           point,
+                                                           activeCurve ());
+  }
+
+  // Create command to add points
+  QUndoCommand *cmd = new CmdAddPointsGraph (context ().mainWindow(),
+                                             document,
+                                             context ().mainWindow().selectedGraphCurve(),
+                                             points,
+                                             ordinals);
+  context().appendNewCmd(m_cmdMediator,
+                         cmd);
+}
+
 void DigitizeStateSegment::begin (CmdMediator *cmdMediator,
                                   DigitizeState /* previousState */)
 {
   LOG4CPP_INFO_S ((*mainCat)) << "DigitizeStateSegment::begin";
 
-  m_cmdMediator = cmdMediator; // Save for slotMouseClickOnSegment
+  m_cmdMediator = cmdMediator; // Save for slotSegmentsFinished
 
   setCursor(cmdMediator);
   context().setDragMode(QGraphicsView::NoDrag);
@@ -54,6 +103,35 @@ bool DigitizeStateSegment::canPaste (const Transformation &transformation,
                             viewSize);
 }
 
+void DigitizeStateSegment::cancelScan ()
+{
+  // Batches that were queued before the thread stopped are now stale
+  ++m_scanId;
+
+  if (m_scanThread != 0) {
+
+    LOG4CPP_INFO_S ((*mainCat)) << "DigitizeStateSegment::cancelScan";
+
+    m_scanThread->requestInterruption ();
+    m_scanThread->wait ();
+    delete m_scanThread;
+    m_scanThread = 0;
+  }
+}
+
+void DigitizeStateSegment::clearSegments ()
+{
+  // Index and highlighted segment refer to the segments, so they go first
+  m_segmentIndex.clear ();
+  m_segmentHover = 0;
+
+  GraphicsScene &scene = context().mainWindow().scene();
+  SegmentFactory segmentFactory ((QGraphicsScene &) scene,
+                                 context().isGnuplot());
+
+  segmentFactory.clearSegments (m_segments);
+}
+
 QCursor DigitizeStateSegment::cursor(CmdMediator * /* cmdMediator */) const
 {
   LOG4CPP_DEBUG_S ((*mainCat)) << "DigitizeStateSegment::cursor";
@@ -65,11 +143,8 @@ void DigitizeStateSegment::end ()
 {
   LOG4CPP_INFO_S ((*mainCat)) << "DigitizeStateSegment::end";
 
-  GraphicsScene &scene = context().mainWindow().scene();
-  SegmentFactory segmentFactory ((QGraphicsScene &) scene,
-                                 context().isGnuplot());
-
-  segmentFactory.clearSegments(m_segments);
+  cancelScan ();
+  clearSegments ();
 }
 
 void DigitizeStateSegment::handleContextMenuEventAxis (CmdMediator * /* cmdMediator */,
@@ -90,29 +165,19 @@ void DigitizeStateSegment::handleCurveChange(CmdMediator *cmdMediator)
 {
   LOG4CPP_INFO_S ((*mainCat)) << "DigitizeStateSegment::handleCurveChange";
 
-  QImage img = context().mainWindow().imageFiltered();
+  const BitPlane &bitPlane = context().mainWindow().bitPlaneFiltered();
 
-  GraphicsScene &scene = context().mainWindow().scene();
-  SegmentFactory segmentFactory ((QGraphicsScene &) scene,
-                                 context().isGnuplot());
-
-  segmentFactory.clearSegments (m_segments);
-
-  // Create new segments
-  segmentFactory.makeSegments (img,
-                               cmdMediator->document().modelSegments(),
-                               m_segments);
-
-  // Connect signals of the new segments
-  QList<Segment*>::iterator itr;
-  for (itr = m_segments.begin(); itr != m_segments.end(); itr++) {
-    Segment *segment = *itr;
-
-    LOG4CPP_INFO_S ((*mainCat)) << "DigitizeStateSegment::handleCurveChange"
-                                << " lines=" << segment->lineCount();
+  cancelScan ();
+  clearSegments ();
 
-    connect (segment, SIGNAL (signalMouseClickOnSegment (QPointF)), this, SLOT (slotMouseClickOnSegment (QPointF)));
-  }
+  // Create new segments in the background. They are indexed as they arrive in slotSegmentsFinished
+  m_scanThread = new SegmentScanThread (bitPlane,
+                                        cmdMediator->document().modelSegments(),
+                                        context().isGnuplot(),
+                                        ++m_scanId);
+  connect (m_scanThread, SIGNAL (signalSegmentsFinished (int, SegmentGeometries)),
+           this, SLOT (slotSegmentsFinished (int, SegmentGeometries)));
+  m_scanThread->start ();
 }
 
 void DigitizeStateSegment::handleKeyPress (CmdMediator * /* cmdMediator */,
@@ -123,16 +188,53 @@ void DigitizeStateSegment::handleKeyPress (CmdMediator * /* cmdMediator */,
                               << " key=" << QKeySequence (key).toString ().toLatin1 ().data ();
 }
 
-void DigitizeStateSegment::handleMouseMove (CmdMediator * /* cmdMediator */,
-                                            QPointF /* posScreen */)
+void DigitizeStateSegment::handleMouseMove (CmdMediator *cmdMediator,
+                                            QPointF posScreen)
 {
 //  LOG4CPP_DEBUG_S ((*mainCat)) << "DigitizeStateSegment::handleMouseMove";
+
+  Segment *segment = segmentUnderCursor (cmdMediator,
+                                         posScreen);
+
+  // Only the segments entering and leaving the highlight are repainted
+  if (segment != m_segmentHover) {
+
+    if (m_segmentHover != 0) {
+      m_segmentHover->slotHover (false);
+    }
+
+    m_segmentHover = segment;
+
+    if (m_segmentHover != 0) {
+      m_segmentHover->slotHover (true);
+    }
+  }
 }
 
-void DigitizeStateSegment::handleMousePress (CmdMediator * /* cmdMediator */,
-                                             QPointF /* posScreen */)
+void DigitizeStateSegment::handleMousePress (CmdMediator *cmdMediator,
+                                             QPointF posScreen)
 {
   LOG4CPP_INFO_S ((*mainCat)) << "DigitizeStateSegment::handleMousePress";
+
+  Segment *segment = segmentUnderCursor (cmdMediator,
+                                         posScreen);
+
+  if (segment != 0) {
+
+    if ((QApplication::keyboardModifiers () & Qt::ShiftModifier) != 0) {
+
+      // Fill every segment, including those from a scan that is still running since they are already visible
+      addPointsAlongSegments (m_segments);
+
+    } else {
+
+      // Create single-entry list that is expected by SegmentFactory
+      QList<Segment*> segments;
+      segments.push_back (segment);
+
+      addPointsAlongSegments (segments);
+    }
+  }
 }
 
 void DigitizeStateSegment::handleMouseRelease (CmdMediator * /* cmdMediator */,
@@ -141,67 +243,53 @@ void DigitizeStateSegment::handleMouseRelease (CmdMediator * /* cmdMediator */,
   LOG4CPP_INFO_S ((*mainCat)) << "DigitizeStateSegment::handleMouseRelease";
 }
 
-Segment *DigitizeStateSegment::segmentFromSegmentStart (const QPointF &posSegmentStart) const
+Segment *DigitizeStateSegment::segmentUnderCursor (CmdMediator *cmdMediator,
+                                                   const QPointF &posScreen) const
 {
-  LOG4CPP_INFO_S ((*mainCat)) << "DigitizeStateSegment::segmentFromSegmentStart"
-                              << " segments=" << m_segments.count();
-
-  QList<Segment*>::const_iterator itr;
-  for (itr = m_segments.begin(); itr != m_segments.end(); itr++) {
-    Segment *segment = *itr;
+  // A transparent line can be hovered over within half a pixel, and a highlighted line within half of its width
+  const double HALF_WIDTH_NOT_HIGHLIGHTED = 0.5;
 
-    if (segment->firstPoint() == posSegmentStart) {
+  double halfWidthHighlighted = qMax (1.0, cmdMediator->document().modelSegments().lineWidth()) / 2.0;
 
-      return segment;
-    }
+  if ((m_segmentHover != 0) &&
+      m_segmentIndex.segmentIsNear (m_segmentHover,
+                                    posScreen,
+                                    halfWidthHighlighted)) {
+    return m_segmentHover;
   }
 
-  LOG4CPP_ERROR_S ((*mainCat)) << "DigitizeStateSegment::segmentFromSegmentStart";
-  ENGAUGE_ASSERT (false);
-  return 0;
+  return m_segmentIndex.segmentNearest (posScreen,
+                                        HALF_WIDTH_NOT_HIGHLIGHTED);
 }
 
-void DigitizeStateSegment::slotMouseClickOnSegment(QPointF posSegmentStart)
+void DigitizeStateSegment::slotSegmentsFinished(int scanId,
+                                                SegmentGeometries geometries)
 {
-  LOG4CPP_INFO_S ((*mainCat)) << "DigitizeStateSegment::slotMouseClickOnSegment";
-
-  Segment *segment = segmentFromSegmentStart (posSegmentStart);
+  if (scanId != m_scanId) {
+    return;
+  }
 
-  // Create single-entry list that is expected by SegmentFactory
-  QList<Segment*> segments;
-  segments.push_back (segment);
+  LOG4CPP_INFO_S ((*mainCat)) << "DigitizeStateSegment::slotSegmentsFinished"
+                              << " segments=" << geometries.count();
 
-  // Generate point coordinates. Nothing is created in the GraphicsScene at this point
   GraphicsScene &scene = context().mainWindow().scene();
   SegmentFactory segmentFactory ((QGraphicsScene &) scene,
                                  context().isGnuplot());
 
-  QList<QPoint> points = segmentFactory.fillPoints (m_cmdMediator->document().modelSegments(),
-                                                    segments);
+  int foldedLines = 0;
+  SegmentGeometries::const_iterator itr;
+  for (itr = geometries.begin(); itr != geometries.end(); itr++) {
 
-  // Create one ordinal for each point
-  OrdinalGenerator ordinalGenerator;
-  Document &document = m_cmdMediator->document ();
-  const Transformation &transformation = context ().mainWindow ().transformation();
-  QList<double> ordinals;
-  QList<QPoint>::iterator itr;
-  for (itr = points.begin(); itr != points.end(); itr++) {
+    // Segments with no lines are skipped, just like SegmentFactory::makeSegments
+    if (itr->points.count() > 1) {
 
-    QPoint point = *itr;
-    ordinals << ordinalGenerator.generateCurvePointOrdinal(document,
-                                                           transformation,
-                                                           point,
-                                                           activeCurve ());
+      Segment *segment = segmentFactory.segmentFromGeometry (*itr,
+                                                             m_cmdMediator->document().modelSegments(),
+                                                             &foldedLines);
+      m_segments.push_back (segment);
+      m_segmentIndex.addSegment (segment);
+    }
   }
-
-  // Create command to add points
-  QUndoCommand *cmd = new CmdAddPointsGraph (context ().mainWindow(),
-                                             document,
-                                             context ().mainWindow().selectedGraphCurve(),
-                                             points,
-                                             ordinals);
-  context().appendNewCmd(m_cmdMediator,
-                         cmd);
 }
 
 QString DigitizeStateSegment::state() const
@@ -10,10 +10,18 @@
 #include "DigitizeStateAbstractBase.h"
 #include <QList>
 #include <QObject>
+#include "SegmentGeometry.h"
+#include "SegmentIndex.h"
 
 class Segment;
+class SegmentScanThread;
 
-/// Digitizing state for creating multiple Points along a highlighted segment.
+/// Digitizing state for creating multiple Points along a highlighted segment. The segments are found by a
+/// SegmentScanThread, and appear in batches as the scan moves across the image. Clicking on a segment with the
+/// shift key down creates Points along every segment of the active curve, in a single command.
+///
+/// The segment under the cursor is found with a SegmentIndex on each mouse move and press, and only that segment is
+/// highlighted, so hovering stays fast on images with many thousands of segments
 class DigitizeStateSegment : public QObject, public DigitizeStateAbstractBase
 {
   Q_OBJECT;
@@ -51,17 +59,36 @@ public:
   virtual void updateModelSegments(const DocumentModelSegments &modelSegments);
 
 public slots:
-  /// Receive signal from Segment that has been clicked on. The CmdMediator from the begin method will be used
-  void slotMouseClickOnSegment(QPointF);
+  /// Receive a batch of finished segments from SegmentScanThread, and create their Segments. Batches from a scan
+  /// that has since been replaced are ignored
+  void slotSegmentsFinished(int scanId,
+                            SegmentGeometries geometries);
 
 private:
   DigitizeStateSegment();
 
-  // Identify which Segment owns the SegmentLine that was clicked on
-  Segment *segmentFromSegmentStart (const QPointF &posSegmentStart) const;
+  // Create Points along the segments, using a single command so they can be undone in one step
+  void addPointsAlongSegments (const QList<Segment*> &segments);
+
+  // Stop the scan thread, if there is one, and wait for it to exit. Batches it already sent will be ignored
+  void cancelScan ();
+
+  // Remove all segments, along with their index entries and highlighting
+  void clearSegments ();
+
+  // Segment under the cursor, or null if there is none. The highlighted segment keeps the highlight while the
+  // cursor is within its drawn line width, just like the hover area of a graphics item that is drawn wider on hover
+  Segment *segmentUnderCursor (CmdMediator *cmdMediator,
+                               const QPointF &posScreen) const;
 
   QList<Segment*> m_segments;
   CmdMediator *m_cmdMediator;
+
+  SegmentIndex m_segmentIndex;
+  Segment *m_segmentHover; // Highlighted segment, or null
+
+  SegmentScanThread *m_scanThread;
+  int m_scanId; // Incremented whenever a scan is cancelled, so batches from earlier scans can be recognized
 };
 
 #endif // DIGITIZE_STATE_SEGMENT_H
@@ -13,25 +13,34 @@ DlgFilterThread::DlgFilterThread(const QPixmap &pixmapOriginal,
   m_pixmapOriginal (pixmapOriginal),
   m_rgbBackground (rgbBackground),
   m_dlgSettingsColorFilter (dlgSettingsColorFilter),
+  m_generation (0),
   m_dlgFilterWorker (0)
 {
 }
 
+void DlgFilterThread::cancelCurrentPass ()
+{
+  m_generation.ref ();
+}
+
 void DlgFilterThread::run ()
 {
   // Create worker only once
   if (m_dlgFilterWorker == 0) {
 
     m_dlgFilterWorker = new DlgFilterWorker (m_pixmapOriginal,
-                                             m_rgbBackground);
+                                             m_rgbBackground,
+                                             m_generation);
 
     // Connect signal to start process
     connect (&m_dlgSettingsColorFilter, SIGNAL (signalApplyFilter (ColorFilterMode, double, double)),
              m_dlgFilterWorker, SLOT (slotNewParameters (ColorFilterMode, double, double)));
 
-    // Connect signal to return each piece of completed processing
-    connect (m_dlgFilterWorker, SIGNAL (signalTransferPiece (int, QImage)),
-             &m_dlgSettingsColorFilter, SLOT (slotTransferPiece (int, QImage)));
+    // Connect signals to return the reduced resolution pass and then each piece of the full resolution pass
+    connect (m_dlgFilterWorker, SIGNAL (signalTransferPreview (QImage)),
+             &m_dlgSettingsColorFilter, SLOT (slotTransferPreview (QImage)));
+    connect (m_dlgFilterWorker, SIGNAL (signalTransferPiece (int, int, QImage)),
+             &m_dlgSettingsColorFilter, SLOT (slotTransferPiece (int, int, QImage)));
   }
 
   exec ();
@@ -8,6 +8,7 @@
 #define DLG_FILTER_THREAD_H
 
 #include "DlgFilterWorker.h"
+#include <QAtomicInt>
 #include <QObject>
 #include <QPixmap>
 #include <QThread>
@@ -25,14 +26,13 @@ public:
                   QRgb rgbBackground,
                   DlgSettingsColorFilter &dlgSettingsColorFilter);
 
+  /// Tell the worker to abandon its current pass as soon as possible. This is called from the gui thread just before
+  /// new parameters are sent, since the worker cannot see queued parameters until it returns to its event loop
+  void cancelCurrentPass ();
+
   /// Run this thread.
   virtual void run();
 
-signals:
-  /// Send a processed vertical piece of the original pixmap. The destination is between xLeft and xLeft+pixmap.width()
-  void signalTransferPiece (int xLeft,
-                            QImage image);
-
 private:
   DlgFilterThread();
 
@@ -41,6 +41,8 @@ private:
 
   DlgSettingsColorFilter &m_dlgSettingsColorFilter;
 
+  QAtomicInt m_generation; // Shared with the worker
+
   // Worker must be created in the run method of this thread so it belongs to this thread rather than the GUI thread that called it
   DlgFilterWorker *m_dlgFilterWorker;
 };
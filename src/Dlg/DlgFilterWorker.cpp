@@ -5,25 +5,146 @@
  ******************************************************************************************************/
 
 #include "ColorFilter.h"
+#include "ColorFilterEngine.h"
 #include "DlgFilterWorker.h"
 #include "Logger.h"
 #include <QImage>
+#include <QList>
+#include <QtConcurrentMap>
+#include <QThreadPool>
 
 const int NO_DELAY = 0;
-const int COLUMNS_PER_PIECE = 5;
+const int PREVIEW_REDUCTION = 4; // Subsampling factor in each direction for the first pass
+const int TILE_SIZE = 256; // Width and height of full resolution tiles, except at the right and bottom edges
+const int PIECES_PER_PASS = 8; // Number of full resolution strips, which limits how often the gui replaces its pixmap
+
+/// Part of a full resolution strip that is filtered by one QtConcurrent task
+struct DlgFilterTile
+{
+  const ColorFilterEngine *engine;
+  const QAtomicInt *generation;
+  int generationStarted;
+  const uchar *bitsIn;
+  int bytesPerLineIn;
+  uchar *bitsOut;
+  int bytesPerLineOut;
+  int width;
+  int height;
+};
+
+static void filterTile (const DlgFilterTile &tile)
+{
+  // Skip tiles that would be thrown away anyway
+  if (tile.generation->loadAcquire () == tile.generationStarted) {
+
+    tile.engine->filterRows (tile.bitsIn,
+                             tile.bytesPerLineIn,
+                             tile.bitsOut,
+                             tile.bytesPerLineOut,
+                             tile.width,
+                             0,
+                             tile.height);
+  }
+}
 
 DlgFilterWorker::DlgFilterWorker(const QPixmap &pixmapOriginal,
-                                 QRgb rgbBackground) :
-  m_imageOriginal (pixmapOriginal.toImage()),
+                                 QRgb rgbBackground,
+                                 const QAtomicInt &generation) :
+  m_imageOriginal (ColorFilterEngine::imageForScanning (pixmapOriginal.toImage())),
   m_rgbBackground (rgbBackground),
+  m_engine (0),
   m_colorFilterMode (NUM_COLOR_FILTER_MODES),
   m_low (-1.0),
-  m_high (-1.0)
+  m_high (-1.0),
+  m_generation (generation),
+  m_generationStarted (0),
+  m_previewIsDone (true),
+  m_yTop (0)
 {
-  m_restartTimer.setSingleShot (false);
+  // Fast transformation picks original pixels without blending, so every filtered preview pixel equals a filtered
+  // original pixel
+  m_imageReduced = ColorFilterEngine::imageForScanning (m_imageOriginal.scaled ((m_imageOriginal.width () + PREVIEW_REDUCTION - 1) / PREVIEW_REDUCTION,
+                                                                                (m_imageOriginal.height () + PREVIEW_REDUCTION - 1) / PREVIEW_REDUCTION,
+                                                                                Qt::IgnoreAspectRatio,
+                                                                                Qt::FastTransformation));
+  m_yTop = m_imageOriginal.height ();
+
+  m_restartTimer.setSingleShot (true);
   connect (&m_restartTimer, SIGNAL (timeout ()), this, SLOT (slotRestartTimeout()));
 }
 
+DlgFilterWorker::~DlgFilterWorker()
+{
+  delete m_engine;
+}
+
+bool DlgFilterWorker::isCancelled () const
+{
+  return m_generation.loadAcquire () != m_generationStarted;
+}
+
+void DlgFilterWorker::processPiece ()
+{
+  int yStop = m_yTop + TILE_SIZE * qMax (1, (m_imageOriginal.height () + TILE_SIZE * PIECES_PER_PASS - 1) / (TILE_SIZE * PIECES_PER_PASS));
+  if (yStop > m_imageOriginal.height ()) {
+    yStop = m_imageOriginal.height ();
+  }
+
+  QImage imageProcessed (m_imageOriginal.width (),
+                         yStop - m_yTop,
+                         QImage::Format_RGB32);
+
+  // Raw pointers are obtained here so the tasks never touch the implicitly shared QImage objects
+  const uchar *bitsIn = m_imageOriginal.constBits ();
+  uchar *bitsOut = imageProcessed.bits ();
+
+  QList<DlgFilterTile> tiles;
+  for (int y = m_yTop; y < yStop; y += TILE_SIZE) {
+    for (int x = 0; x < m_imageOriginal.width (); x += TILE_SIZE) {
+
+      DlgFilterTile tile;
+      tile.engine = m_engine;
+      tile.generation = &m_generation;
+      tile.generationStarted = m_generationStarted;
+      tile.bitsIn = bitsIn + y * m_imageOriginal.bytesPerLine () + x * sizeof (QRgb);
+      tile.bytesPerLineIn = m_imageOriginal.bytesPerLine ();
+      tile.bitsOut = bitsOut + (y - m_yTop) * imageProcessed.bytesPerLine () + x * sizeof (QRgb);
+      tile.bytesPerLineOut = imageProcessed.bytesPerLine ();
+      tile.width = qMin (TILE_SIZE, m_imageOriginal.width () - x);
+      tile.height = qMin (TILE_SIZE, yStop - y);
+
+      tiles << tile;
+    }
+  }
+
+  QtConcurrent::blockingMap (tiles,
+                             filterTile);
+
+  // The goal is to not tie up the gui by emitting signalTransferPiece unnecessarily
+  if (!isCancelled ()) {
+    emit signalTransferPiece (0,
+                              m_yTop,
+                              imageProcessed);
+    m_yTop = yStop;
+  }
+}
+
+void DlgFilterWorker::processPreview ()
+{
+  QImage imageProcessed (m_imageReduced.width (),
+                         m_imageReduced.height (),
+                         QImage::Format_RGB32);
+
+  m_engine->filterImage (m_imageReduced,
+                         imageProcessed,
+                         QThreadPool::globalInstance()->maxThreadCount());
+
+  if (!isCancelled ()) {
+    emit signalTransferPreview (imageProcessed);
+    m_previewIsDone = true;
+  }
+}
+
 void DlgFilterWorker::slotNewParameters (ColorFilterMode colorFilterMode,
                                          double low,
                                          double high)
@@ -52,63 +173,39 @@ void DlgFilterWorker::slotRestartTimeout ()
     DlgFilterCommand command = m_inputCommandQueue.last();
     m_inputCommandQueue.clear ();
 
-    // Start over from the left side
+    // Start over with the reduced resolution pass. Any increment of the generation after this point means
+    // newer parameters are on the way, so the passes for this command get abandoned
+    m_generationStarted = m_generation.loadAcquire ();
     m_colorFilterMode = command.colorFilterMode();
     m_low = command.low0To1();
     m_high = command.high0To1();
 
-    m_xLeft = 0;
+    delete m_engine;
+    m_engine = m_filter.createEngine (m_colorFilterMode,
+                                      m_low,
+                                      m_high,
+                                      m_rgbBackground);
+
+    m_previewIsDone = false;
+    m_yTop = 0;
 
-    // Start timer to process first piece
+    // Start timer to process reduced resolution pass
     m_restartTimer.start (NO_DELAY);
 
-  } else if (m_xLeft < m_imageOriginal.width ()) {
+  } else if (isCancelled ()) {
 
-    // To to process a new piece, starting at m_xLeft
-    int xStop = m_xLeft + COLUMNS_PER_PIECE;
-    if (xStop >= m_imageOriginal.width()) {
-      xStop = m_imageOriginal.width();
-    }
+    // Nothing more to do until the newer parameters arrive through slotNewParameters, which restarts the timer
 
-    // From  here on, if a new command gets pushed onto the queue then we immediately stop processing
-    // and do nothing except start the timer so we can start over after the next timeout. The goal is
-    // to not tie up the gui by emitting signalTransferPiece unnecessarily.
-    //
-    // This code is basically a heavily customized version of ColorFilter::filterImage
-    ColorFilter filter;
-    int processedWidth = xStop - m_xLeft;
-    QImage imageProcessed (processedWidth,
-                           m_imageOriginal.height(),
-                           QImage::Format_RGB32);
-    for (int xFrom = m_xLeft, xTo = 0; (xFrom < xStop) && (m_inputCommandQueue.count() == 0); xFrom++, xTo++) {
-      for (int y = 0; (y < m_imageOriginal.height ()) && (m_inputCommandQueue.count() == 0); y++) {
-        QColor pixel = m_imageOriginal.pixel (xFrom, y);
-        bool isOn = false;
-        if (pixel.rgb() != m_rgbBackground) {
-
-          isOn = filter.pixelUnfilteredIsOn (m_colorFilterMode,
-                                             pixel,
-                                             m_rgbBackground,
-                                             m_low,
-                                             m_high);
-        }
-
-        imageProcessed.setPixel (xTo, y, (isOn ?
-                                          QColor (Qt::black).rgb () :
-                                          QColor (Qt::white).rgb ()));
-      }
-    }
+  } else if (!m_previewIsDone) {
 
-    if (m_inputCommandQueue.count() == 0) {
-      emit signalTransferPiece (m_xLeft,
-                                imageProcessed);
-      m_xLeft += processedWidth;
-    }
+    processPreview ();
+    m_restartTimer.start (NO_DELAY);
 
-    if ((xStop < m_imageOriginal.width()) ||
-        (m_inputCommandQueue.count () > 0)) {
+  } else if (m_yTop < m_imageOriginal.height ()) {
 
-      // Restart timer to process next piece
+    // Process one full resolution strip. Returning to the event loop between strips lets queued parameters through
+    processPiece ();
+    if (m_yTop < m_imageOriginal.height ()) {
       m_restartTimer.start (NO_DELAY);
     }
   }
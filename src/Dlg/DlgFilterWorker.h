@@ -7,8 +7,10 @@
 #ifndef DLG_FILTER_WORKER_H
 #define DLG_FILTER_WORKER_H
 
+#include "ColorFilter.h"
 #include "ColorFilterMode.h"
 #include "DlgFilterCommand.h"
+#include <QAtomicInt>
 #include <QImage>
 #include <QList>
 #include <QObject>
@@ -16,9 +18,17 @@
 #include <QRgb>
 #include <QTimer>
 
+class ColorFilterEngine;
+
 typedef QList<DlgFilterCommand> FilterCommandQueue;
 
 /// Class for processing new filter settings. This is based on http://blog.debao.me/2013/08/how-to-use-qworker-in-the-right-way-part-1/
+///
+/// Each set of parameters is processed in two passes so the preview responds immediately even for very large images.
+/// The first pass filters a copy of the original image that was subsampled to 1/4 resolution in each direction, and
+/// the second pass refines the preview at full resolution, one horizontal strip at a time. Both passes are spread over
+/// all threads of the global QThreadPool, with the second pass split into square tiles. A pass is abandoned at the next
+/// tile boundary once the shared generation counter no longer matches the value from when the pass started
 class DlgFilterWorker : public QObject
 {
   Q_OBJECT;
@@ -26,7 +36,9 @@ class DlgFilterWorker : public QObject
 public:
   /// Single constructor.
   DlgFilterWorker(const QPixmap &pixmapOriginal,
-                  QRgb m_rgbBackground);
+                  QRgb m_rgbBackground,
+                  const QAtomicInt &generation);
+  virtual ~DlgFilterWorker();
 
 public slots:
   /// Start processing with a new set of parameters. Any ongoing processing is interrupted when m_filterMode changes.
@@ -38,22 +50,39 @@ private slots:
   void slotRestartTimeout ();
 
 signals:
-  /// Send a processed vertical piece of the original pixmap. The destination is between xLeft and xLeft+pixmap.width()
+  /// Send a processed piece of the original pixmap at full resolution. The destination has its top left corner at (xLeft,yTop)
   void signalTransferPiece (int xLeft,
+                            int yTop,
                             QImage image);
 
+  /// Send the entire processed image at reduced resolution, to be stretched over the whole preview until the full
+  /// resolution pieces arrive
+  void signalTransferPreview (QImage image);
+
 private:
   DlgFilterWorker();
 
-  QImage m_imageOriginal; // Use QImage rather than QPixmap so we can access pixel by pixel
+  bool isCancelled () const; // True if a newer set of parameters has been requested since processing restarted
+  void processPiece ();
+  void processPreview ();
+
+  QImage m_imageOriginal; // Use QImage rather than QPixmap so we can access the scanlines
+  QImage m_imageReduced; // Subsampled copy of m_imageOriginal for the first pass
   QRgb m_rgbBackground;
 
+  ColorFilter m_filter;
+  ColorFilterEngine *m_engine; // Recreated when processing restarts
+
   FilterCommandQueue m_inputCommandQueue;
   ColorFilterMode m_colorFilterMode; // Set when processing restarts
   double m_low;
   double m_high;
 
-  int m_xLeft;
+  const QAtomicInt &m_generation; // Incremented by the gui thread whenever new parameters are about to be sent
+  int m_generationStarted; // Value of m_generation when processing restarted
+
+  bool m_previewIsDone;
+  int m_yTop; // Top of next full resolution strip
   QTimer m_restartTimer; // Decouple slotRestartProcessing from the processing that this class performs
 };
 
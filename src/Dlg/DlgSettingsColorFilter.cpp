@@ -22,6 +22,7 @@
 #include <QImage>
 #include <QLabel>
 #include <qmath.h>
+#include <QPainter>
 #include <QPixmap>
 #include <QRadioButton>
 #include <QRgb>
@@ -40,6 +41,7 @@ DlgSettingsColorFilter::DlgSettingsColorFilter(MainWindow &mainWindow) :
   m_scenePreview (0),
   m_viewPreview (0),
   m_filterThread (0),
+  m_histogramCacheKey (0),
   m_modelColorFilterBefore (0),
   m_modelColorFilterAfter (0)
 {
@@ -197,10 +199,8 @@ QRgb DlgSettingsColorFilter::createThread ()
 {
   LOG4CPP_INFO_S ((*mainCat)) << "DlgSettingsColorFilter::createThread";
 
-  // Get background color
-  QImage image = cmdMediator().document().pixmap().toImage();
-  ColorFilter filter;
-  QRgb rgbBackground = filter.marginColor(&image);
+  // Get background color, which was computed when the image was loaded
+  QRgb rgbBackground = mainWindow().marginColor();
 
   // Only create thread once
   if (m_filterThread == 0) {
@@ -278,7 +278,7 @@ void DlgSettingsColorFilter::loadForCurveName()
     m_btnValue->setChecked (colorFilterMode == COLOR_FILTER_MODE_VALUE);
 
     m_scenePreview->clear();
-    m_imagePreview = cmdMediator().document().pixmap().toImage();
+    m_imagePreview = cmdMediator().document().pixmap().toImage().convertToFormat (QImage::Format_RGB32); // QPainter needs 32 bits
     m_scenePreview->addPixmap (QPixmap::fromImage (m_imagePreview));
 
     QRgb rgbBackground = createThread ();
@@ -358,28 +358,31 @@ void DlgSettingsColorFilter::slotSaturation ()
 }
 
 void DlgSettingsColorFilter::slotTransferPiece (int xLeft,
+                                                int yTop,
                                                 QImage image)
 {
-  // Overwrite one piece of the processed image. This approach is a bit slow because the entire QPixmap
-  // in the QGraphicsScene gets exchanged as part of each update, but that seems to be the only possible
-  // approach when using QGraphicsScene. If not fast enough or there is ugly flicker, we may replace
-  // QGraphicsScene by a simple QWidget and override the paint function - but that approach may get
-  // complicated when resizing the QGraphicsView
-  for (int xFrom = 0, xTo = xLeft; xFrom < image.width(); xFrom++, xTo++) {
-    for (int y = 0; y < image.height (); y++) {
-
-      QColor pixel = image.pixel (xFrom, y);
-      m_imagePreview.setPixel (xTo, y, pixel.rgb());
-    }
-  }
-
-  // Remove old pixmap
-  QGraphicsItem *itemPixmap = m_scenePreview->items().at(0);
-  m_scenePreview->removeItem (itemPixmap);
-  delete itemPixmap;
+  // Overwrite one piece of the processed image
+  QPainter painter (&m_imagePreview);
+  painter.setCompositionMode (QPainter::CompositionMode_Source);
+  painter.drawImage (xLeft,
+                     yTop,
+                     image);
+  painter.end ();
+
+  updatePreviewPixmap ();
+}
 
-  // Save new pixmap. Only visible change should be the area covered by the pixels in image
-  m_scenePreview->addPixmap (QPixmap::fromImage (m_imagePreview));
+void DlgSettingsColorFilter::slotTransferPreview (QImage image)
+{
+  // Overwrite the whole processed image. Without smooth transformation each reduced pixel becomes a block of
+  // identical pixels, so the preview stays black and white
+  QPainter painter (&m_imagePreview);
+  painter.setCompositionMode (QPainter::CompositionMode_Source);
+  painter.drawImage (m_imagePreview.rect (),
+                     image);
+  painter.end ();
+
+  updatePreviewPixmap ();
 }
 
 void DlgSettingsColorFilter::slotValue ()
@@ -406,19 +409,23 @@ void DlgSettingsColorFilter::updateHistogram()
 
   m_scale->setColorFilterMode (m_modelColorFilterAfter->colorFilterMode(curveName));
 
-  // Start with original image
-  QImage image = cmdMediator().document().pixmap().toImage();
+  // Scan the original image only once for all modes
+  QPixmap pixmap = cmdMediator().document().pixmap();
+  if (pixmap.cacheKey () != m_histogramCacheKey) {
+
+    ColorFilter filter;
+    m_histogram.generateAllModes (filter,
+                                  pixmap.toImage(),
+                                  mainWindow().marginColor());
+    m_histogramCacheKey = pixmap.cacheKey ();
+  }
 
   double *histogramBins = new double [ColorFilterHistogram::HISTOGRAM_BINS ()];
 
-  ColorFilter filter;
-  ColorFilterHistogram filterHistogram;
   int maxBinCount;
-  filterHistogram.generate (filter,
-                            histogramBins,
-                            m_modelColorFilterAfter->colorFilterMode (curveName),
-                            image,
-                            maxBinCount);
+  m_histogram.histogram (m_modelColorFilterAfter->colorFilterMode (curveName),
+                         histogramBins,
+                         maxBinCount);
 
   // Draw histogram, normalizing so highest peak exactly fills the vertical range. Log scale is used
   // so smaller peaks do not disappear
@@ -512,9 +519,29 @@ void DlgSettingsColorFilter::updatePreview ()
 
   enableOk (true);
 
-  // This (indirectly) updates the preview
+  // This (indirectly) updates the preview. Any pass still in progress for older parameters is abandoned first
   QString curveName = m_cmbCurveName->currentText();
+  if (m_filterThread != 0) {
+    m_filterThread->cancelCurrentPass ();
+  }
   emit signalApplyFilter (m_modelColorFilterAfter->colorFilterMode(curveName),
                           m_modelColorFilterAfter->low(curveName),
                           m_modelColorFilterAfter->high(curveName));
 }
+
+void DlgSettingsColorFilter::updatePreviewPixmap ()
+{
+  // This approach is a bit slow because the entire QPixmap in the QGraphicsScene gets exchanged as part of each
+  // update, but that seems to be the only possible approach when using QGraphicsScene. DlgFilterWorker limits the
+  // number of updates for each set of parameters to keep this affordable. If not fast enough or there is ugly flicker,
+  // we may replace QGraphicsScene by a simple QWidget and override the paint function - but that approach may get
+  // complicated when resizing the QGraphicsView
+
+  // Remove old pixmap
+  QGraphicsItem *itemPixmap = m_scenePreview->items().at(0);
+  m_scenePreview->removeItem (itemPixmap);
+  delete itemPixmap;
+
+  // Save new pixmap. Only visible change should be the area covered by the new pixels
+  m_scenePreview->addPixmap (QPixmap::fromImage (m_imagePreview));
+}
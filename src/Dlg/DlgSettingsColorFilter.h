@@ -7,6 +7,7 @@
 #ifndef DLG_SETTINGS_COLOR_FILTER_H
 #define DLG_SETTINGS_COLOR_FILTER_H
 
+#include "ColorFilterHistogram.h"
 #include "ColorFilterMode.h"
 #include "DlgSettingsAbstractBase.h"
 #include <QColor>
@@ -41,10 +42,14 @@ public:
   virtual void setSmallDialogs (bool smallDialogs);
 
 public slots:
-  /// Receive processed piece of preview image, to be inserted at xLeft to xLeft+pixmap.width().
+  /// Receive processed full resolution piece of preview image, to be inserted with its top left corner at (xLeft,yTop).
   void slotTransferPiece (int xLeft,
+                          int yTop,
                           QImage image);
 
+  /// Receive processed reduced resolution preview image, to be stretched over the entire preview image.
+  void slotTransferPreview (QImage image);
+
 signals:
   /// Send filter parameters to DlgFilterThread and DlgFilterWorker for processing.
   void signalApplyFilter (ColorFilterMode colorFilterMode,
@@ -76,6 +81,7 @@ private:
   static int PROFILE_SCENE_HEIGHT () { return 100; }
   void updateHistogram();
   void updatePreview();
+  void updatePreviewPixmap();
 
   QComboBox *m_cmbCurveName;
 
@@ -100,6 +106,11 @@ private:
 
   QImage m_imagePreview;
 
+  // Histograms of all filter modes, so switching modes does not rescan the image. They are regenerated when the
+  // document image changes, as detected by its QPixmap::cacheKey
+  ColorFilterHistogram m_histogram;
+  qint64 m_histogramCacheKey;
+
   DocumentModelColorFilter *m_modelColorFilterBefore;
   DocumentModelColorFilter *m_modelColorFilterAfter;
 };
@@ -4,6 +4,7 @@
  * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
  ******************************************************************************************************/
 
+#include "BitPlane.h"
 #include "CmdMediator.h"
 #include "CmdSettingsGridRemoval.h"
 #include "DlgSettingsGridRemoval.h"
@@ -12,13 +13,16 @@
 #include "GridRemoval.h"
 #include "Logger.h"
 #include "MainWindow.h"
+#include "Pixels.h"
 #include <QCheckBox>
+#include <QColor>
 #include <QComboBox>
 #include <QDoubleValidator>
 #include <QGraphicsScene>
 #include <QGridLayout>
 #include <QGroupBox>
 #include <QHBoxLayout>
+#include <QImage>
 #include <QLabel>
 #include <QLineEdit>
 #include <QPixmap>
@@ -594,10 +598,30 @@ void DlgSettingsGridRemoval::updatePreview ()
 {
   GridRemoval gridRemoval (mainWindow().isGnuplot());
 
-  QPixmap pixmap = gridRemoval.remove (mainWindow ().transformation(),
-                                       *m_modelGridRemovalAfter,
-                                       cmdMediator ().document().pixmap().toImage());
+  // Grid removal works on the black and white image. Every pixel on the removed grid lines then becomes white in the
+  // color image, however light the grid line was, and the pixels turned on by healing become black as before
+  QImage image = cmdMediator ().document().pixmap().toImage().convertToFormat (QImage::Format_ARGB32);
+  BitPlane bitPlaneBefore (image,
+                           PIXEL_IS_BLACK_THRESHOLD);
+  BitPlane bitPlaneRemoved;
+  BitPlane bitPlaneAfter = gridRemoval.remove (mainWindow ().transformation(),
+                                               *m_modelGridRemovalAfter,
+                                               bitPlaneBefore,
+                                               &bitPlaneRemoved);
+
+  for (int y = 0; y < image.height(); y++) {
+    for (int x = 0; x < image.width(); x++) {
+      bool isRemoved = bitPlaneRemoved.pixel (x, y);
+      if (bitPlaneAfter.pixel (x, y)) {
+        if (isRemoved || !bitPlaneBefore.pixel (x, y)) {
+          image.setPixel (x, y, QColor (Qt::black).rgb());
+        }
+      } else if (isRemoved) {
+        image.setPixel (x, y, QColor (Qt::white).rgb());
+      }
+    }
+  }
 
   m_scenePreview->clear();
-  m_scenePreview->addPixmap (pixmap);
+  m_scenePreview->addPixmap (QPixmap::fromImage (image));
 }
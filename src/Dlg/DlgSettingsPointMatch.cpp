@@ -7,9 +7,11 @@
 #include "CmdMediator.h"
 #include "CmdSettingsPointMatch.h"
 #include "DlgSettingsPointMatch.h"
+#include "DocumentModelPointMatch.h"
 #include "EngaugeAssert.h"
 #include "Logger.h"
 #include "MainWindow.h"
+#include <QCheckBox>
 #include <QComboBox>
 #include <QGraphicsEllipseItem>
 #include <QGraphicsPixmapItem>
@@ -95,6 +97,44 @@ void DlgSettingsPointMatch::createControls (QGridLayout *layout,
   connect (m_spinPointSize, SIGNAL (valueChanged (int)), this, SLOT (slotMaxPointSize (int)));
   layout->addWidget (m_spinPointSize, row++, 2);
 
+  QLabel *labelMaxCandidates = new QLabel (QString ("%1:").arg (tr ("Maximum candidate points")));
+  layout->addWidget (labelMaxCandidates, row, 1);
+
+  m_spinMaxCandidates = new QSpinBox;
+  m_spinMaxCandidates->setWhatsThis (tr ("Select the maximum number of candidate points.\n\n"
+                                         "Only this many of the best matches are kept, and offered one at a time with the "
+                                         "right arrow key. Smaller values make the matching a little faster"));
+  m_spinMaxCandidates->setMinimum (MAX_CANDIDATES_MIN);
+  m_spinMaxCandidates->setMaximum (MAX_CANDIDATES_MAX);
+  connect (m_spinMaxCandidates, SIGNAL (valueChanged (int)), this, SLOT (slotMaxCandidates (int)));
+  layout->addWidget (m_spinMaxCandidates, row++, 2);
+
+  QLabel *labelRegion = new QLabel (QString ("%1:").arg (tr ("Region to match")));
+  layout->addWidget (labelRegion, row, 1);
+
+  m_cmbRegion = new QComboBox;
+  m_cmbRegion->setWhatsThis (tr ("Select the part of the image that is searched for matching points.\n\n"
+                                 "Whole Image searches everywhere.\n\n"
+                                 "Axes Bounding Box searches only the rectangle around the axis points, which is usually "
+                                 "the plot area.\n\n"
+                                 "Drawn Rectangle searches only the rectangle that is drawn by dragging the mouse in "
+                                 "point match mode, or the whole image if no rectangle has been drawn.\n\n"
+                                 "Smaller regions take proportionally less time and memory"));
+  m_cmbRegion->addItem (tr ("Whole Image"), QVariant (POINT_MATCH_REGION_IMAGE));
+  m_cmbRegion->addItem (tr ("Axes Bounding Box"), QVariant (POINT_MATCH_REGION_AXES));
+  m_cmbRegion->addItem (tr ("Drawn Rectangle"), QVariant (POINT_MATCH_REGION_RECTANGLE));
+  connect (m_cmbRegion, SIGNAL (activated (const QString &)), this, SLOT (slotRegion (const QString &))); // activated() ignores code changes
+  layout->addWidget (m_cmbRegion, row++, 2);
+
+  m_chkMatchAllCurves = new QCheckBox (tr ("Match sample points of all curves"));
+  m_chkMatchAllCurves->setWhatsThis (tr ("Check this box to match the last sample point of every curve together, rather than "
+                                         "just the sample point of the selected curve.\n\n"
+                                         "Each candidate point is then added to the curve whose sample point it matches best, "
+                                         "which helps with charts that use a different marker on each curve.\n\n"
+                                         "Sample points are forgotten when leaving point match mode"));
+  connect (m_chkMatchAllCurves, SIGNAL (stateChanged (int)), this, SLOT (slotMatchAllCurves (int)));
+  layout->addWidget (m_chkMatchAllCurves, row++, 1, 1, 2);
+
   QLabel *labelAcceptedPointColor = new QLabel (QString ("%1:").arg (tr ("Accepted point color")));
   layout->addWidget (labelAcceptedPointColor, row, 1);
 
@@ -221,9 +261,18 @@ void DlgSettingsPointMatch::load (CmdMediator &cmdMediator)
   // Sanity checks. Incoming defaults must be acceptable to the local limits
   ENGAUGE_ASSERT (POINT_SIZE_MIN <= m_modelPointMatchAfter->maxPointSize());
   ENGAUGE_ASSERT (POINT_SIZE_MAX > m_modelPointMatchAfter->maxPointSize());
+  ENGAUGE_ASSERT (MAX_CANDIDATES_MIN <= m_modelPointMatchAfter->maxCandidates());
+  ENGAUGE_ASSERT (MAX_CANDIDATES_MAX >= m_modelPointMatchAfter->maxCandidates());
 
   // Populate controls
   m_spinPointSize->setValue(m_modelPointMatchAfter->maxPointSize());
+  m_spinMaxCandidates->setValue(m_modelPointMatchAfter->maxCandidates());
+
+  int indexRegion = m_cmbRegion->findData(QVariant(m_modelPointMatchAfter->region()));
+  ENGAUGE_ASSERT (indexRegion >= 0);
+  m_cmbRegion->setCurrentIndex(indexRegion);
+
+  m_chkMatchAllCurves->setChecked (m_modelPointMatchAfter->matchAllCurves());
 
   int indexAccepted = m_cmbAcceptedPointColor->findData(QVariant(m_modelPointMatchAfter->paletteColorAccepted()));
   ENGAUGE_ASSERT (indexAccepted >= 0);
@@ -286,6 +335,22 @@ void DlgSettingsPointMatch::slotCandidatePointColor (const QString &)
   updatePreview();
 }
 
+void DlgSettingsPointMatch::slotMatchAllCurves (int state)
+{
+  LOG4CPP_INFO_S ((*mainCat)) << "DlgSettingsPointMatch::slotMatchAllCurves";
+
+  m_modelPointMatchAfter->setMatchAllCurves(state == Qt::Checked);
+  updateControls();
+}
+
+void DlgSettingsPointMatch::slotMaxCandidates (int maxCandidates)
+{
+  LOG4CPP_INFO_S ((*mainCat)) << "DlgSettingsPointMatch::slotMaxCandidates";
+
+  m_modelPointMatchAfter->setMaxCandidates(maxCandidates);
+  updateControls();
+}
+
 void DlgSettingsPointMatch::slotMaxPointSize (int maxPointSize)
 {
   LOG4CPP_INFO_S ((*mainCat)) << "DlgSettingsPointMatch::slotMaxPointSize";
@@ -304,6 +369,14 @@ void DlgSettingsPointMatch::slotMouseMove (QPointF pos)
   m_circle->setPos (pos);
 }
 
+void DlgSettingsPointMatch::slotRegion (const QString &)
+{
+  LOG4CPP_INFO_S ((*mainCat)) << "DlgSettingsPointMatch::slotRegion";
+
+  m_modelPointMatchAfter->setRegion((PointMatchRegion) m_cmbRegion->currentData().toInt());
+  updateControls();
+}
+
 void DlgSettingsPointMatch::slotRejectedPointColor (const QString &)
 {
   LOG4CPP_INFO_S ((*mainCat)) << "DlgSettingsPointMatch::slotRejectedPointColor";
@@ -11,6 +11,7 @@
 #include "DlgSettingsAbstractBase.h"
 
 class DocumentModelPointMatch;
+class QCheckBox;
 class QComboBox;
 class QGraphicsEllipseItem;
 class QGraphicsLineItem;
@@ -38,8 +39,11 @@ public:
 private slots:
   void slotAcceptedPointColor (const QString &);
   void slotCandidatePointColor (const QString &);
+  void slotMatchAllCurves (int);
+  void slotMaxCandidates (int);
   void slotMaxPointSize (int);
   void slotMouseMove (QPointF pos);
+  void slotRegion (const QString &);
   void slotRejectedPointColor (const QString &);
 
 protected:
@@ -60,6 +64,9 @@ private:
 
   QSpinBox *m_spinMinPointSeparation;
   QSpinBox *m_spinPointSize;
+  QSpinBox *m_spinMaxCandidates;
+  QComboBox *m_cmbRegion;
+  QCheckBox *m_chkMatchAllCurves;
   QComboBox *m_cmbAcceptedPointColor;
   QComboBox *m_cmbRejectedPointColor;
   QComboBox *m_cmbCandidatePointColor;
@@ -15,41 +15,56 @@
 
 const double DEFAULT_MIN_POINT_SEPARATION = 20;
 const double DEFAULT_MAX_POINT_SIZE = 48;
+const int DEFAULT_MAX_CANDIDATES = 1000; // Far more than anyone steps through with the right arrow key
 const ColorPalette DEFAULT_COLOR_ACCEPTED = COLOR_PALETTE_GREEN;
 const ColorPalette DEFAULT_COLOR_CANDIDATE = COLOR_PALETTE_YELLOW;
 const ColorPalette DEFAULT_COLOR_REJECTED = COLOR_PALETTE_RED;
+const PointMatchRegion DEFAULT_REGION = POINT_MATCH_REGION_IMAGE;
+const bool DEFAULT_MATCH_ALL_CURVES = false;
 
 DocumentModelPointMatch::DocumentModelPointMatch() :
   m_minPointSeparation (DEFAULT_MIN_POINT_SEPARATION),
   m_maxPointSize (DEFAULT_MAX_POINT_SIZE),
+  m_maxCandidates (DEFAULT_MAX_CANDIDATES),
   m_paletteColorAccepted (DEFAULT_COLOR_ACCEPTED),
   m_paletteColorCandidate (DEFAULT_COLOR_CANDIDATE),
-  m_paletteColorRejected (DEFAULT_COLOR_REJECTED)
+  m_paletteColorRejected (DEFAULT_COLOR_REJECTED),
+  m_region (DEFAULT_REGION),
+  m_matchAllCurves (DEFAULT_MATCH_ALL_CURVES)
 {
 }
 
 DocumentModelPointMatch::DocumentModelPointMatch(const Document &document) :
   m_maxPointSize (document.modelPointMatch().maxPointSize()),
+  m_maxCandidates (document.modelPointMatch().maxCandidates()),
   m_paletteColorAccepted (document.modelPointMatch().paletteColorAccepted()),
   m_paletteColorCandidate (document.modelPointMatch().paletteColorCandidate()),
-  m_paletteColorRejected (document.modelPointMatch().paletteColorRejected())
+  m_paletteColorRejected (document.modelPointMatch().paletteColorRejected()),
+  m_region (document.modelPointMatch().region()),
+  m_matchAllCurves (document.modelPointMatch().matchAllCurves())
 {
 }
 
 DocumentModelPointMatch::DocumentModelPointMatch(const DocumentModelPointMatch &other) :
   m_maxPointSize (other.maxPointSize()),
+  m_maxCandidates (other.maxCandidates()),
   m_paletteColorAccepted (other.paletteColorAccepted()),
   m_paletteColorCandidate (other.paletteColorCandidate()),
-  m_paletteColorRejected (other.paletteColorRejected())
+  m_paletteColorRejected (other.paletteColorRejected()),
+  m_region (other.region()),
+  m_matchAllCurves (other.matchAllCurves())
 {
 }
 
 DocumentModelPointMatch &DocumentModelPointMatch::operator=(const DocumentModelPointMatch &other)
 {
   m_maxPointSize = other.maxPointSize();
+  m_maxCandidates = other.maxCandidates();
   m_paletteColorAccepted = other.paletteColorAccepted();
   m_paletteColorCandidate = other.paletteColorCandidate();
   m_paletteColorRejected = other.paletteColorRejected();
+  m_region = other.region();
+  m_matchAllCurves = other.matchAllCurves();
 
   return *this;
 }
@@ -72,6 +87,25 @@ void DocumentModelPointMatch::loadXml(QXmlStreamReader &reader)
     setPaletteColorCandidate ((ColorPalette) attributes.value(DOCUMENT_SERIALIZE_POINT_MATCH_COLOR_CANDIDATE).toInt());
     setPaletteColorRejected ((ColorPalette) attributes.value(DOCUMENT_SERIALIZE_POINT_MATCH_COLOR_REJECTED).toInt());
 
+    // Max candidates was added later, so older files keep the default. Values outside the range of the dialog, from
+    // edited files, are clamped since the matching and the dialog both require at least one candidate
+    if (attributes.hasAttribute(DOCUMENT_SERIALIZE_POINT_MATCH_MAX_CANDIDATES)) {
+      setMaxCandidates (qBound (MAX_CANDIDATES_MIN,
+                                attributes.value(DOCUMENT_SERIALIZE_POINT_MATCH_MAX_CANDIDATES).toInt(),
+                                MAX_CANDIDATES_MAX));
+    }
+
+    // Region was added later, so older files keep matching the whole image
+    if (attributes.hasAttribute(DOCUMENT_SERIALIZE_POINT_MATCH_REGION)) {
+      setRegion ((PointMatchRegion) attributes.value(DOCUMENT_SERIALIZE_POINT_MATCH_REGION).toInt());
+    }
+
+    // Matching of all curves was added later, so older files match just the selected curve
+    if (attributes.hasAttribute(DOCUMENT_SERIALIZE_POINT_MATCH_MATCH_ALL_CURVES)) {
+      QString matchAllCurvesValue = attributes.value(DOCUMENT_SERIALIZE_POINT_MATCH_MATCH_ALL_CURVES).toString();
+      setMatchAllCurves (matchAllCurvesValue == DOCUMENT_SERIALIZE_BOOL_TRUE);
+    }
+
     // Read until end of this subtree
     while ((reader.tokenType() != QXmlStreamReader::EndElement) ||
     (reader.name() != DOCUMENT_SERIALIZE_POINT_MATCH)){
@@ -88,6 +122,16 @@ void DocumentModelPointMatch::loadXml(QXmlStreamReader &reader)
   }
 }
 
+bool DocumentModelPointMatch::matchAllCurves () const
+{
+  return m_matchAllCurves;
+}
+
+int DocumentModelPointMatch::maxCandidates () const
+{
+  return m_maxCandidates;
+}
+
 double DocumentModelPointMatch::maxPointSize () const
 {
   return m_maxPointSize;
@@ -117,9 +161,17 @@ void DocumentModelPointMatch::printStream(QString indentation,
 
   str << indentation << "minPointSeparation=" << m_minPointSeparation << "\n";
   str << indentation << "maxPointSize=" << m_maxPointSize << "\n";
+  str << indentation << "maxCandidates=" << m_maxCandidates << "\n";
   str << indentation << "colorAccepted=" << colorPaletteToString (m_paletteColorAccepted) << "\n";
   str << indentation << "colorCandidate=" << colorPaletteToString (m_paletteColorCandidate) << "\n";
   str << indentation << "colorRejected=" << colorPaletteToString (m_paletteColorRejected) << "\n";
+  str << indentation << "region=" << pointMatchRegionToString (m_region) << "\n";
+  str << indentation << "matchAllCurves=" << (m_matchAllCurves ? "true" : "false") << "\n";
+}
+
+PointMatchRegion DocumentModelPointMatch::region() const
+{
+  return m_region;
 }
 
 void DocumentModelPointMatch::saveXml(QXmlStreamWriter &writer) const
@@ -128,15 +180,31 @@ void DocumentModelPointMatch::saveXml(QXmlStreamWriter &writer) const
 
   writer.writeStartElement(DOCUMENT_SERIALIZE_POINT_MATCH);
   writer.writeAttribute(DOCUMENT_SERIALIZE_POINT_MATCH_POINT_SIZE, QString::number (m_maxPointSize));
+  writer.writeAttribute(DOCUMENT_SERIALIZE_POINT_MATCH_MAX_CANDIDATES, QString::number (m_maxCandidates));
   writer.writeAttribute(DOCUMENT_SERIALIZE_POINT_MATCH_COLOR_ACCEPTED, QString::number (m_paletteColorAccepted));
   writer.writeAttribute(DOCUMENT_SERIALIZE_POINT_MATCH_COLOR_ACCEPTED_STRING, colorPaletteToString (m_paletteColorAccepted));
   writer.writeAttribute(DOCUMENT_SERIALIZE_POINT_MATCH_COLOR_CANDIDATE, QString::number (m_paletteColorCandidate));
   writer.writeAttribute(DOCUMENT_SERIALIZE_POINT_MATCH_COLOR_CANDIDATE_STRING, colorPaletteToString (m_paletteColorCandidate));
   writer.writeAttribute(DOCUMENT_SERIALIZE_POINT_MATCH_COLOR_REJECTED, QString::number (m_paletteColorRejected));
   writer.writeAttribute(DOCUMENT_SERIALIZE_POINT_MATCH_COLOR_REJECTED_STRING, colorPaletteToString (m_paletteColorRejected));
+  writer.writeAttribute(DOCUMENT_SERIALIZE_POINT_MATCH_REGION, QString::number (m_region));
+  writer.writeAttribute(DOCUMENT_SERIALIZE_POINT_MATCH_REGION_STRING, pointMatchRegionToString (m_region));
+  writer.writeAttribute(DOCUMENT_SERIALIZE_POINT_MATCH_MATCH_ALL_CURVES, m_matchAllCurves ?
+                          DOCUMENT_SERIALIZE_BOOL_TRUE :
+                          DOCUMENT_SERIALIZE_BOOL_FALSE);
   writer.writeEndElement();
 }
 
+void DocumentModelPointMatch::setMatchAllCurves(bool matchAllCurves)
+{
+  m_matchAllCurves = matchAllCurves;
+}
+
+void DocumentModelPointMatch::setMaxCandidates(int maxCandidates)
+{
+  m_maxCandidates = maxCandidates;
+}
+
 void DocumentModelPointMatch::setMaxPointSize(double maxPointSize)
 {
   m_maxPointSize = maxPointSize;
@@ -156,3 +224,8 @@ void DocumentModelPointMatch::setPaletteColorRejected(ColorPalette paletteColorR
 {
   m_paletteColorRejected = paletteColorRejected;
 }
+
+void DocumentModelPointMatch::setRegion(PointMatchRegion region)
+{
+  m_region = region;
+}
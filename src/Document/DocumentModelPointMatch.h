@@ -9,10 +9,15 @@
 
 #include "ColorPalette.h"
 #include "DocumentModelAbstractBase.h"
+#include "PointMatchRegion.h"
 
 class Document;
 class QTextStream;
 
+/// Range of max candidates, which DlgSettingsPointMatch offers and loadXml enforces
+const int MAX_CANDIDATES_MAX = 100000;
+const int MAX_CANDIDATES_MIN = 1;
+
 /// Model for DlgSettingsPointMatch and CmdSettingsPointMatch.
 class DocumentModelPointMatch : public DocumentModelAbstractBase
 {
@@ -31,6 +36,12 @@ public:
 
   virtual void loadXml(QXmlStreamReader &reader);
 
+  /// Get method for matching the last sample point of every curve, rather than just the sample of the selected curve.
+  bool matchAllCurves() const;
+
+  /// Get method for max candidates, which is the number of best matches that are kept.
+  int maxCandidates() const;
+
   /// Get method for max point size.
   double maxPointSize() const;
 
@@ -47,8 +58,17 @@ public:
   void printStream (QString indentation,
                     QTextStream &str) const;
 
+  /// Get method for the region of the image that is matched.
+  PointMatchRegion region() const;
+
   virtual void saveXml(QXmlStreamWriter &writer) const;
 
+  /// Set method for matching the last sample point of every curve.
+  void setMatchAllCurves (bool matchAllCurves);
+
+  /// Set method for max candidates.
+  void setMaxCandidates (int maxCandidates);
+
   /// Set method for max point size.
   void setMaxPointSize (double maxPointSize);
 
@@ -61,13 +81,19 @@ public:
   /// Set method for rejected color.
   void setPaletteColorRejected(ColorPalette paletteColorRejected);
 
+  /// Set method for the region of the image that is matched.
+  void setRegion(PointMatchRegion region);
+
 private:
 
   double m_minPointSeparation;
   double m_maxPointSize;
+  int m_maxCandidates;
   ColorPalette m_paletteColorAccepted;
   ColorPalette m_paletteColorCandidate;
   ColorPalette m_paletteColorRejected;
+  PointMatchRegion m_region;
+  bool m_matchAllCurves;
 };
 
 #endif // DOCUMENT_MODEL_POINT_MATCH_H
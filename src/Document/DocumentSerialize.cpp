@@ -203,6 +203,10 @@ const QString DOCUMENT_SERIALIZE_POINT_IS_AXIS_POINT ("IsAxisPoint");
 const QString DOCUMENT_SERIALIZE_POINT_IS_X_ONLY ("IsXOnly");
 const QString DOCUMENT_SERIALIZE_POINT_MATCH ("PointMatch");
 const QString DOCUMENT_SERIALIZE_POINT_MATCH_POINT_SIZE ("PointSize");
+const QString DOCUMENT_SERIALIZE_POINT_MATCH_MAX_CANDIDATES ("MaxCandidates");
+const QString DOCUMENT_SERIALIZE_POINT_MATCH_REGION ("Region");
+const QString DOCUMENT_SERIALIZE_POINT_MATCH_REGION_STRING ("RegionString");
+const QString DOCUMENT_SERIALIZE_POINT_MATCH_MATCH_ALL_CURVES ("MatchAllCurves");
 const QString DOCUMENT_SERIALIZE_POINT_MATCH_COLOR_ACCEPTED ("ColorAccepted");
 const QString DOCUMENT_SERIALIZE_POINT_MATCH_COLOR_ACCEPTED_STRING ("ColorAcceptedString");
 const QString DOCUMENT_SERIALIZE_POINT_MATCH_COLOR_CANDIDATE ("ColorCandidate");
@@ -205,6 +205,10 @@ extern const QString DOCUMENT_SERIALIZE_POINT_IS_AXIS_POINT;
 extern const QString DOCUMENT_SERIALIZE_POINT_IS_X_ONLY;
 extern const QString DOCUMENT_SERIALIZE_POINT_MATCH;
 extern const QString DOCUMENT_SERIALIZE_POINT_MATCH_POINT_SIZE;
+extern const QString DOCUMENT_SERIALIZE_POINT_MATCH_MAX_CANDIDATES;
+extern const QString DOCUMENT_SERIALIZE_POINT_MATCH_REGION;
+extern const QString DOCUMENT_SERIALIZE_POINT_MATCH_REGION_STRING;
+extern const QString DOCUMENT_SERIALIZE_POINT_MATCH_MATCH_ALL_CURVES;
 extern const QString DOCUMENT_SERIALIZE_POINT_MATCH_COLOR_ACCEPTED;
 extern const QString DOCUMENT_SERIALIZE_POINT_MATCH_COLOR_ACCEPTED_STRING;
 extern const QString DOCUMENT_SERIALIZE_POINT_MATCH_COLOR_CANDIDATE;
@@ -4,6 +4,7 @@
  * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
  ******************************************************************************************************/
 
+#include "BitPlane.h"
 #include "ColorFilter.h"
 #include "DocumentModelColorFilter.h"
 #include "DocumentModelGridRemoval.h"
@@ -11,39 +12,57 @@
 #include "GridRemoval.h"
 #include "Logger.h"
 #include <QImage>
-#include <QPixmap>
+#include <QThreadPool>
 #include "Transformation.h"
 
 FilterImage::FilterImage ()
 {
 }
 
-QPixmap FilterImage::filter (bool isGnuplot,
-                             const QImage &imageUnfiltered,
-                             const Transformation &transformation,
-                             const QString &curveSelected,
-                             const DocumentModelColorFilter &modelColorFilter,
-                             const DocumentModelGridRemoval &modelGridRemoval) const
+BitPlane FilterImage::filter (bool isGnuplot,
+                              const QImage &imageUnfiltered,
+                              QRgb rgbBackground,
+                              const Transformation &transformation,
+                              const QString &curveSelected,
+                              const DocumentModelColorFilter &modelColorFilter,
+                              const DocumentModelGridRemoval &modelGridRemoval) const
 {
-  // Filtered image
+  return removeGrid (isGnuplot,
+                     transformation,
+                     modelGridRemoval,
+                     filterColor (imageUnfiltered,
+                                  rgbBackground,
+                                  curveSelected,
+                                  modelColorFilter));
+}
+
+BitPlane FilterImage::filterColor (const QImage &imageUnfiltered,
+                                   QRgb rgbBackground,
+                                   const QString &curveSelected,
+                                   const DocumentModelColorFilter &modelColorFilter) const
+{
+  // Filtered image, produced directly in packed form
   ColorFilter filter;
-  QImage imageFiltered (imageUnfiltered.width (),
-                        imageUnfiltered.height (),
-                        QImage::Format_RGB32);
-  QRgb rgbBackground = filter.marginColor (&imageUnfiltered);
+  BitPlane bitPlaneFiltered (imageUnfiltered.width (),
+                             imageUnfiltered.height ());
   filter.filterImage (imageUnfiltered,
-                      imageFiltered,
+                      bitPlaneFiltered,
                       modelColorFilter.colorFilterMode(curveSelected),
                       modelColorFilter.low(curveSelected),
                       modelColorFilter.high(curveSelected),
-                      rgbBackground);
-  
-  GridRemoval gridRemoval (isGnuplot);
-  QPixmap pixmapFiltered = gridRemoval.remove (transformation,
-                                               modelGridRemoval,
-                                               imageFiltered);
+                      rgbBackground,
+                      QThreadPool::globalInstance()->maxThreadCount());
 
-  return pixmapFiltered;
+  return bitPlaneFiltered;
 }
 
-
+BitPlane FilterImage::removeGrid (bool isGnuplot,
+                                  const Transformation &transformation,
+                                  const DocumentModelGridRemoval &modelGridRemoval,
+                                  const BitPlane &bitPlaneColorFiltered) const
+{
+  GridRemoval gridRemoval (isGnuplot);
+  return gridRemoval.remove (transformation,
+                             modelGridRemoval,
+                             bitPlaneColorFiltered);
+}
@@ -7,7 +7,8 @@
 #ifndef FILTER_IMAGE_H
 #define FILTER_IMAGE_H
 
-#include <QPixmap>
+#include "BitPlane.h"
+#include <QRgb>
 
 class DocumentModelColorFilter;
 class DocumentModelGridRemoval;
@@ -21,13 +22,28 @@ class FilterImage
   /// Single constructor
   FilterImage();
 
-  /// Filter original unfiltered image into filtered pixmap
-  QPixmap filter (bool isGnuplot,
-                  const QImage &imageUnfiltered,
-                  const Transformation &transformation,
-                  const QString &curveSelected,
-                  const DocumentModelColorFilter &modelColorFilter,
-                  const DocumentModelGridRemoval &modelGridRemoval) const;
+  /// Filter original unfiltered image, whose margin color is rgbBackground, into a packed filtered image. The color
+  /// filter stage runs on all threads of the global QThreadPool
+  BitPlane filter (bool isGnuplot,
+                   const QImage &imageUnfiltered,
+                   QRgb rgbBackground,
+                   const Transformation &transformation,
+                   const QString &curveSelected,
+                   const DocumentModelColorFilter &modelColorFilter,
+                   const DocumentModelGridRemoval &modelGridRemoval) const;
+
+  /// First stage of filter, which is color filtering only. Callers may keep its result and rerun just removeGrid when
+  /// only the grid removal settings or transformation change
+  BitPlane filterColor (const QImage &imageUnfiltered,
+                        QRgb rgbBackground,
+                        const QString &curveSelected,
+                        const DocumentModelColorFilter &modelColorFilter) const;
+
+  /// Second stage of filter, which is grid removal applied to the output of filterColor
+  BitPlane removeGrid (bool isGnuplot,
+                       const Transformation &transformation,
+                       const DocumentModelGridRemoval &modelGridRemoval,
+                       const BitPlane &bitPlaneColorFiltered) const;
 };
 
 #endif // FILTER_IMAGE_H
@@ -6,6 +6,7 @@
 
 #include "DataKey.h"
 #include "Ghosts.h"
+#include "GraphicsItemType.h"
 #include <qdebug.h>
 #include <QGraphicsItem>
 #include <QGraphicsPathItem>
@@ -45,10 +46,14 @@ void Ghosts::captureGraphicsItems (QGraphicsScene &scene)
       QGraphicsPathItem *itemPath = dynamic_cast<QGraphicsPathItem*> (item);
       if (itemPath != 0) {
 
-        GhostPath ghost (itemPath->path (),
-                         itemPath->pen(),
-                         itemPath->brush());
-        m_paths.push_back (ghost);
+        // SegmentLines are skipped since they are transparent until the cursor hovers over them
+        if (item->data (DATA_KEY_GRAPHICS_ITEM_TYPE).toInt () != GRAPHICS_ITEM_TYPE_SEGMENT) {
+
+          GhostPath ghost (itemPath->path (),
+                           itemPath->pen(),
+                           itemPath->brush());
+          m_paths.push_back (ghost);
+        }
 
       } else {
 
@@ -20,8 +20,9 @@ class QGraphicsScene;
 /// Class for showing points and lines for all coordinate systems simultaneously, even though
 /// the code normally only allows graphical items for once coordinate system to be visible at a time
 ///
-/// QGraphicsLineItems are ignored since those are just used for the AxesChecker, and
-/// QGraphicsPixmapItems are ignored since those are just used for the background. The
+/// QGraphicsLineItems are ignored since those are just used for the AxesChecker,
+/// QGraphicsPixmapItems are ignored since those are just used for the background, and
+/// SegmentLines are ignored since they are invisible until hovered over. The
 /// other QGraphicsItem subclasses are captured and converted into ghosts.
 class Ghosts
 {
@@ -4,6 +4,7 @@
  * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
  ******************************************************************************************************/
 
+#include "BitPlane.h"
 #include "DocumentModelGridRemoval.h"
 #include "EngaugeAssert.h"
 #include "GridHealerAbstractBase.h"
@@ -12,7 +13,6 @@
 #include "Logger.h"
 #include "Pixels.h"
 #include <QFile>
-#include <QImage>
 #include <qmath.h>
 #include <QRgb>
 #include <QTextStream>
@@ -38,7 +38,7 @@ void GridHealerAbstractBase::addMutualPair (int x0,
   m_mutualPairHalvesAbove.push_back (QPoint (x1, y1));
 }
 
-void GridHealerAbstractBase::fillTrapezoid (QImage &image,
+void GridHealerAbstractBase::fillTrapezoid (BitPlane &bitPlane,
                                             int xBL, int yBL,
                                             int xBR, int yBR,
                                             int xTR, int yTR,
@@ -51,28 +51,28 @@ void GridHealerAbstractBase::fillTrapezoid (QImage &image,
                                  << "xTR=" << xTR << " yTR=" << yTR << " xTL=" << xTL << " yTL=" << yTL;
   }
 
-  if (!Pixels::pixelIsBlack(image, xBL, yBL)) {
+  if (!Pixels::pixelIsBlack(bitPlane, xBL, yBL)) {
     LOG4CPP_ERROR_S ((*mainCat)) << "GridHealerAbstractBase::fillTrapezoid has bad bottom left point";
   }
-  if (!Pixels::pixelIsBlack(image, xBR, yBR)) {
+  if (!Pixels::pixelIsBlack(bitPlane, xBR, yBR)) {
     LOG4CPP_ERROR_S ((*mainCat)) << "GridHealerAbstractBase::fillTrapezoid has bad bottom right point";
   }
-  if (!Pixels::pixelIsBlack(image, xTR, yTR)) {
+  if (!Pixels::pixelIsBlack(bitPlane, xTR, yTR)) {
     LOG4CPP_ERROR_S ((*mainCat)) << "GridHealerAbstractBase::fillTrapezoid has bad top right point";
   }
-  if (!Pixels::pixelIsBlack(image, xTL, yTL)) {
+  if (!Pixels::pixelIsBlack(bitPlane, xTL, yTL)) {
     LOG4CPP_ERROR_S ((*mainCat)) << "GridHealerAbstractBase::fillTrapezoid has bad top left point";
   }
 
   // Any quadrilateral (including this trapezoid) can be considered the union of two triangles
   GridTriangleFill triangleFill;
   triangleFill.fill (m_gridLog,
-                     image,
+                     bitPlane,
                      QPoint (xBL, yBL),
                      QPoint (xBR, yBR),
                      QPoint (xTR, yTR));
   triangleFill.fill (m_gridLog,
-                     image,
+                     bitPlane,
                      QPoint (xBL, yBL),
                      QPoint (xTL, yTL),
                      QPoint (xTR, yTR));
@@ -83,10 +83,10 @@ GridLog &GridHealerAbstractBase::gridLog ()
   return m_gridLog;
 }
 
-void GridHealerAbstractBase::healed (QImage &image)
+void GridHealerAbstractBase::healed (BitPlane &bitPlane)
 {
-  applyMutualPairs (image);
-  doHealingAcrossGaps (image);
+  applyMutualPairs (bitPlane);
+  doHealingAcrossGaps (bitPlane);
 }
 
 double GridHealerAbstractBase::maxPointSeparation () const
@@ -115,20 +115,18 @@ int GridHealerAbstractBase::pixelCountInRegionThreshold (const DocumentModelGrid
   return modelGridRemoval.closeDistance();
 }
 
-bool GridHealerAbstractBase::pointsAreGood (const QImage &image,
+bool GridHealerAbstractBase::pointsAreGood (const BitPlane &bitPlane,
                                             int x0,
                                             int y0,
                                             int x1,
                                             int y1) const
 {
-  Pixels pixels;
-
   int stopCountAt = pixelCountInRegionThreshold (m_modelGridRemoval);
 
   // Skip if either endpoint is an unwanted artifact. Look at start point below (since it is connected
   // to the end point below), and the start point above (which is connected to the end point above)
-  return ((pixels.countBlackPixelsAroundPoint (image, x0, y0, stopCountAt) >= stopCountAt) &&
-          (pixels.countBlackPixelsAroundPoint (image, x1, y1, stopCountAt) >= stopCountAt));
+  return ((m_pixels.countBlackPixelsAroundPoint (bitPlane, x0, y0, stopCountAt) >= stopCountAt) &&
+          (m_pixels.countBlackPixelsAroundPoint (bitPlane, x1, y1, stopCountAt) >= stopCountAt));
 }
 
 void GridHealerAbstractBase::saveGapSeparation (double gapSeparation)
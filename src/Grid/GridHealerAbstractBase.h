@@ -9,10 +9,12 @@
 
 #include "DocumentModelGridRemoval.h"
 #include "GridIndependentToDependent.h"
-#include <QImage>
+#include "Pixels.h"
+#include <QList>
+#include <QPoint>
 
+class BitPlane;
 class GridLog;
-class QImage;
 class QTextStream;
 
 // Trick to discriminate horizontal and vertical pixels is to use different sizes
@@ -46,21 +48,21 @@ class GridHealerAbstractBase
   static int pixelCountInRegionThreshold (const DocumentModelGridRemoval &modelGridRemoval);
 
   /// Return healed image after grid removal
-  void healed (QImage &image);
+  void healed (BitPlane &bitPlane);
 
  protected:
 
   /// Apply mutual pair points after all grid removal is done
-  virtual void applyMutualPairs (const QImage &image) = 0;
+  virtual void applyMutualPairs (const BitPlane &bitPlane) = 0;
 
   /// Guts of the algorithm in which sequences of black pixels across the gap from each other
   /// are filled in. Specifically, trapezoids with endpoints separated by no more than the
   /// closest distance are filled in. A greedy algorithm is used which makes each trapezoid as
   /// big as possible
-  virtual void doHealingAcrossGaps (QImage &image) = 0;
+  virtual void doHealingAcrossGaps (BitPlane &bitPlane) = 0;
 
   /// Fill trapezoid with bottom left, bottom right, top right, and top left points
-  void fillTrapezoid (QImage &image,
+  void fillTrapezoid (BitPlane &bitPlane,
                       int xBL, int yBL,
                       int xBR, int yBR,
                       int xTR, int yTR,
@@ -82,7 +84,7 @@ class GridHealerAbstractBase
   const MutualPairHalves &mutualPairHalvesBelow () const;
 
   /// Apply blackPixelRegionIsBigEnough to regions around each of two points
-  bool pointsAreGood (const QImage &image,
+  bool pointsAreGood (const BitPlane &bitPlane,
                       int x0,
                       int y0,
                       int x1,
@@ -101,19 +103,19 @@ class GridHealerAbstractBase
   /// not removed before healing then a long line will be drawn to each from the actual curves
   /// (seen as much bigger artifacts), breaking up those curves into smaller segments which
   /// unnecessarily complicates segment fill
-  bool blackPixelRegionIsBigEnough (const QImage &image,
+  bool blackPixelRegionIsBigEnough (const BitPlane &bitPlane,
                                     int x,
                                     int y) const;
 
   /// Healing for four points defined by below range endpoints and above range endpoints
-  void doHealingOnBelowAndAboveRangePair (QImage &image,
+  void doHealingOnBelowAndAboveRangePair (BitPlane &bitPlane,
                                           int xBelowStart,
                                           int xBelowEnd,
                                           int xAboveStart,
                                           int xAboveEnd);
 
   /// Healing for one specific range of continuous below pixels
-  void doHealingOnBelowRange (QImage &image,
+  void doHealingOnBelowRange (BitPlane &bitPlane,
                               int xBelowStart,
                               int xBelowEnd,
                               int maxHorSep);
@@ -129,6 +131,10 @@ class GridHealerAbstractBase
   MutualPairHalves m_mutualPairHalvesAbove;
 
   GridLog &m_gridLog;
+
+  // Reused by every pointsAreGood call, so its scratch buffers are allocated once per grid line rather than once
+  // per mutual pair
+  mutable Pixels m_pixels;
 };
 
 #endif // GRID_HEALER_ABSTRACT_BASE_H
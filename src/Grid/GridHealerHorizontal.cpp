@@ -4,6 +4,7 @@
  * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
  ******************************************************************************************************/
 
+#include "BitPlane.h"
 #include "GridHealerHorizontal.h"
 #include "GridIndependentToDependent.h"
 #include "GridLog.h"
@@ -17,7 +18,7 @@ GridHealerHorizontal::GridHealerHorizontal(GridLog &gridLog,
 {
 }
 
-void GridHealerHorizontal::applyMutualPairs (const QImage &image)
+void GridHealerHorizontal::applyMutualPairs (const BitPlane &bitPlane)
 {
   MutualPairHalves::const_iterator itrBelow = mutualPairHalvesBelow().begin();
   MutualPairHalves::const_iterator itrAbove = mutualPairHalvesAbove().begin();
@@ -29,11 +30,11 @@ void GridHealerHorizontal::applyMutualPairs (const QImage &image)
     QPoint p1 = *(itrAbove++);
 
     // Save (independent,dependent) pairs
-    if (Pixels::pixelIsBlack (image, p0.x(), p0.y())) {
+    if (Pixels::pixelIsBlack (bitPlane, p0.x(), p0.y())) {
       m_blackPixelsBelow [p0.x()] = p0.y();
     }
 
-    if (Pixels::pixelIsBlack (image, p1.x(), p1.y())) {
+    if (Pixels::pixelIsBlack (bitPlane, p1.x(), p1.y())) {
       m_blackPixelsAbove [p1.x()] = p1.y();
     }
 
@@ -41,7 +42,7 @@ void GridHealerHorizontal::applyMutualPairs (const QImage &image)
   }
 }
 
-void GridHealerHorizontal::doHealingAcrossGaps (QImage &image)
+void GridHealerHorizontal::doHealingAcrossGaps (BitPlane &bitPlane)
 {
   // LOG4CPP_INFO_S is replaced by GridLog
   GridIndependentToDependent::const_iterator itrBelow, itrAbove;
@@ -81,7 +82,7 @@ void GridHealerHorizontal::doHealingAcrossGaps (QImage &image)
 
           if (!m_blackPixelsBelow.contains (xBelowEnd) || (xBelowEnd == xBelowOutOfBounds)) {
 
-            doHealingOnBelowRange (image,
+            doHealingOnBelowRange (bitPlane,
                                    xBelowStart,
                                    xBelowEnd,
                                    maxPointSeparation());
@@ -95,7 +96,7 @@ void GridHealerHorizontal::doHealingAcrossGaps (QImage &image)
   }
 }
 
-void GridHealerHorizontal::doHealingOnBelowAndAboveRangePair (QImage &image,
+void GridHealerHorizontal::doHealingOnBelowAndAboveRangePair (BitPlane &bitPlane,
                                                               int xBelowStart,
                                                               int xBelowEnd,
                                                               int xAboveStart,
@@ -117,10 +118,10 @@ void GridHealerHorizontal::doHealingOnBelowAndAboveRangePair (QImage &image,
                                  QPoint (x2, y2),
                                  QPoint (x3, y3));
 
-  if (pointsAreGood (image, x0, y0, x2, y2)) {
+  if (pointsAreGood (bitPlane, x0, y0, x2, y2)) {
 
     // Big enough so keep it. Four points that define the trapezoid to be filled in
-    fillTrapezoid (image,
+    fillTrapezoid (bitPlane,
                    x0, y0,
                    x1, y1,
                    x2, y2,
@@ -128,7 +129,7 @@ void GridHealerHorizontal::doHealingOnBelowAndAboveRangePair (QImage &image,
   }
 }
 
-void GridHealerHorizontal::doHealingOnBelowRange (QImage &image,
+void GridHealerHorizontal::doHealingOnBelowRange (BitPlane &bitPlane,
                                                   int xBelowStart,
                                                   int xBelowEnd,
                                                   int maxHorSep)
@@ -162,7 +163,7 @@ void GridHealerHorizontal::doHealingOnBelowRange (QImage &image,
 
           if (xBelowStartNearEnough <= xBelowEndNearEnough) {
 
-            doHealingOnBelowAndAboveRangePair (image,
+            doHealingOnBelowAndAboveRangePair (bitPlane,
                                                xBelowStartNearEnough,
                                                xBelowEndNearEnough,
                                                xAboveStart,
@@ -9,11 +9,10 @@
 
 #include "GridHealerAbstractBase.h"
 #include "GridIndependentToDependent.h"
-#include <QImage>
 
+class BitPlane;
 class DocumentModelGridRemoval;
 class GridLog;
-class QImage;
 class QTextStream;
 
 /// Subclass of GridHealerAbstractBase for horizontal lines
@@ -25,21 +24,21 @@ class GridHealerHorizontal : public GridHealerAbstractBase
   GridHealerHorizontal(GridLog &gridLog,
                        const DocumentModelGridRemoval &modelGridRemoval);
 
-  virtual void applyMutualPairs (const QImage &image);
-  virtual void doHealingAcrossGaps (QImage &image);
+  virtual void applyMutualPairs (const BitPlane &bitPlane);
+  virtual void doHealingAcrossGaps (BitPlane &bitPlane);
 
  private:
   GridHealerHorizontal();
 
   /// Healing for four points defined by below range endpoints and above range endpoints
-  void doHealingOnBelowAndAboveRangePair (QImage &image,
+  void doHealingOnBelowAndAboveRangePair (BitPlane &bitPlane,
                                           int xBelowStart,
                                           int xBelowEnd,
                                           int xAboveStart,
                                           int xAboveEnd);
 
   /// Healing for one specific range of continuous below pixels
-  void doHealingOnBelowRange (QImage &image,
+  void doHealingOnBelowRange (BitPlane &bitPlane,
                               int xBelowStart,
                               int xBelowEnd,
                               int maxHorSep);
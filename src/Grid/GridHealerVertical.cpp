@@ -4,6 +4,7 @@
  * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
  ******************************************************************************************************/
 
+#include "BitPlane.h"
 #include "GridHealerVertical.h"
 #include "GridIndependentToDependent.h"
 #include "GridLog.h"
@@ -17,7 +18,7 @@ GridHealerVertical::GridHealerVertical(GridLog &gridLog,
 {
 }
 
-void GridHealerVertical::applyMutualPairs (const QImage &image)
+void GridHealerVertical::applyMutualPairs (const BitPlane &bitPlane)
 {
   MutualPairHalves::const_iterator itrBelow = mutualPairHalvesBelow().begin();
   MutualPairHalves::const_iterator itrAbove = mutualPairHalvesAbove().begin();
@@ -29,11 +30,11 @@ void GridHealerVertical::applyMutualPairs (const QImage &image)
     QPoint p1 = *(itrAbove++);
 
     // Save (independent,dependent) pairs
-    if (Pixels::pixelIsBlack (image, p0.x(), p0.y())) {
+    if (Pixels::pixelIsBlack (bitPlane, p0.x(), p0.y())) {
       m_blackPixelsBelow [p0.y()] = p0.x();
     }
 
-    if (Pixels::pixelIsBlack (image, p1.x(), p1.y())) {
+    if (Pixels::pixelIsBlack (bitPlane, p1.x(), p1.y())) {
       m_blackPixelsAbove [p1.y()] = p1.x();
     }
 
@@ -41,7 +42,7 @@ void GridHealerVertical::applyMutualPairs (const QImage &image)
   }
 }
 
-void GridHealerVertical::doHealingAcrossGaps (QImage &image)
+void GridHealerVertical::doHealingAcrossGaps (BitPlane &bitPlane)
 {
   // LOG4CPP_INFO_S is replaced by GridLog
   GridIndependentToDependent::const_iterator itrBelow, itrAbove;
@@ -81,7 +82,7 @@ void GridHealerVertical::doHealingAcrossGaps (QImage &image)
 
           if (!m_blackPixelsBelow.contains (yBelowEnd) || (yBelowEnd == yBelowOutOfBounds)) {
 
-            doHealingOnBelowRange (image,
+            doHealingOnBelowRange (bitPlane,
                                    yBelowStart,
                                    yBelowEnd,
                                    maxPointSeparation());
@@ -95,7 +96,7 @@ void GridHealerVertical::doHealingAcrossGaps (QImage &image)
   }
 }
 
-void GridHealerVertical::doHealingOnBelowAndAboveRangePair (QImage &image,
+void GridHealerVertical::doHealingOnBelowAndAboveRangePair (BitPlane &bitPlane,
                                                             int yBelowStart,
                                                             int yBelowEnd,
                                                             int yAboveStart,
@@ -117,10 +118,10 @@ void GridHealerVertical::doHealingOnBelowAndAboveRangePair (QImage &image,
                                  QPoint (x2, y2),
                                  QPoint (x3, y3));
 
-  if (pointsAreGood (image, x0, y0, x2, y2)) {
+  if (pointsAreGood (bitPlane, x0, y0, x2, y2)) {
 
     // Big enough so keep it. Four points that define the trapezoid to be filled in
-    fillTrapezoid (image,
+    fillTrapezoid (bitPlane,
                    x0, y0,
                    x1, y1,
                    x2, y2,
@@ -128,7 +129,7 @@ void GridHealerVertical::doHealingOnBelowAndAboveRangePair (QImage &image,
   }
 }
 
-void GridHealerVertical::doHealingOnBelowRange (QImage &image,
+void GridHealerVertical::doHealingOnBelowRange (BitPlane &bitPlane,
                                                 int xBelowStart,
                                                 int xBelowEnd,
                                                 int maxHorSep)
@@ -162,7 +163,7 @@ void GridHealerVertical::doHealingOnBelowRange (QImage &image,
 
           if (xBelowStartNearEnough <= xBelowEndNearEnough) {
 
-            doHealingOnBelowAndAboveRangePair (image,
+            doHealingOnBelowAndAboveRangePair (bitPlane,
                                                xBelowStartNearEnough,
                                                xBelowEndNearEnough,
                                                xAboveStart,
@@ -4,6 +4,7 @@
  * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
  ******************************************************************************************************/
 
+#include "BitPlane.h"
 #include "DocumentModelGridRemoval.h"
 #include "EngaugeAssert.h"
 #include "GridHealerHorizontal.h"
@@ -11,7 +12,6 @@
 #include "GridRemoval.h"
 #include "Logger.h"
 #include "Pixels.h"
-#include <QImage>
 #include <qmath.h>
 #include "Transformation.h"
 
@@ -50,15 +50,21 @@ QPointF GridRemoval::clipY (const QPointF &posUnprojected,
                   (1.0 - s) * posUnprojected.y() + s * posOther.y());
 }
 
-QPixmap GridRemoval::remove (const Transformation &transformation,
-                             const DocumentModelGridRemoval &modelGridRemoval,
-                             const QImage &imageBefore)
+BitPlane GridRemoval::remove (const Transformation &transformation,
+                              const DocumentModelGridRemoval &modelGridRemoval,
+                              const BitPlane &bitPlaneBefore,
+                              BitPlane *bitPlaneRemoved)
 {
   LOG4CPP_INFO_S ((*mainCat)) << "GridRemoval::remove"
                               << " transformationIsDefined=" << (transformation.transformIsDefined() ? "true" : "false")
                               << " removeDefinedGridLines=" << (modelGridRemoval.removeDefinedGridLines() ? "true" : "false");
 
-  QImage image = imageBefore;
+  BitPlane bitPlane = bitPlaneBefore;
+
+  if (bitPlaneRemoved != 0) {
+    *bitPlaneRemoved = BitPlane (bitPlaneBefore.width(),
+                                 bitPlaneBefore.height());
+  }
 
   // Collect GridHealers instances, one per grid line
   GridHealers gridHealers;
@@ -83,7 +89,8 @@ QPixmap GridRemoval::remove (const Transformation &transformation,
 
       removeLine (posScreenMin,
                   posScreenMax,
-                  image,
+                  bitPlane,
+                  bitPlaneRemoved,
                   modelGridRemoval,
                   gridHealers);
     }
@@ -104,7 +111,8 @@ QPixmap GridRemoval::remove (const Transformation &transformation,
 
       removeLine (posScreenMin,
                   posScreenMax,
-                  image,
+                  bitPlane,
+                  bitPlaneRemoved,
                   modelGridRemoval,
                   gridHealers);
     }
@@ -113,24 +121,25 @@ QPixmap GridRemoval::remove (const Transformation &transformation,
     GridHealers::iterator itr;
     for (itr = gridHealers.begin(); itr != gridHealers.end(); itr++) {
       GridHealerAbstractBase *gridHealer = *itr;
-      gridHealer->healed (image);
+      gridHealer->healed (bitPlane);
       delete gridHealer;
     }
   }
 
-  return QPixmap::fromImage (image);
+  return bitPlane;
 }
 
 void GridRemoval::removeLine (const QPointF &posMin,
                               const QPointF &posMax,
-                              QImage &image,
+                              BitPlane &bitPlane,
+                              BitPlane *bitPlaneRemoved,
                               const DocumentModelGridRemoval &modelGridRemoval,
                               GridHealers &gridHealers)
 {
   const int HALF_WIDTH = 1;
 
-  double w = image.width() - 1; // Inclusive width = exclusive width - 1
-  double h = image.height() - 1; // Inclusive height = exclusive height - 1
+  double w = bitPlane.width() - 1; // Inclusive width = exclusive width - 1
+  double h = bitPlane.height() - 1; // Inclusive height = exclusive height - 1
 
   QPointF pos1 = posMin;
   QPointF pos2 = posMax;
@@ -172,7 +181,10 @@ void GridRemoval::removeLine (const QPointF &posMin,
         int yLine = (int) (0.5 + (1.0 - s) * yAtXMin + s * yAtXMax);
         for (int yOffset = -HALF_WIDTH; yOffset <= HALF_WIDTH; yOffset++) {
           int y = yLine + yOffset;
-          image.setPixel (x, y, QColor(Qt::white).rgb());
+          bitPlane.setPixel (x, y, false);
+          if (bitPlaneRemoved != 0) {
+            bitPlaneRemoved->setPixel (x, y, true);
+          }
         }
         gridHealer->addMutualPair (x, yLine - HALF_WIDTH - 1, x, yLine + HALF_WIDTH + 1);
       }
@@ -193,7 +205,10 @@ void GridRemoval::removeLine (const QPointF &posMin,
         int xLine = (int) (0.5  + (1.0 - s) * xAtYMin + s * xAtYMax);
         for (int xOffset = -HALF_WIDTH; xOffset <= HALF_WIDTH; xOffset++) {
           int x = xLine + xOffset;
-          image.setPixel (x, y, QColor(Qt::white).rgb());
+          bitPlane.setPixel (x, y, false);
+          if (bitPlaneRemoved != 0) {
+            bitPlaneRemoved->setPixel (x, y, true);
+          }
         }
         gridHealer->addMutualPair (xLine - HALF_WIDTH - 1, y, xLine + HALF_WIDTH + 1, y);
       }
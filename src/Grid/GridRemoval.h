@@ -7,14 +7,13 @@
 #ifndef GRID_REMOVAL_H
 #define GRID_REMOVAL_H
 
+#include "BitPlane.h"
 #include "GridLog.h"
 #include <QList>
-#include <QPixmap>
 #include <QPointF>
 
 class DocumentModelGridRemoval;
 class GridHealerAbstractBase;
-class QImage;
 class Transformation;
 
 /// Storage of GridHealer instances
@@ -27,10 +26,13 @@ class GridRemoval
   /// Single constructor
   GridRemoval(bool isGnuplot);
 
-  /// Process QImage into QPixmap, removing the grid lines
-  QPixmap remove (const Transformation &transformation,
-                  const DocumentModelGridRemoval &modelGridRemoval,
-                  const QImage &imageBefore);
+  /// Remove the grid lines from the filtered image, healing the curves that crossed them. If bitPlaneRemoved is not
+  /// null, it receives every pixel on the removed grid lines, including pixels that were already off, so the lines
+  /// can also be erased from a color image
+  BitPlane remove (const Transformation &transformation,
+                   const DocumentModelGridRemoval &modelGridRemoval,
+                   const BitPlane &bitPlaneBefore,
+                   BitPlane *bitPlaneRemoved = 0);
 
 private:
   GridRemoval();
@@ -47,7 +49,8 @@ private:
 
   void removeLine (const QPointF &pos1,
                    const QPointF &pos2,
-                   QImage &image,
+                   BitPlane &bitPlane,
+                   BitPlane *bitPlaneRemoved,
                    const DocumentModelGridRemoval &modelGridRemoval,
                    GridHealers &gridHealers);
 
@@ -5,9 +5,9 @@
  ******************************************************************************************************/
 
 #include <algorithm>
+#include "BitPlane.h"
 #include "GridLog.h"
 #include "GridTriangleFill.h"
-#include <QImage>
 #include <QList>
 #include <QPoint>
 
@@ -30,7 +30,7 @@ GridTriangleFill::GridTriangleFill ()
 }
 
 void GridTriangleFill::drawLine (GridLog &gridLog,
-                                 QImage &image,
+                                 BitPlane &bitPlane,
                                  int x0,
                                  int x1,
                                  int y)
@@ -48,13 +48,14 @@ void GridTriangleFill::drawLine (GridLog &gridLog,
 
     gridLog.showOutputScanLinePixel (x, y, RADIUS);
 
-    image.setPixel (QPoint (x, y),
-                    Qt::black);
+    bitPlane.setPixel (x,
+                       y,
+                       true);
   }
 }
 
 void GridTriangleFill::fill (GridLog &gridLog,
-                             QImage &image,
+                             BitPlane &bitPlane,
                              const QPoint &p0In,
                              const QPoint &p1In,
                              const QPoint &p2In)
@@ -70,12 +71,12 @@ void GridTriangleFill::fill (GridLog &gridLog,
     if (p1.y() == p2.y()) {
 
       // Triangle with flat bottom
-      flatBottom (gridLog, image, p0, p1, p2);
+      flatBottom (gridLog, bitPlane, p0, p1, p2);
 
     } else if (p0.y() == p1.y()) {
 
       // Triangle with flat top
-      flatTop (gridLog, image, p0, p1, p2);
+      flatTop (gridLog, bitPlane, p0, p1, p2);
 
     } else {
 
@@ -84,14 +85,14 @@ void GridTriangleFill::fill (GridLog &gridLog,
       double s = (double) (p1.y() - p0.y())/ (double) (p2.y() - p0.y());
       QPoint p3 ((int) (p0.x() + s * (p2.x() - p0.x())),
                  p1.y());
-      flatBottom (gridLog, image, p0, p1, p3);
-      flatTop (gridLog, image, p1, p3, p2);
+      flatBottom (gridLog, bitPlane, p0, p1, p3);
+      flatTop (gridLog, bitPlane, p1, p3, p2);
     }
   }
 }
 
 void GridTriangleFill::flatBottom (GridLog &gridLog,
-                                   QImage &image,
+                                   BitPlane &bitPlane,
                                    const QPoint &p0,
                                    const QPoint &p1,
                                    const QPoint &p2)
@@ -101,7 +102,7 @@ void GridTriangleFill::flatBottom (GridLog &gridLog,
   double denom1 = p2.y() - p0.y();
   if (denom0 == 0 || denom1 == 0) {
     drawLine (gridLog,
-              image,
+              bitPlane,
               p0.x(),
               p2.x(),
               p0.y());
@@ -122,7 +123,7 @@ void GridTriangleFill::flatBottom (GridLog &gridLog,
 
     for (int scanLineY = p0.y(); scanLineY <= p1.y(); scanLineY++) {
       drawLine (gridLog,
-                image,
+                bitPlane,
                 (int) x0,
                 (int) x1,
                 scanLineY);
@@ -133,7 +134,7 @@ void GridTriangleFill::flatBottom (GridLog &gridLog,
 }
 
 void GridTriangleFill::flatTop (GridLog &gridLog,
-                                QImage &image,
+                                BitPlane &bitPlane,
                                 const QPoint &p0,
                                 const QPoint &p1,
                                 const QPoint &p2)
@@ -143,7 +144,7 @@ void GridTriangleFill::flatTop (GridLog &gridLog,
   double denom1 = p2.y() - p1.y();
   if (denom0 == 0 || denom1 == 0) {
     drawLine (gridLog,
-              image,
+              bitPlane,
               p0.x(),
               p2.x(),
               p0.y());
@@ -164,7 +165,7 @@ void GridTriangleFill::flatTop (GridLog &gridLog,
 
     for (int scanLineY = p2.y(); scanLineY >= p0.y(); scanLineY--) {
       drawLine (gridLog,
-                image,
+                bitPlane,
                 (int) x0,
                 (int) x1,
                 scanLineY);
@@ -9,8 +9,8 @@
 
 #include <QPoint>
 
+class BitPlane;
 class GridLog;
-class QImage;
 
 /// Class that does raster-line fill of a triangle, with logging customizations for GridHealer (and therefore
 /// not a generic class in util subdirectory). Inspired by
@@ -22,7 +22,7 @@ public:
 
   /// Fill triangle between these three points
   void fill (GridLog &gridLog,
-             QImage &image,
+             BitPlane &bitPlane,
              const QPoint &p0,
              const QPoint &p1,
              const QPoint &p2);             
@@ -30,17 +30,17 @@ public:
 private:
 
   void drawLine (GridLog &gridLog,
-                 QImage &image,
+                 BitPlane &bitPlane,
                  int x0,
                  int x1,
                  int y);
   void flatBottom (GridLog &gridLog,
-                   QImage &image,
+                   BitPlane &bitPlane,
                    const QPoint &p0,
                    const QPoint &p1,
                    const QPoint &p2); // Assumes p1 and p2 are at bottom at same y level
   void flatTop (GridLog &gridLog,
-                QImage &image,
+                BitPlane &bitPlane,
                 const QPoint &p0,
                 const QPoint &p1,
                 const QPoint &p2); // Assumes p0 and p1 are at top at same y level
@@ -4,17 +4,22 @@
  * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
  ******************************************************************************************************/
 
-#include "ColorFilter.h"
+#include <algorithm>
+#include "BitPlane.h"
 #include "DocumentModelPointMatch.h"
 #include "EngaugeAssert.h"
 #include "gnuplot.h"
 #include <iostream>
 #include "Logger.h"
 #include "PointMatchAlgorithm.h"
+#include "PointMatchCache.h"
+#include "PointMatchDirect.h"
 #include <QFile>
-#include <QImage>
 #include <qmath.h>
+#include <QSet>
 #include <QTextStream>
+#include <QThread>
+#include <QVector>
 
 using namespace std;
 
@@ -24,134 +29,207 @@ const int PIXEL_OFF = -1; // Negative of PIXEL_ON so two off pixels are just as
                           // multiplied. One off pixel and one on pixel give +1 * -1 = -1 which reduces the correlation
 const int PIXEL_ON = 1; // Arbitrary value as long as negative of PIXEL_OFF
 
-PointMatchAlgorithm::PointMatchAlgorithm(bool isGnuplot) :
-  m_isGnuplot (isGnuplot)
+const int SAMPLE_BORDER = 1; // Off pixels around the sample on each side, in the sample array
+
+// Progress after each step, roughly proportional to the time taken by the steps when the image is transformed
+const int PROGRESS_IMAGE_LOADED = 40;
+const int PROGRESS_SAMPLE_LOADED = 60;
+const int PROGRESS_CONVOLUTION_COMPUTED = 85;
+const int PROGRESS_DONE = 100;
+
+// Rough costs in nanoseconds of the steps of each engine, for cheaperEngine. The benchmarks in TestPointMatch show
+// where the crossover falls on a particular machine
+const double COST_DIRECT_PER_ELEMENT = 2.0; // Clearing and converting the counts
+const double COST_DIRECT_PER_PAIR = 1.5; // Adding one on image pixel to the count under one on sample pixel
+const double COST_DIRECT_PER_WORD = 1.0; // Scanning one image word for one sample row
+const double COST_FFT_PER_ELEMENT = 8.0; // Loading the sample, multiplying the transforms and unshifting
+const double COST_FFT_PER_ELEMENT_LOG = 0.5; // One transform, per element per factor of two in the element count
+
+PointMatchAlgorithm::PointMatchAlgorithm(bool isGnuplot,
+                                         PointMatchCache &cache) :
+  m_isGnuplot (isGnuplot),
+  m_cache (cache),
+  m_engine (ENGINE_AUTOMATIC),
+  m_sampleIndex (0),
+  m_sampleCount (1)
 {
   LOG4CPP_INFO_S ((*mainCat)) << "PointMatchAlgorithm::PointMatchAlgorithm";
 }
 
-void PointMatchAlgorithm::allocateMemory(double** array,
-                                         fftw_complex** arrayPrime,
-                                         int width,
-                                         int height)
-{
-  LOG4CPP_INFO_S ((*mainCat)) << "PointMatchAlgorithm::allocateMemory";
-
-  *array = new double [width * height];
-  ENGAUGE_CHECK_PTR(*array);
-
-  *arrayPrime = new fftw_complex [width * height];
-  ENGAUGE_CHECK_PTR(*arrayPrime);
-}
-
 void PointMatchAlgorithm::assembleLocalMaxima(double* convolution,
                                               PointMatchList& listCreated, 
                                               int width,
-                                              int height)
+                                              int height,
+                                              int maxCandidates)
 {
   LOG4CPP_INFO_S ((*mainCat)) << "PointMatchAlgorithm::assembleLocalMaxima";
 
-  // Ignore tiny correlation values near zero by applying this threshold
-  const double SINGLE_PIXEL_CORRELATION = 1.0;
-
-  for (int i = 0; i < width; i++) {
-    for (int j = 0; j < height; j++) {
+  ENGAUGE_ASSERT (maxCandidates > 0);
 
-      // Log is used since values are otherwise too huge to debug (10^10)
-      double convIJ = log10 (convolution[FOLD2DINDEX(i, j, height)]);
+  // Ignore tiny correlation values near zero by applying this threshold. The raw values are compared, which is
+  // equivalent to comparing their logs against 1.0 since log10 is monotonic
+  const double SINGLE_PIXEL_CORRELATION = 10.0;
 
-      // Loop through nearest neighbor points
-      bool isLocalMax = true;
-      for (int iDelta = -1; (iDelta <= 1) && isLocalMax; iDelta++) {
+  // The 3x3 maximum filter is separable, so the maxima along each column (fixed i) are computed first and then
+  // combined across the neighboring columns. Only the columns i-1, i and i+1 are kept
+  QVector<double> maxesPrevious (height), maxesCurrent (height), maxesNext (height);
+  maxAlongColumn (convolution,
+                  0,
+                  height,
+                  maxesCurrent.data ());
 
-        int iNeighbor = i + iDelta;
-        if ((0 <= iNeighbor) && (iNeighbor < width)) {
+  // Bounded heap holding the best maxCandidates maxima so far, with the worst of them at the front
+  listCreated.clear ();
 
-          for (int jDelta = -1; (jDelta <= 1) && isLocalMax; jDelta++) {
+  for (int i = 0; i < width; i++) {
 
-            int jNeighbor = j + jDelta;
-            if ((0 <= jNeighbor) && (jNeighbor < height)) {
+    if (isInterrupted ("assembleLocalMaxima")) {
+      return;
+    }
 
-              // Log is used since values are otherwise too huge to debug (10^10)
-              double convNeighbor = log10 (convolution[FOLD2DINDEX(iNeighbor, jNeighbor, height)]);
-              if (convIJ < convNeighbor) {
+    if (i + 1 < width) {
+      maxAlongColumn (convolution,
+                      i + 1,
+                      height,
+                      maxesNext.data ());
+    }
 
-                isLocalMax = false;
+    for (int j = 0; j < height; j++) {
 
-              } else if (convIJ == convNeighbor) {
+      double convIJ = convolution [FOLD2DINDEX(i, j, height)];
+      if (convIJ <= SINGLE_PIXEL_CORRELATION) {
+        continue;
+      }
 
-                // Rare situation. In the event of a tie, the lower row/column wins (an arbitrary convention)
-                if ((jDelta < 0) || (jDelta == 0 && iDelta < 0)) {
+      // Largest value in the 3x3 neighborhood, including this point
+      double convMax = maxesCurrent [j];
+      if (i > 0) {
+        convMax = qMax (convMax, maxesPrevious [j]);
+      }
+      if (i + 1 < width) {
+        convMax = qMax (convMax, maxesNext [j]);
+      }
+      if (convIJ < convMax) {
+        continue;
+      }
 
-                  isLocalMax = false;
-                }
-              }
-            }
-          }
+      // Rare situation. In the event of a tie, the lower row/column wins (an arbitrary convention), so the
+      // neighbors above and the neighbor to the left must be strictly smaller. Ties are exact since the
+      // convolution holds whole multiples of the transform scale factor
+      bool isLocalMax = true;
+      if (j > 0) {
+        for (int iNeighbor = qMax (0, i - 1); (iNeighbor <= qMin (width - 1, i + 1)) && isLocalMax; iNeighbor++) {
+          isLocalMax = (convolution [FOLD2DINDEX(iNeighbor, j - 1, height)] < convIJ);
         }
       }
+      if (isLocalMax && (i > 0)) {
+        isLocalMax = (convolution [FOLD2DINDEX(i - 1, j, height)] < convIJ);
+      }
 
-      if (isLocalMax &&
-          (convIJ > SINGLE_PIXEL_CORRELATION) ) {
+      if (isLocalMax) {
 
-        // Save new local maximum
+        // Save new local maximum, if it is one of the best so far
         PointMatchTriplet t (i,
                              j,
-                             convolution [FOLD2DINDEX(i, j, height)]);
+                             convIJ);
+
+        if (listCreated.count () < maxCandidates) {
+
+          listCreated.append (t);
+          std::push_heap (listCreated.begin (), listCreated.end ());
+
+        } else if (t < listCreated.first ()) {
+
+          std::pop_heap (listCreated.begin (), listCreated.end ());
+          listCreated.last () = t;
+          std::push_heap (listCreated.begin (), listCreated.end ());
 
-        listCreated.append(t);
+        }
       }
     }
+
+    qSwap (maxesPrevious, maxesCurrent);
+    qSwap (maxesCurrent, maxesNext);
   }
+
+  // Best maxima first
+  std::sort_heap (listCreated.begin (), listCreated.end ());
+
+  LOG4CPP_DEBUG_S ((*mainCat)) << "PointMatchAlgorithm::assembleLocalMaxima"
+                               << " candidates=" << listCreated.count ()
+                               << " maxCandidates=" << maxCandidates;
+}
+
+PointMatchAlgorithm::Engine PointMatchAlgorithm::cheaperEngine (int countOnImage,
+                                                                int countOnSample,
+                                                                int sampleRows,
+                                                                int width,
+                                                                int height,
+                                                                bool imageIsTransformed)
+{
+  double elements = (double) width * (double) height;
+  double wordsPerRow = (width + 31) / 32;
+
+  // Only the sample and the convolution are transformed when the image transform is left over from the previous
+  // match. Loading the image costs about as much as the other steps that visit every element
+  int transforms = (imageIsTransformed ? 2 : 3);
+  double costFft = transforms * COST_FFT_PER_ELEMENT_LOG * elements * qLn (elements) / qLn (2.0) +
+                   (transforms - 1) * COST_FFT_PER_ELEMENT * elements;
+
+  double costDirect = COST_DIRECT_PER_PAIR * (double) countOnImage * (double) countOnSample +
+                      COST_DIRECT_PER_WORD * sampleRows * height * wordsPerRow +
+                      COST_DIRECT_PER_ELEMENT * elements;
+
+  Engine engine = (costDirect < costFft ? ENGINE_DIRECT : ENGINE_FFT);
+
+  LOG4CPP_INFO_S ((*mainCat)) << "PointMatchAlgorithm::cheaperEngine"
+                              << " costDirect=" << costDirect
+                              << " costFft=" << costFft
+                              << " engine=" << (engine == ENGINE_DIRECT ? "direct" : "fft");
+
+  return engine;
 }
 
 void PointMatchAlgorithm::computeConvolution(fftw_complex* imagePrime,
                                              fftw_complex* samplePrime,
                                              int width, int height,
-                                             double** convolution,
+                                             double* convolution,
                                              int sampleXCenter,
                                              int sampleYCenter)
 {
   LOG4CPP_INFO_S ((*mainCat)) << "PointMatchAlgorithm::computeConvolution";
 
-  fftw_complex* convolutionPrime;
+  fftw_complex* convolutionPrime = m_cache.convolutionPrime();
 
-  allocateMemory(convolution,
-                 &convolutionPrime,
-                 width,
-                 height);
+  // Transforms of the real arrays only hold the nonredundant half of each row
+  int heightPrime = PointMatchCache::heightPrime(height);
 
   // Perform in-place conjugation of the sample since equation is F-1 {F(f) * F*(g)}
   conjugateMatrix(width,
-                  height,
+                  heightPrime,
                   samplePrime);
 
   // Perform the convolution in transform space
   multiplyMatrices(width,
-                   height,
+                   heightPrime,
                    imagePrime,
                    samplePrime,
                    convolutionPrime);
 
   // Backward transform the convolution
-  fftw_plan pConvolution = fftw_plan_dft_c2r_2d(width,
-                                                height,
-                                                convolutionPrime,
-                                                *convolution,
-                                                FFTW_ESTIMATE);
-
-  fftw_execute (pConvolution);
-
-  releasePhaseArray(convolutionPrime);
+  m_cache.transformConvolution();
 
   // The convolution pattern is shifted by (sampleXExtent, sampleYExtent). So the downstream code
-  // does not have to repeatedly compensate for that shift, we unshift it here
+  // does not have to repeatedly compensate for that shift, we unshift it here. The image and sample values are
+  // integers, so the correlation is an integer times the scale factor of the backward transform. Rounding removes
+  // the roundoff of the transforms, so equal correlations are exactly equal like those from PointMatchDirect
+  double scale = (double) width * (double) height;
   double *temp = new double [width * height];
   ENGAUGE_CHECK_PTR(temp);
 
   for (int i = 0; i < width; i++) {
     for (int j = 0; j < height; j++) {
-      temp [FOLD2DINDEX(i, j, height)] = (*convolution) [FOLD2DINDEX(i, j, height)];
+      temp [FOLD2DINDEX(i, j, height)] = convolution [FOLD2DINDEX(i, j, height)];
     }
   }
   for (int iFrom = 0; iFrom < width; iFrom++) {
@@ -159,7 +237,7 @@ void PointMatchAlgorithm::computeConvolution(fftw_complex* imagePrime,
       // Gnuplot of convolution file shows x and y shifts should be positive
       int iTo = (iFrom + sampleXCenter) % width;
       int jTo = (jFrom + sampleYCenter) % height;
-      (*convolution) [FOLD2DINDEX(iTo, jTo, height)] = temp [FOLD2DINDEX(iFrom, jFrom, height)];
+      convolution [FOLD2DINDEX(iTo, jTo, height)] = scale * qRound (temp [FOLD2DINDEX(iFrom, jFrom, height)] / scale);
     }
   }
   delete [] temp;
@@ -182,6 +260,169 @@ void PointMatchAlgorithm::conjugateMatrix(int width,
   }
 }
 
+bool PointMatchAlgorithm::correlateDirect (const QList<QPoint> &sampleOffsetsOn,
+                                           const BitPlane &bitPlaneProcessed,
+                                           const DocumentModelPointMatch &modelPointMatch,
+                                           const Points &pointsExisting,
+                                           int width,
+                                           int height,
+                                           double *convolution)
+{
+  LOG4CPP_INFO_S ((*mainCat)) << "PointMatchAlgorithm::correlateDirect";
+
+  BitPlane bitPlaneMatched (bitPlaneProcessed);
+  removePixelsNearExistingPoints(bitPlaneMatched,
+                                 pointsExisting,
+                                 modelPointMatch.maxPointSize());
+  emitProgressOfSample (PROGRESS_IMAGE_LOADED);
+
+  PointMatchDirect direct (bitPlaneMatched,
+                           sampleOffsetsOn);
+  direct.correlate (convolution,
+                    width,
+                    height);
+
+  return !isInterrupted ("correlateDirect");
+}
+
+bool PointMatchAlgorithm::correlateFft (const QList<PointMatchPixel> &samplePointPixels,
+                                        const BitPlane &bitPlaneProcessed,
+                                        const DocumentModelPointMatch &modelPointMatch,
+                                        const Points &pointsExisting,
+                                        int width,
+                                        int height,
+                                        double *&convolution)
+{
+  LOG4CPP_INFO_S ((*mainCat)) << "PointMatchAlgorithm::correlateFft";
+
+  // The untransformed (unprimed) and transformed (primed) storage arrays can be huge for big pictures, so they
+  // are allocated once per size by the cache, along with the plans for transforming them
+  m_cache.prepare(width,
+                  height);
+  double *image = m_cache.image();
+  double *sample = m_cache.sample();
+  convolution = m_cache.convolution();
+
+  // Compute convolution=F(-1){F(image)*F(*)(sample)}. The image transform only depends on the image, the existing
+  // points and the point size, so it is left over from the previous match unless one of those has changed
+  int sampleXCenter, sampleYCenter, sampleXExtent, sampleYExtent;
+  if (!m_cache.imageIsTransformed(bitPlaneProcessed,
+                                  pointsExisting,
+                                  modelPointMatch.maxPointSize())) {
+    loadImage(bitPlaneProcessed,
+              modelPointMatch,
+              pointsExisting,
+              width,
+              height);
+  }
+  emitProgressOfSample (PROGRESS_IMAGE_LOADED);
+  if (isInterrupted ("loadSample")) {
+    return false;
+  }
+
+  loadSample(samplePointPixels,
+             width,
+             height,
+             &sampleXCenter,
+             &sampleYCenter,
+             &sampleXExtent,
+             &sampleYExtent);
+  emitProgressOfSample (PROGRESS_SAMPLE_LOADED);
+  if (isInterrupted ("computeConvolution")) {
+    return false;
+  }
+
+  computeConvolution(m_cache.imagePrime(),
+                     m_cache.samplePrime(),
+                     width,
+                     height,
+                     convolution,
+                     sampleXCenter,
+                     sampleYCenter);
+
+  if (m_isGnuplot) {
+
+    dumpToGnuplot(image,
+                  width,
+                  height,
+                  "image.gnuplot");
+    dumpToGnuplot(sample,
+                  width,
+                  height,
+                  "sample.gnuplot");
+  }
+
+  return true;
+}
+
+bool PointMatchAlgorithm::correlateSample (const QList<PointMatchPixel> &samplePointPixels,
+                                           const BitPlane &bitPlaneProcessed,
+                                           const DocumentModelPointMatch &modelPointMatch,
+                                           const Points &pointsExisting,
+                                           int width,
+                                           int height,
+                                           QVector<double> &convolutionDirect,
+                                           double *&convolution)
+{
+  LOG4CPP_INFO_S ((*mainCat)) << "PointMatchAlgorithm::correlateSample"
+                              << " samplePointPixels=" << samplePointPixels.count();
+
+  // Offsets of the on sample pixels from the sample center, which are all that the direct engine needs
+  QList<QPoint> positions, sampleOffsetsOn;
+  QSet<int> sampleRowsOn;
+  int sampleXCenter, sampleYCenter, sampleXExtent, sampleYExtent;
+  samplePositions(samplePointPixels,
+                  width,
+                  height,
+                  positions,
+                  &sampleXCenter,
+                  &sampleYCenter,
+                  &sampleXExtent,
+                  &sampleYExtent);
+  for (int i = 0; i < samplePointPixels.count(); i++) {
+    if (samplePointPixels.at(i).pixelIsOn()) {
+      sampleOffsetsOn << positions.at(i) - QPoint (sampleXCenter, sampleYCenter);
+      sampleRowsOn << positions.at(i).y();
+    }
+  }
+
+  // After the first sample the image transform is in the cache, which makes the transforms cheaper for the rest
+  Engine engine = m_engine;
+  if (engine == ENGINE_AUTOMATIC) {
+    engine = cheaperEngine (bitPlaneProcessed.countOn(),
+                            sampleOffsetsOn.count(),
+                            sampleRowsOn.count(),
+                            width,
+                            height,
+                            m_cache.imageIsTransformed(bitPlaneProcessed,
+                                                       pointsExisting,
+                                                       modelPointMatch.maxPointSize()));
+  }
+
+  if (engine == ENGINE_DIRECT) {
+
+    convolutionDirect.resize (width * height);
+    convolution = convolutionDirect.data();
+    return correlateDirect(sampleOffsetsOn,
+                           bitPlaneProcessed,
+                           modelPointMatch,
+                           pointsExisting,
+                           width,
+                           height,
+                           convolution);
+
+  } else {
+
+    return correlateFft(samplePointPixels,
+                        bitPlaneProcessed,
+                        modelPointMatch,
+                        pointsExisting,
+                        width,
+                        height,
+                        convolution);
+  }
+}
+
 void PointMatchAlgorithm::dumpToGnuplot (double* convolution,
                                          int width,
                                          int height,
@@ -215,61 +456,173 @@ void PointMatchAlgorithm::dumpToGnuplot (double* convolution,
   file.close();
 }
 
+void PointMatchAlgorithm::emitProgressOfSample (int percent)
+{
+  emit signalProgress ((m_sampleIndex * PROGRESS_CONVOLUTION_COMPUTED + percent) / m_sampleCount);
+}
+
 QList<QPoint> PointMatchAlgorithm::findPoints (const QList<PointMatchPixel> &samplePointPixels,
-                                               const QImage &imageProcessed,
+                                               const BitPlane &bitPlaneProcessed,
                                                const DocumentModelPointMatch &modelPointMatch,
                                                const Points &pointsExisting)
 {
+  QList<QList<PointMatchPixel> > samplesPointPixels;
+  samplesPointPixels << samplePointPixels;
+
+  QList<int> sampleIndexes;
+  return findPoints (samplesPointPixels,
+                     bitPlaneProcessed,
+                     modelPointMatch,
+                     pointsExisting,
+                     sampleIndexes);
+}
+
+QList<QPoint> PointMatchAlgorithm::findPoints (const QList<QList<PointMatchPixel> > &samplesPointPixels,
+                                               const BitPlane &bitPlaneProcessed,
+                                               const DocumentModelPointMatch &modelPointMatch,
+                                               const Points &pointsExisting,
+                                               QList<int> &sampleIndexes)
+{
+  QRect rectImage (QPoint (0, 0),
+                   bitPlaneProcessed.size());
+  QRect region = m_region.intersected (rectImage);
+  if (m_region.isNull() || (region == rectImage)) {
+    return findPointsInImage (samplesPointPixels,
+                              bitPlaneProcessed,
+                              modelPointMatch,
+                              pointsExisting,
+                              sampleIndexes);
+  }
+
   LOG4CPP_INFO_S ((*mainCat)) << "PointMatchAlgorithm::findPoints"
-                              << " samplePointPixels=" << samplePointPixels.count();
+                              << " region=(" << region.x() << ", " << region.y()
+                              << ", " << region.width() << ", " << region.height() << ")";
+
+  QList<QPoint> pointsCreated;
+  sampleIndexes.clear();
+
+  if (region.isEmpty()) {
+    emit signalProgress (PROGRESS_DONE);
+    return pointsCreated;
+  }
 
-  // Use larger arrays for computations, if necessary, to improve fft performance
-  int originalWidth = imageProcessed.width();
-  int originalHeight = imageProcessed.height();
+  // The padded arrays must hold the whole sample, so a region that is thinner than the sample, such as a rectangle
+  // dragged across one row of points or one that is mostly outside the image, is grown around its center. It is
+  // shifted rather than cut back where it would cross the edges of the image
+  QSize sizeSample = sampleSize (samplesPointPixels);
+  int widthCropped = qMin (qMax (region.width(), sizeSample.width()), rectImage.width());
+  int heightCropped = qMin (qMax (region.height(), sizeSample.height()), rectImage.height());
+  int xCropped = qBound (0,
+                         region.x() - (widthCropped - region.width()) / 2,
+                         rectImage.width() - widthCropped);
+  int yCropped = qBound (0,
+                         region.y() - (heightCropped - region.height()) / 2,
+                         rectImage.height() - heightCropped);
+  QRect regionCropped (xCropped,
+                       yCropped,
+                       widthCropped,
+                       heightCropped);
+
+  // Only the cropped region is padded and transformed, so the work and memory shrink with its area. Pixels near the
+  // existing points are turned off before cropping, since points just outside the region can reach into it. The
+  // matches wrap around at the edges of the cropped region rather than the edges of the image
+  BitPlane bitPlaneWithoutPoints (bitPlaneProcessed);
+  removePixelsNearExistingPoints(bitPlaneWithoutPoints,
+                                 pointsExisting,
+                                 modelPointMatch.maxPointSize());
+
+  QList<int> sampleIndexesCropped;
+  QList<QPoint> pointsCropped = findPointsInImage (samplesPointPixels,
+                                                   bitPlaneWithoutPoints.copy (regionCropped),
+                                                   modelPointMatch,
+                                                   Points (),
+                                                   sampleIndexesCropped);
+
+  // Candidates go back to image coordinates, keeping only those inside the region that was asked for
+  for (int i = 0; i < pointsCropped.count(); i++) {
+    QPoint point = pointsCropped.at (i) + regionCropped.topLeft();
+    if (region.contains (point)) {
+      pointsCreated << point;
+      sampleIndexes << sampleIndexesCropped.at (i);
+    }
+  }
+
+  return pointsCreated;
+}
+
+QList<QPoint> PointMatchAlgorithm::findPointsInImage (const QList<QList<PointMatchPixel> > &samplesPointPixels,
+                                                      const BitPlane &bitPlaneProcessed,
+                                                      const DocumentModelPointMatch &modelPointMatch,
+                                                      const Points &pointsExisting,
+                                                      QList<int> &sampleIndexes)
+{
+  LOG4CPP_INFO_S ((*mainCat)) << "PointMatchAlgorithm::findPointsInImage"
+                              << " samples=" << samplesPointPixels.count();
+
+  ENGAUGE_ASSERT (samplesPointPixels.count() > 0);
+
+  QList<QPoint> pointsCreated;
+  sampleIndexes.clear();
+
+  // Use larger arrays for computations, if necessary, to improve fft performance. The direct engine uses the same
+  // padded size, so both engines wrap around the edges the same way and give the same matches
+  int originalWidth = bitPlaneProcessed.width();
+  int originalHeight = bitPlaneProcessed.height();
   int width = optimizeLengthForFft(originalWidth);
   int height = optimizeLengthForFft(originalHeight);
+  int count = width * height;
+
+  // With several samples, the largest correlation at each position is kept along with the sample that gave it.
+  // Both engines give exact multiples of the same scale factor, so equal correlations of different samples compare
+  // as equal and the earlier sample wins
+  QVector<double> convolutionDirect, convolutionBest;
+  QVector<int> sampleBest;
+  double *convolution = 0;
+
+  m_sampleCount = samplesPointPixels.count();
+  for (m_sampleIndex = 0; m_sampleIndex < m_sampleCount; m_sampleIndex++) {
+
+    if (!correlateSample(samplesPointPixels.at (m_sampleIndex),
+                         bitPlaneProcessed,
+                         modelPointMatch,
+                         pointsExisting,
+                         width,
+                         height,
+                         convolutionDirect,
+                         convolution)) {
+      return pointsCreated;
+    }
 
-  // The untransformed (unprimed) and transformed (primed) storage arrays can be huge for big pictures, so minimize
-  // the number of allocated arrays at every point in time
-  double *image, *sample, *convolution;
-  fftw_complex *imagePrime, *samplePrime;
+    if (m_sampleCount > 1) {
 
-  // Compute convolution=F(-1){F(image)*F(*)(sample)}
-  int sampleXCenter, sampleYCenter, sampleXExtent, sampleYExtent;
-  loadImage(imageProcessed,
-            modelPointMatch,
-            pointsExisting,
-            width,
-            height,
-            &image,
-            &imagePrime);
-  loadSample(samplePointPixels,
-             width,
-             height,
-             &sample,
-             &samplePrime,
-             &sampleXCenter,
-             &sampleYCenter,
-             &sampleXExtent,
-             &sampleYExtent);
-  computeConvolution(imagePrime,
-                     samplePrime,
-                     width,
-                     height,
-                     &convolution,
-                     sampleXCenter,
-                     sampleYCenter);
+      if (m_sampleIndex == 0) {
+
+        convolutionBest.resize (count);
+        std::copy (convolution, convolution + count, convolutionBest.begin ());
+        sampleBest.fill (0, count);
+
+      } else {
+
+        double *best = convolutionBest.data();
+        int *indexes = sampleBest.data();
+        for (int index = 0; index < count; index++) {
+          if (convolution [index] > best [index]) {
+            best [index] = convolution [index];
+            indexes [index] = m_sampleIndex;
+          }
+        }
+      }
+    }
+
+    emitProgressOfSample (PROGRESS_CONVOLUTION_COMPUTED);
+  }
+
+  if (!convolutionBest.isEmpty ()) {
+    convolution = convolutionBest.data();
+  }
 
   if (m_isGnuplot) {
 
-    dumpToGnuplot(image,
-                  width,
-                  height,
-                  "image.gnuplot");
-    dumpToGnuplot(sample,
-                  width,
-                  height,
-                  "sample.gnuplot");
     dumpToGnuplot(convolution,
                   width,
                   height,
@@ -282,72 +635,95 @@ QList<QPoint> PointMatchAlgorithm::findPoints (const QList<PointMatchPixel> &sam
   assembleLocalMaxima(convolution,
                       listCreated,
                       width,
-                      height);
-  qSort (listCreated);
+                      height,
+                      modelPointMatch.maxCandidates());
+  if (isInterrupted ("assembleLocalMaxima")) {
+    return pointsCreated;
+  }
 
   // Copy sorted match points to output
-  QList<QPoint> pointsCreated;
   PointMatchList::iterator itr;
   for (itr = listCreated.begin(); itr != listCreated.end(); itr++) {
 
     PointMatchTriplet triplet = *itr;
     pointsCreated.push_back (triplet.point ());
 
+    if (sampleBest.isEmpty ()) {
+      sampleIndexes.push_back (0);
+    } else {
+      sampleIndexes.push_back (sampleBest [FOLD2DINDEX(triplet.x (), triplet.y (), height)]);
+    }
+
     // Current order of maxima would be fine if they never overlapped. However, they often overlap so as each
     // point is pulled off the list, and its pixels are removed from the image, we might consider updating all
     // succeeding maxima here if those maximax overlap the just-removed maxima. The maxima list is kept
     // in descending order according to correlation value
   }
 
-  releaseImageArray(image);
-  releasePhaseArray(imagePrime);
-  releaseImageArray(sample);
-  releasePhaseArray(samplePrime);
-  releaseImageArray(convolution);
+  emit signalProgress (PROGRESS_DONE);
 
   return pointsCreated;
 }
 
-void PointMatchAlgorithm::loadImage(const QImage &imageProcessed,
+void PointMatchAlgorithm::maxAlongColumn (const double *convolution,
+                                          int i,
+                                          int height,
+                                          double *maxes) const
+{
+  const double *column = convolution + FOLD2DINDEX(i, 0, height);
+
+  for (int j = 0; j < height; j++) {
+
+    double convMax = column [j];
+    if (j > 0) {
+      convMax = qMax (convMax, column [j - 1]);
+    }
+    if (j + 1 < height) {
+      convMax = qMax (convMax, column [j + 1]);
+    }
+
+    maxes [j] = convMax;
+  }
+}
+
+bool PointMatchAlgorithm::isInterrupted (const char *step) const
+{
+  if (QThread::currentThread()->isInterruptionRequested()) {
+
+    LOG4CPP_INFO_S ((*mainCat)) << "PointMatchAlgorithm::isInterrupted skipping " << step;
+    return true;
+  }
+
+  return false;
+}
+
+void PointMatchAlgorithm::loadImage(const BitPlane &bitPlaneProcessed,
                                     const DocumentModelPointMatch &modelPointMatch,
                                     const Points &pointsExisting,
                                     int width,
-                                    int height,
-                                    double** image,
-                                    fftw_complex** imagePrime)
+                                    int height)
 {
   LOG4CPP_INFO_S ((*mainCat)) << "PointMatchAlgorithm::loadImage";
 
-  allocateMemory(image,
-                 imagePrime,
-                 width,
-                 height);
-  
-  populateImageArray(imageProcessed, 
-                     width,
-                     height,
-                     image);
-
-  removePixelsNearExistingPoints(*image,
-                                 width,
-                                 height,
+  BitPlane bitPlaneMatched (bitPlaneProcessed);
+  removePixelsNearExistingPoints(bitPlaneMatched,
                                  pointsExisting,
                                  modelPointMatch.maxPointSize());
 
+  populateImageArray(bitPlaneMatched,
+                     width,
+                     height,
+                     m_cache.image());
+
   // Forward transform the image
-  fftw_plan pImage = fftw_plan_dft_r2c_2d(width,
-                                          height,
-                                          *image,
-                                          *imagePrime,
-                                          FFTW_ESTIMATE);
-  fftw_execute(pImage);
+  m_cache.transformImage(bitPlaneProcessed,
+                         pointsExisting,
+                         modelPointMatch.maxPointSize());
 }
 
 void PointMatchAlgorithm::loadSample(const QList<PointMatchPixel> &samplePointPixels,
                                      int width,
                                      int height,
-                                     double** sample,
-                                     fftw_complex** samplePrime,
                                      int* sampleXCenter,
                                      int* sampleYCenter,
                                      int* sampleXExtent,
@@ -357,27 +733,17 @@ void PointMatchAlgorithm::loadSample(const QList<PointMatchPixel> &samplePointPi
 
   // Populate 2d sample array with same size (width x height) as image so fft transforms will have same
   // dimensions, which means their transforms can be multiplied element-to-element
-  allocateMemory(sample,
-                 samplePrime,
-                 width,
-                 height);
-
   populateSampleArray(samplePointPixels,
                       width,
                       height,
-                      sample,
+                      m_cache.sample(),
                       sampleXCenter,
                       sampleYCenter,
                       sampleXExtent,
                       sampleYExtent);
 
   // Forward transform the sample
-  fftw_plan pSample = fftw_plan_dft_r2c_2d(width,
-                                           height,
-                                           *sample,
-                                           *samplePrime,
-                                           FFTW_ESTIMATE);
-  fftw_execute(pSample);
+  m_cache.transformSample();
 }
 
 void PointMatchAlgorithm::multiplyMatrices(int width,
@@ -443,24 +809,36 @@ int PointMatchAlgorithm::optimizeLengthForFft(int originalLength)
   return closestLength;
 }
 
-void PointMatchAlgorithm::populateImageArray(const QImage &imageProcessed,
+void PointMatchAlgorithm::populateImageArray(const BitPlane &bitPlaneProcessed,
                                              int width,
                                              int height,
-                                             double** image)
+                                             double* image)
 {
   LOG4CPP_INFO_S ((*mainCat)) << "PointMatchAlgorithm::populateImageArray";
 
-  // Initialize memory with original image in real component, and imaginary component set to zero
-  ColorFilter colorFilter;
-  for (int x = 0; x < width; x++) {
-    for (int y = 0; y < height; y++) {
-      bool pixelIsOn = colorFilter.pixelFilteredIsOn (imageProcessed,
-                                                      x,
-                                                      y);
+  // Initialize memory with original image in real component, and imaginary component set to zero. Everything
+  // starts off, including the padding beyond the processed image, and then the on pixels are set a word at a
+  // time so the usually empty areas are skipped quickly
+  for (int i = 0; i < width * height; i++) {
+    image [i] = PIXEL_OFF;
+  }
+
+  for (int y = 0; y < bitPlaneProcessed.height(); y++) {
+
+    const quint32 *row = bitPlaneProcessed.row (y);
+    for (int w = 0; w < bitPlaneProcessed.wordsPerRow(); w++) {
+
+      quint32 word = row [w];
+      int x = 32 * w;
+      while (word != 0) {
 
-      (*image) [FOLD2DINDEX(x, y, height)]  = (pixelIsOn ?
-                                                 PIXEL_ON :
-                                                 PIXEL_OFF);
+        if (word & 1) {
+          image [FOLD2DINDEX(x, y, height)] = PIXEL_ON;
+        }
+
+        word >>= 1;
+        ++x;
+      }
     }
   }
 }
@@ -468,7 +846,7 @@ void PointMatchAlgorithm::populateImageArray(const QImage &imageProcessed,
 void PointMatchAlgorithm::populateSampleArray(const QList<PointMatchPixel> &samplePointPixels,
                                               int width,
                                               int height,
-                                              double** sample,
+                                              double* sample,
                                               int* sampleXCenter,
                                               int* sampleYCenter,
                                               int* sampleXExtent,
@@ -476,6 +854,84 @@ void PointMatchAlgorithm::populateSampleArray(const QList<PointMatchPixel> &samp
 {
   LOG4CPP_INFO_S ((*mainCat)) << "PointMatchAlgorithm::populateSampleArray";
 
+  QList<QPoint> positions;
+  samplePositions(samplePointPixels,
+                  width,
+                  height,
+                  positions,
+                  sampleXCenter,
+                  sampleYCenter,
+                  sampleXExtent,
+                  sampleYExtent);
+
+  // Initialize memory with original image in real component, and imaginary component set to zero
+  int x, y;
+  for (x = 0; x < width; x++) {
+    for (y = 0; y < height; y++) {
+      sample [FOLD2DINDEX(x, y, height)] = PIXEL_OFF;
+    }
+  }
+
+  for (int i = 0; i < samplePointPixels.size(); i++) {
+
+    bool pixelIsOn = samplePointPixels.at(i).pixelIsOn();
+
+    sample [FOLD2DINDEX(positions.at(i).x(), positions.at(i).y(), height)] = (pixelIsOn ? PIXEL_ON : PIXEL_OFF);
+  }
+}
+
+void PointMatchAlgorithm::removePixelsNearExistingPoints(BitPlane &bitPlane,
+                                                         const Points &pointsExisting,
+                                                         int pointSeparation)
+{
+  LOG4CPP_INFO_S ((*mainCat)) << "PointMatchAlgorithm::removePixelsNearExistingPoints";
+
+  for (int i = 0; i < pointsExisting.size(); i++) {
+
+    int xPoint = pointsExisting.at(i).posScreen().x();
+    int yPoint = pointsExisting.at(i).posScreen().y();
+
+    // Loop through rows of pixels
+    int yMin = yPoint - pointSeparation;
+    if (yMin < 0)
+      yMin = 0;
+    int yMax = yPoint + pointSeparation;
+    if (bitPlane.height() < yMax)
+      yMax = bitPlane.height();
+
+    for (int y = yMin; y < yMax; y++) {
+
+      // Pythagorean theorem gives range of x values
+      int radical = pointSeparation * pointSeparation - (y - yPoint) * (y - yPoint);
+      if (0 < radical) {
+
+        int xMin = (int) (xPoint - qSqrt((double) radical));
+        if (xMin < 0)
+          xMin = 0;
+        int xMax = xPoint + (xPoint - xMin);
+        if (bitPlane.width() < xMax)
+          xMax = bitPlane.width();
+
+        // Turn off pixels in this row of pixels
+        for (int x = xMin; x < xMax; x++) {
+
+          bitPlane.setPixel (x, y, false);
+
+        }
+      }
+    }
+  }
+}
+
+void PointMatchAlgorithm::samplePositions(const QList<PointMatchPixel> &samplePointPixels,
+                                          int width,
+                                          int height,
+                                          QList<QPoint> &positions,
+                                          int* sampleXCenter,
+                                          int* sampleYCenter,
+                                          int* sampleXExtent,
+                                          int* sampleYExtent)
+{
   // Compute bounds
   bool first = true;
   unsigned int i;
@@ -496,39 +952,28 @@ void PointMatchAlgorithm::populateSampleArray(const QList<PointMatchPixel> &samp
     first = false;
   }
 
-  const int border = 1; // #pixels in border on each side
-
-  xMin -= border;
-  yMin -= border;
-  xMax += border;
-  yMax += border;
-
-  // Initialize memory with original image in real component, and imaginary component set to zero
-  int x, y;
-  for (x = 0; x < width; x++) {
-    for (y = 0; y < height; y++) {
-      (*sample) [FOLD2DINDEX(x, y, height)] = PIXEL_OFF;
-    }
-  }
+  xMin -= SAMPLE_BORDER;
+  yMin -= SAMPLE_BORDER;
+  xMax += SAMPLE_BORDER;
+  yMax += SAMPLE_BORDER;
 
   // We compute the center of mass of the on pixels. This means user does not have to precisely align
   // the encompassing circle when selecting the sample point, since surrounding off pixels will not
   // affect the center of mass computed only from on pixels
   double xSumOn = 0, ySumOn = 0, countOn = 0;
 
+  positions.clear();
   for (i = 0; i < (unsigned int) samplePointPixels.size(); i++) {
 
     // Place, quite arbitrarily, the sample image up against the top left corner
-    x = (samplePointPixels.at(i)).xOffset() - xMin;
-    y = (samplePointPixels.at(i)).yOffset() - yMin;
+    int x = (samplePointPixels.at(i)).xOffset() - xMin;
+    int y = (samplePointPixels.at(i)).yOffset() - yMin;
     ENGAUGE_ASSERT((0 < x) && (x < width));
     ENGAUGE_ASSERT((0 < y) && (y < height));
 
-    bool pixelIsOn = samplePointPixels.at(i).pixelIsOn();
+    positions << QPoint (x, y);
 
-    (*sample) [FOLD2DINDEX(x, y, height)] = (pixelIsOn ? PIXEL_ON : PIXEL_OFF);
-
-    if (pixelIsOn) {
+    if (samplePointPixels.at(i).pixelIsOn()) {
       xSumOn += x;
       ySumOn += y;
       ++countOn;
@@ -545,63 +990,39 @@ void PointMatchAlgorithm::populateSampleArray(const QList<PointMatchPixel> &samp
   *sampleYExtent = yMax - yMin + 1;
 }
 
-void PointMatchAlgorithm::releaseImageArray(double* array)
+QSize PointMatchAlgorithm::sampleSize (const QList<QList<PointMatchPixel> > &samplesPointPixels) const
 {
-  LOG4CPP_INFO_S ((*mainCat)) << "PointMatchAlgorithm::releaseImageArray";
+  int width = 0, height = 0;
+  for (int indexS = 0; indexS < samplesPointPixels.count(); indexS++) {
 
-  ENGAUGE_CHECK_PTR(array);
-  delete[] array;
-}
+    const QList<PointMatchPixel> &samplePointPixels = samplesPointPixels.at (indexS);
+    if (samplePointPixels.isEmpty()) {
+      continue;
+    }
 
-void PointMatchAlgorithm::releasePhaseArray(fftw_complex* arrayPrime)
-{
-  LOG4CPP_INFO_S ((*mainCat)) << "PointMatchAlgorithm::releasePhaseArray";
+    int xMin = samplePointPixels.first().xOffset(), xMax = xMin;
+    int yMin = samplePointPixels.first().yOffset(), yMax = yMin;
+    for (int i = 1; i < samplePointPixels.count(); i++) {
+      xMin = qMin (xMin, samplePointPixels.at (i).xOffset());
+      xMax = qMax (xMax, samplePointPixels.at (i).xOffset());
+      yMin = qMin (yMin, samplePointPixels.at (i).yOffset());
+      yMax = qMax (yMax, samplePointPixels.at (i).yOffset());
+    }
+
+    // Same extent as samplePositions, which also needs room for the border on each side
+    width = qMax (width, xMax - xMin + 1 + 2 * SAMPLE_BORDER);
+    height = qMax (height, yMax - yMin + 1 + 2 * SAMPLE_BORDER);
+  }
 
-  ENGAUGE_CHECK_PTR(arrayPrime);
-  delete[] arrayPrime;
+  return QSize (width, height);
 }
 
-void PointMatchAlgorithm::removePixelsNearExistingPoints(double* image,
-                                                         int imageWidth,
-                                                         int imageHeight,
-                                                         const Points &pointsExisting,
-                                                         int pointSeparation)
+void PointMatchAlgorithm::setEngine (Engine engine)
 {
-  LOG4CPP_INFO_S ((*mainCat)) << "PointMatchAlgorithm::removePixelsNearExistingPoints";
-
-  for (int i = 0; i < pointsExisting.size(); i++) {
-
-    int xPoint = pointsExisting.at(i).posScreen().x();
-    int yPoint = pointsExisting.at(i).posScreen().y();
-
-    // Loop through rows of pixels
-    int yMin = yPoint - pointSeparation;
-    if (yMin < 0)
-      yMin = 0;
-    int yMax = yPoint + pointSeparation;
-    if (imageHeight < yMax)
-      yMax = imageHeight;
-
-    for (int y = yMin; y < yMax; y++) {
-
-      // Pythagorean theorem gives range of x values
-      int radical = pointSeparation * pointSeparation - (y - yPoint) * (y - yPoint);
-      if (0 < radical) {
-
-        int xMin = (int) (xPoint - qSqrt((double) radical));
-        if (xMin < 0)
-          xMin = 0;
-        int xMax = xPoint + (xPoint - xMin);
-        if (imageWidth < xMax)
-          xMax = imageWidth;
-
-        // Turn off pixels in this row of pixels
-        for (int x = xMin; x < xMax; x++) {
-
-          image [FOLD2DINDEX(x, y, imageHeight)] = PIXEL_OFF;
+  m_engine = engine;
+}
 
-        }
-      }
-    }
-  }
+void PointMatchAlgorithm::setRegion (const QRect &region)
+{
+  m_region = region;
 }
@@ -13,50 +13,103 @@
 #include "PointMatchTriplet.h"
 #include "Points.h"
 #include <QList>
+#include <QObject>
 #include <QPoint>
+#include <QRect>
+#include <QSize>
+#include <QVector>
 
+class BitPlane;
 class DocumentModelPointMatch;
-class QImage;
+class PointMatchCache;
 class QPixmap;
 
 typedef QList<PointMatchTriplet> PointMatchList;
 
 /// Algorithm returning a list of points that match the specified point. This returns a list of matches, from best to worst.
-/// This is executed in a separate QThread so the gui thread is not blocked
-class PointMatchAlgorithm
+/// This is executed in a separate QThread (see PointMatchThread) so the gui thread is not blocked. Between steps, the
+/// algorithm reports its progress and gives up if interruption of the current thread has been requested. The
+/// correlation of the sample with the image is computed with transforms, or directly by PointMatchDirect when a cost
+/// model expects that to be faster. Several samples, such as one for each curve, can be matched in a single pass, and
+/// the matching can be restricted to a region of the image
+class PointMatchAlgorithm : public QObject
 {
+  Q_OBJECT;
+
  public:
-  /// Single constructor
-  PointMatchAlgorithm(bool isGnuplot);
+  /// Ways of computing the correlation of the sample with the image. Both give the same convolution array
+  enum Engine {
+    ENGINE_AUTOMATIC, // Cheaper of the other two according to cheaperEngine
+    ENGINE_DIRECT, // PointMatchDirect, which is fastest for small samples
+    ENGINE_FFT // Transforms, which are fastest for large samples
+  };
+
+  /// Single constructor. The arrays, FFTW plans and image transform in the cache are reused from earlier matches
+  /// when possible, and left in the cache for later matches
+  PointMatchAlgorithm(bool isGnuplot,
+                      PointMatchCache &cache);
 
-  /// Find points that match the specified sample point pixels. They are sorted by best-to-worst match
+  /// Cost model that picks the engine with the lower estimated time for one match. The direct engine takes time
+  /// proportional to the product of the image and sample on pixel counts, and the transforms take time
+  /// proportional to the padded element count times its logarithm
+  static Engine cheaperEngine (int countOnImage,
+                               int countOnSample,
+                               int sampleRows,
+                               int width,
+                               int height,
+                               bool imageIsTransformed);
+
+  /// Find points that match the specified sample point pixels. They are sorted by best-to-worst match. If the
+  /// current thread is interrupted before the matching is finished, the list is empty
   QList<QPoint> findPoints (const QList<PointMatchPixel> &samplePointPixels,
-                            const QImage &imageProcessed,
+                            const BitPlane &bitPlaneProcessed,
                             const DocumentModelPointMatch &modelPointMatch,
                             const Points &pointsExisting);
 
+  /// Find points that match any of several samples, such as the last sample of each curve, in a single pass. The
+  /// image is loaded and transformed once, and each sample is correlated with it, so the candidates come from the
+  /// largest correlation of any sample at each position. Each candidate is assigned, through the parallel
+  /// sampleIndexes list, to the sample that scored best there, with ties going to the earlier sample. The
+  /// candidates are sorted by best-to-worst match. If the current thread is interrupted before the matching is
+  /// finished, both lists are empty
+  QList<QPoint> findPoints (const QList<QList<PointMatchPixel> > &samplesPointPixels,
+                            const BitPlane &bitPlaneProcessed,
+                            const DocumentModelPointMatch &modelPointMatch,
+                            const Points &pointsExisting,
+                            QList<int> &sampleIndexes);
+
+  /// Override the engine, which is useful for testing and benchmarking. The default is ENGINE_AUTOMATIC
+  void setEngine (Engine engine);
+
+  /// Restrict the matching to a rectangle of the image, such as the plot area, so only that rectangle is padded and
+  /// transformed. Candidates are still returned in image coordinates. A null rectangle, which is the default, means
+  /// the whole image
+  void setRegion (const QRect &region);
+
+ signals:
+  /// Send the percentage of the matching that has been completed so far
+  void signalProgress (int percent);
+
  private:
+  PointMatchAlgorithm();
 
-  // Allocate memory for an image array and phase array pair before calculations
-  void allocateMemory(double** array,
-                      fftw_complex** arrayPrime,
-                      int width,
-                      int height);
 
-  // Find each local maxima that is the largest value in a region that is:
-  //   1. as big as the the sample
-  //   2. centered about that local maxima
+  // Find each local maxima that is the largest value in its 3x3 neighborhood, keeping only the best maxCandidates
+  // of them. This is a single pass that keeps a bounded heap, so listCreated comes back sorted by descending
+  // correlation without sorting all of the maxima. This gives up, leaving listCreated incomplete, if the current
+  // thread is interrupted
   void assembleLocalMaxima(double* convolution,
                            PointMatchList& listCreated,
                            int width,
-                           int height);
+                           int height,
+                           int maxCandidates);
 
   // Compute convolution in image space from phase space image and sample arrays
   void computeConvolution(fftw_complex* imagePrime,
                           fftw_complex* samplePrime,
                           int width,
                           int height,
-                          double** convolution,
+                          double* convolution,
                           int sampleXCenter,
                           int sampleYCenter);
 
@@ -65,32 +118,76 @@ class PointMatchAlgorithm
                        int height,
                        fftw_complex* matrix);
 
+  // Correlate with PointMatchDirect into the convolution array, returning false if interrupted
+  bool correlateDirect (const QList<QPoint> &sampleOffsetsOn,
+                        const BitPlane &bitPlaneProcessed,
+                        const DocumentModelPointMatch &modelPointMatch,
+                        const Points &pointsExisting,
+                        int width,
+                        int height,
+                        double *convolution);
+
+  // Correlate with the transforms, returning false if interrupted. The convolution array belongs to the cache
+  bool correlateFft (const QList<PointMatchPixel> &samplePointPixels,
+                     const BitPlane &bitPlaneProcessed,
+                     const DocumentModelPointMatch &modelPointMatch,
+                     const Points &pointsExisting,
+                     int width,
+                     int height,
+                     double *&convolution);
+
+  // Correlate one sample with the image, using the engine from setEngine or else the cheaper engine. The
+  // convolution array is convolutionDirect or belongs to the cache, so it is only valid until the next sample.
+  // Returns false if interrupted
+  bool correlateSample (const QList<PointMatchPixel> &samplePointPixels,
+                        const BitPlane &bitPlaneProcessed,
+                        const DocumentModelPointMatch &modelPointMatch,
+                        const Points &pointsExisting,
+                        int width,
+                        int height,
+                        QVector<double> &convolutionDirect,
+                        double *&convolution);
+
   // Dump to file for 3d plotting by gnuplot
   void dumpToGnuplot (double* convolution,
                       int width,
                       int height,
                       const QString &filename) const;
 
-  // Load image and imagePrime arrays
-  void loadImage(const QImage &imageProcessed,
+  // Send the progress of the current sample, where percent runs up to PROGRESS_CONVOLUTION_COMPUTED for each
+  // sample, so the samples share that part of the overall progress equally
+  void emitProgressOfSample (int percent);
+
+  // Find points in the whole of the specified image, for findPoints
+  QList<QPoint> findPointsInImage (const QList<QList<PointMatchPixel> > &samplesPointPixels,
+                                   const BitPlane &bitPlaneProcessed,
+                                   const DocumentModelPointMatch &modelPointMatch,
+                                   const Points &pointsExisting,
+                                   QList<int> &sampleIndexes);
+
+  // Load image and imagePrime arrays of the cache
+  void loadImage(const BitPlane &bitPlaneProcessed,
                  const DocumentModelPointMatch &modelPointMatch,
                  const Points &pointsExisting,
                  int width,
-                 int height,
-                 double** image,
-                 fftw_complex** imagePrime);
+                 int height);
 
-  // Load sample and samplePrime arrays, and compute center location and extent
+  // Load sample and samplePrime arrays of the cache, and compute center location and extent
   void loadSample(const QList<PointMatchPixel> &samplePointPixels,
                   int width,
                   int height,
-                  double** sample,
-                  fftw_complex** samplePrime,
                   int* sampleXCenter,
                   int* sampleYCenter,
                   int* sampleXExtent,
                   int* sampleYExtent);
 
+  // Maximum of each convolution value in column i and its neighbors in the same column, which is the first half of
+  // a separable 3x3 maximum filter
+  void maxAlongColumn (const double *convolution,
+                       int i,
+                       int height,
+                       double *maxes) const;
+
   // Multiply corresponding elements of two matrices into a third matrix
   void multiplyMatrices(int width,
                         int height,
@@ -98,37 +195,49 @@ class PointMatchAlgorithm
                         fftw_complex* in2,
                         fftw_complex* out);
     
+  // Return true if interruption of the current thread has been requested, after logging the step being skipped
+  bool isInterrupted (const char *step) const;
+
   // Given an original array length, this method returns an array length that includes enough padding so that the
   // array length equals 2^a * 3^b * 5^c * 7^d, which optimizes the fft performance. Typical memory penalties are
   // less than 6% to get a cpu performance increase of 0% to roughly 100% or 200%
   int optimizeLengthForFft(int originalLength);
 
   // Populate image array with processed image
-  void populateImageArray(const QImage &imageProcessed,
+  void populateImageArray(const BitPlane &bitPlaneProcessed,
                           int width, int height,
-                          double** image);
+                          double* image);
 
   // Populate sample array with sample image
   void populateSampleArray(const QList<PointMatchPixel> &samplePointPixels,
                            int width,
                            int height,
-                           double** sample,
+                           double* sample,
                            int* sampleXCenter,
                            int* sampleYCenter,
                            int* sampleXExtent,
                            int* sampleYExtent);
 
-  // Release memory for one array after finishing calculations
-  void releaseImageArray(double* array);
-  void releasePhaseArray(fftw_complex* array);
-
-  // Prevent duplication of existing points. this function returns the number of pixels removed
-  void removePixelsNearExistingPoints(double* image,
-                                      int imageWidth,
-                                      int imageHeight,
+  // Prevent duplication of existing points by turning off the pixels near them
+  void removePixelsNearExistingPoints(BitPlane &bitPlane,
                                       const Points &pointsExisting,
                                       int pointSeparation);
 
+  // Position of each sample pixel in the sample array, where the sample is placed against the top left corner, and
+  // the center and extent of the sample in that array
+  void samplePositions(const QList<PointMatchPixel> &samplePointPixels,
+                       int width,
+                       int height,
+                       QList<QPoint> &positions,
+                       int* sampleXCenter,
+                       int* sampleYCenter,
+                       int* sampleXExtent,
+                       int* sampleYExtent);
+
+  // Size of the largest of the samples in the sample array, including the border around it. The padded arrays must
+  // be at least this large
+  QSize sampleSize (const QList<QList<PointMatchPixel> > &samplesPointPixels) const;
+
   // Correlate the sample point with the image, returning points in list that is sorted by correlation
   void scanImage(bool* sampleMaskArray,
                  int sampleMaskWidth,
@@ -142,6 +251,13 @@ class PointMatchAlgorithm
                  PointMatchList* pointsCreated);
 
   bool m_isGnuplot;
+  PointMatchCache &m_cache;
+  Engine m_engine;
+  QRect m_region;
+
+  // Sample being correlated, and the number of samples, for emitProgressOfSample
+  int m_sampleIndex;
+  int m_sampleCount;
 };
 
 #endif // POINT_MATCH_ALGORITHM_H
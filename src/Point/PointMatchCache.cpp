@@ -0,0 +1,260 @@
+/******************************************************************************************************
+ * (C) 2014 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#include "EngaugeAssert.h"
+#include "FftwPlannerLock.h"
+#include "Logger.h"
+#include "PointMatchCache.h"
+#include <QSettings>
+#include <QThreadPool>
+#include "Settings.h"
+
+// Planning time limit for each transform, in seconds. FFTW_MEASURE otherwise takes as long as it likes on sizes that
+// are not in the wisdom yet, while holding the FftwPlannerLock that other FFTW users wait for
+const double PLANNING_SECONDS_MAX = 2.0;
+
+// Set up the fftw3_threads library, and load the wisdom from earlier sessions, the first time they are needed. The
+// caller holds the FftwPlannerLock
+static void initializeFftw ()
+{
+  static bool initialized = false;
+  if (!initialized) {
+    if (fftw_init_threads () == 0) {
+      LOG4CPP_INFO_S ((*mainCat)) << "PointMatchCache initializeFftw failed so transforms will use one thread";
+    }
+
+    // Wisdom from earlier sessions lets FFTW_MEASURE skip the measurements for sizes that were already seen
+    QSettings settings (SETTINGS_ENGAUGE, SETTINGS_DIGITIZER);
+    settings.beginGroup (SETTINGS_GROUP_POINT_MATCH);
+    QByteArray wisdom = settings.value (SETTINGS_POINT_MATCH_FFTW_WISDOM).toByteArray();
+    settings.endGroup ();
+
+    if (!wisdom.isEmpty ()) {
+      if (fftw_import_wisdom_from_string (wisdom.constData ()) == 0) {
+        LOG4CPP_INFO_S ((*mainCat)) << "PointMatchCache initializeFftw ignoring unreadable fftw wisdom";
+      }
+    }
+
+    initialized = true;
+  }
+}
+
+PointMatchCache::PointMatchCache() :
+  m_width (0),
+  m_height (0),
+  m_image (0),
+  m_imagePrime (0),
+  m_sample (0),
+  m_samplePrime (0),
+  m_convolution (0),
+  m_convolutionPrime (0),
+  m_planImage (0),
+  m_planSample (0),
+  m_planConvolution (0),
+  m_imageIsTransformed (false),
+  m_maxPointSize (0)
+{
+}
+
+PointMatchCache::~PointMatchCache()
+{
+  clear ();
+}
+
+void PointMatchCache::clear ()
+{
+  LOG4CPP_INFO_S ((*mainCat)) << "PointMatchCache::clear";
+
+  if (m_planImage != 0) {
+    FftwPlannerLock lock;
+
+    fftw_destroy_plan (m_planImage);
+    fftw_destroy_plan (m_planSample);
+    fftw_destroy_plan (m_planConvolution);
+  }
+
+  fftw_free (m_image);
+  fftw_free (m_imagePrime);
+  fftw_free (m_sample);
+  fftw_free (m_samplePrime);
+  fftw_free (m_convolution);
+  fftw_free (m_convolutionPrime);
+
+  m_width = 0;
+  m_height = 0;
+  m_image = 0;
+  m_imagePrime = 0;
+  m_sample = 0;
+  m_samplePrime = 0;
+  m_convolution = 0;
+  m_convolutionPrime = 0;
+  m_planImage = 0;
+  m_planSample = 0;
+  m_planConvolution = 0;
+
+  m_imageIsTransformed = false;
+  m_bitPlaneProcessed = BitPlane ();
+  m_positionsExisting.clear ();
+  m_maxPointSize = 0;
+}
+
+double *PointMatchCache::convolution () const
+{
+  return m_convolution;
+}
+
+fftw_complex *PointMatchCache::convolutionPrime () const
+{
+  return m_convolutionPrime;
+}
+
+int PointMatchCache::heightPrime (int height)
+{
+  return height / 2 + 1;
+}
+
+double *PointMatchCache::image () const
+{
+  return m_image;
+}
+
+bool PointMatchCache::imageIsTransformed (const BitPlane &bitPlaneProcessed,
+                                          const Points &pointsExisting,
+                                          int maxPointSize) const
+{
+  return m_imageIsTransformed &&
+         (m_maxPointSize == maxPointSize) &&
+         (m_positionsExisting == positionsOfPoints (pointsExisting)) &&
+         (m_bitPlaneProcessed == bitPlaneProcessed);
+}
+
+fftw_complex *PointMatchCache::imagePrime () const
+{
+  return m_imagePrime;
+}
+
+QList<QPointF> PointMatchCache::positionsOfPoints (const Points &points) const
+{
+  QList<QPointF> positions;
+  for (int i = 0; i < points.size(); i++) {
+    positions << points.at(i).posScreen();
+  }
+
+  return positions;
+}
+
+void PointMatchCache::prepare (int width,
+                               int height)
+{
+  if ((width == m_width) &&
+      (height == m_height)) {
+    return;
+  }
+
+  LOG4CPP_INFO_S ((*mainCat)) << "PointMatchCache::prepare"
+                              << " width=" << width
+                              << " height=" << height;
+
+  clear ();
+
+  m_width = width;
+  m_height = height;
+
+  // Transforms of real arrays are Hermitian, so fftw stores only the nonredundant half. Allocating with fftw_malloc
+  // gives the alignment that the SIMD code paths need
+  int countPrime = width * heightPrime (height);
+
+  m_image = (double *) fftw_malloc (sizeof (double) * width * height);
+  ENGAUGE_CHECK_PTR(m_image);
+  m_imagePrime = (fftw_complex *) fftw_malloc (sizeof (fftw_complex) * countPrime);
+  ENGAUGE_CHECK_PTR(m_imagePrime);
+  m_sample = (double *) fftw_malloc (sizeof (double) * width * height);
+  ENGAUGE_CHECK_PTR(m_sample);
+  m_samplePrime = (fftw_complex *) fftw_malloc (sizeof (fftw_complex) * countPrime);
+  ENGAUGE_CHECK_PTR(m_samplePrime);
+  m_convolution = (double *) fftw_malloc (sizeof (double) * width * height);
+  ENGAUGE_CHECK_PTR(m_convolution);
+  m_convolutionPrime = (fftw_complex *) fftw_malloc (sizeof (fftw_complex) * countPrime);
+  ENGAUGE_CHECK_PTR(m_convolutionPrime);
+
+  // FFTW_MEASURE overwrites the arrays while planning, so the plans are made before anything is loaded. The thread
+  // count only applies to these plans, so the small transforms elsewhere (like Correlation) stay single threaded
+  FftwPlannerLock lock;
+
+  initializeFftw ();
+
+  fftw_plan_with_nthreads (QThreadPool::globalInstance()->maxThreadCount());
+  fftw_set_timelimit (PLANNING_SECONDS_MAX);
+
+  m_planImage = fftw_plan_dft_r2c_2d (width,
+                                      height,
+                                      m_image,
+                                      m_imagePrime,
+                                      FFTW_MEASURE);
+  m_planSample = fftw_plan_dft_r2c_2d (width,
+                                       height,
+                                       m_sample,
+                                       m_samplePrime,
+                                       FFTW_MEASURE);
+  m_planConvolution = fftw_plan_dft_c2r_2d (width,
+                                            height,
+                                            m_convolutionPrime,
+                                            m_convolution,
+                                            FFTW_MEASURE);
+
+  fftw_plan_with_nthreads (1);
+  fftw_set_timelimit (FFTW_NO_TIMELIMIT);
+
+  // Save the wisdom, which now includes this size
+  char *wisdom = fftw_export_wisdom_to_string ();
+  if (wisdom != 0) {
+    QSettings settings (SETTINGS_ENGAUGE, SETTINGS_DIGITIZER);
+    settings.beginGroup (SETTINGS_GROUP_POINT_MATCH);
+    settings.setValue (SETTINGS_POINT_MATCH_FFTW_WISDOM,
+                       QByteArray (wisdom));
+    settings.endGroup ();
+
+    fftw_free (wisdom);
+  }
+}
+
+double *PointMatchCache::sample () const
+{
+  return m_sample;
+}
+
+fftw_complex *PointMatchCache::samplePrime () const
+{
+  return m_samplePrime;
+}
+
+void PointMatchCache::transformConvolution ()
+{
+  ENGAUGE_ASSERT (m_planConvolution != 0);
+
+  fftw_execute (m_planConvolution);
+}
+
+void PointMatchCache::transformImage (const BitPlane &bitPlaneProcessed,
+                                      const Points &pointsExisting,
+                                      int maxPointSize)
+{
+  ENGAUGE_ASSERT (m_planImage != 0);
+
+  fftw_execute (m_planImage);
+
+  m_imageIsTransformed = true;
+  m_bitPlaneProcessed = bitPlaneProcessed;
+  m_positionsExisting = positionsOfPoints (pointsExisting);
+  m_maxPointSize = maxPointSize;
+}
+
+void PointMatchCache::transformSample ()
+{
+  ENGAUGE_ASSERT (m_planSample != 0);
+
+  fftw_execute (m_planSample);
+}
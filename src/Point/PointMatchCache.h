@@ -0,0 +1,103 @@
+/******************************************************************************************************
+ * (C) 2014 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#ifndef POINT_MATCH_CACHE_H
+#define POINT_MATCH_CACHE_H
+
+#include "BitPlane.h"
+#include "fftw3.h"
+#include "Points.h"
+#include <QList>
+#include <QPointF>
+
+/// Arrays, FFTW plans and image spectrum that PointMatchAlgorithm keeps from one match to the next. The arrays and
+/// plans are kept for one padded size, and only replaced when the size changes. The image spectrum is kept along
+/// with the image, existing points and point size that it was computed from, so another match on the same image
+/// only has to transform the sample and then transform the convolution back.
+///
+/// Plans are made with FFTW_MEASURE, which is slow the first time for each size, so the planning time is limited. The
+/// accumulated FFTW wisdom is saved in the settings, so later sessions can skip the measuring. The transforms are
+/// multithreaded, using as many threads as the global QThreadPool
+class PointMatchCache
+{
+public:
+  /// Single constructor
+  PointMatchCache();
+  ~PointMatchCache();
+
+  /// Release the arrays, plans and image spectrum, such as when leaving point match mode
+  void clear ();
+
+  /// Convolution array, in image space
+  double *convolution () const;
+
+  /// Convolution array, in transform space. Like the other transform space arrays, this holds width rows of
+  /// heightPrime(height) elements, since the other half of the transform of a real array is redundant
+  fftw_complex *convolutionPrime () const;
+
+  /// Number of elements in each row of a transform space array whose image space rows have height elements
+  static int heightPrime (int height);
+
+  /// Image array, in image space
+  double *image () const;
+
+  /// Return true if imagePrime already holds the transform of the image computed from the specified inputs
+  bool imageIsTransformed (const BitPlane &bitPlaneProcessed,
+                           const Points &pointsExisting,
+                           int maxPointSize) const;
+
+  /// Image array, in transform space
+  fftw_complex *imagePrime () const;
+
+  /// Allocate the arrays and make the plans, unless they already exist for this size. Any image spectrum for a
+  /// different size is dropped
+  void prepare (int width,
+                int height);
+
+  /// Sample array, in image space
+  double *sample () const;
+
+  /// Sample array, in transform space
+  fftw_complex *samplePrime () const;
+
+  /// Transform convolutionPrime back into convolution. This overwrites convolutionPrime
+  void transformConvolution ();
+
+  /// Transform image into imagePrime, and remember the inputs that the image was computed from
+  void transformImage (const BitPlane &bitPlaneProcessed,
+                       const Points &pointsExisting,
+                       int maxPointSize);
+
+  /// Transform sample into samplePrime
+  void transformSample ();
+
+private:
+
+  // Positions of the existing points, which are all that matters about them for the image
+  QList<QPointF> positionsOfPoints (const Points &points) const;
+
+  int m_width;
+  int m_height;
+
+  double *m_image;
+  fftw_complex *m_imagePrime;
+  double *m_sample;
+  fftw_complex *m_samplePrime;
+  double *m_convolution;
+  fftw_complex *m_convolutionPrime;
+
+  fftw_plan m_planImage;
+  fftw_plan m_planSample;
+  fftw_plan m_planConvolution;
+
+  // Inputs of the image spectrum in m_imagePrime, which is valid only if m_imageIsTransformed is true
+  bool m_imageIsTransformed;
+  BitPlane m_bitPlaneProcessed;
+  QList<QPointF> m_positionsExisting;
+  int m_maxPointSize;
+};
+
+#endif // POINT_MATCH_CACHE_H
@@ -0,0 +1,198 @@
+/******************************************************************************************************
+ * (C) 2014 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#include "BitPlane.h"
+#include "EngaugeAssert.h"
+#include "Logger.h"
+#include "PointMatchDirect.h"
+#include <QMap>
+#include <QtAlgorithms>
+#include <QtConcurrentMap>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+
+const int BANDS_PER_THREAD = 4; // More bands than threads evens out the load when some threads start late
+const int MIN_ROWS_PER_BAND = 32;
+const int ROWS_PER_GROUP = 8; // Eight doubles fill a cache line of a convolution column
+
+/// On sample pixels in one row of the sample, so each image row is visited once for all of them
+struct PointMatchDirectRow
+{
+  int yOffset; // Vertical offset from the sample center
+  QVector<int> xShifts; // Shift from an image pixel to the convolution position it adds to, from zero to width-1
+};
+
+/// Rows of the convolution that are computed by one QtConcurrent task
+struct PointMatchDirectBand
+{
+  const BitPlane *bitPlane;
+  const QVector<PointMatchDirectRow> *sampleRows;
+  QThread *threadRequesting; // Thread whose interruption stops the band, since the band runs in a pool thread
+  double *convolution;
+  int width;
+  int height;
+  int countOnImage;
+  int countOnSample;
+  int yStart;
+  int yStop;
+};
+
+// Value modulo length, from zero to length-1 even for negative values
+static inline int wrap (int value,
+                        int length)
+{
+  int remainder = value % length;
+  return (remainder < 0 ? remainder + length : remainder);
+}
+
+static void correlateBand (const PointMatchDirectBand &band)
+{
+  const BitPlane &bitPlane = *band.bitPlane;
+  const QVector<PointMatchDirectRow> &sampleRows = *band.sampleRows;
+  int width = band.width;
+  int height = band.height;
+  int wordsPerRow = bitPlane.wordsPerRow ();
+
+  // The image and sample are +1 for on pixels and -1 for off pixels, including the padding. Summing over all
+  // pixels, the off sample pixels contribute minus the image sum, and the on sample pixels contribute twice the
+  // image values under them. Those are +1 for each counted on pixel and -1 otherwise. The backward transform is
+  // not normalized, so the transforms give the correlation times the number of elements
+  double scale = (double) width * (double) height;
+  int imageSum = 2 * band.countOnImage - width * height;
+  int offset = 2 * band.countOnSample + imageSum;
+
+  QVector<int> counts (ROWS_PER_GROUP * width);
+
+  for (int yGroup = band.yStart; yGroup < band.yStop; yGroup += ROWS_PER_GROUP) {
+
+    if (band.threadRequesting->isInterruptionRequested ()) {
+      return;
+    }
+
+    int rowsInGroup = qMin (ROWS_PER_GROUP, band.yStop - yGroup);
+    counts.fill (0);
+
+    for (int row = 0; row < rowsInGroup; row++) {
+
+      int *countsRow = counts.data () + row * width;
+
+      for (int indexRow = 0; indexRow < sampleRows.count (); indexRow++) {
+
+        const PointMatchDirectRow &sampleRow = sampleRows.at (indexRow);
+
+        // Rows in the padding below the image are off, so they add nothing
+        int yImage = wrap (yGroup + row + sampleRow.yOffset, height);
+        if (yImage >= bitPlane.height ()) {
+          continue;
+        }
+
+        const quint32 *words = bitPlane.row (yImage);
+        const int *xShifts = sampleRow.xShifts.constData ();
+        int shiftCount = sampleRow.xShifts.count ();
+
+        for (int w = 0; w < wordsPerRow; w++) {
+
+          quint32 word = words [w];
+          while (word != 0) {
+
+            int x = 32 * w + qCountTrailingZeroBits (word);
+            word &= word - 1;
+
+            for (int shift = 0; shift < shiftCount; shift++) {
+              int xTo = x + xShifts [shift];
+              if (xTo >= width) {
+                xTo -= width;
+              }
+              ++countsRow [xTo];
+            }
+          }
+        }
+      }
+    }
+
+    // Columns of the convolution are contiguous, so the rows of the group are written together
+    for (int x = 0; x < width; x++) {
+
+      double *column = band.convolution + x * height + yGroup;
+      for (int row = 0; row < rowsInGroup; row++) {
+        column [row] = scale * (4 * counts.at (row * width + x) - offset);
+      }
+    }
+  }
+}
+
+PointMatchDirect::PointMatchDirect (const BitPlane &bitPlaneMatched,
+                                    const QList<QPoint> &sampleOffsetsOn) :
+  m_bitPlaneMatched (bitPlaneMatched),
+  m_sampleOffsetsOn (sampleOffsetsOn)
+{
+}
+
+void PointMatchDirect::correlate (double *convolution,
+                                  int width,
+                                  int height) const
+{
+  ENGAUGE_ASSERT (m_bitPlaneMatched.width () <= width);
+  ENGAUGE_ASSERT (m_bitPlaneMatched.height () <= height);
+
+  // An image pixel at x adds to the convolution at x minus the sample offset, so the shift is minus the offset
+  QMap<int, QVector<int> > xShiftsByYOffset;
+  for (int i = 0; i < m_sampleOffsetsOn.count (); i++) {
+    const QPoint &offset = m_sampleOffsetsOn.at (i);
+    xShiftsByYOffset [offset.y ()] << wrap (-offset.x (), width);
+  }
+
+  QVector<PointMatchDirectRow> sampleRows;
+  QMap<int, QVector<int> >::const_iterator itr;
+  for (itr = xShiftsByYOffset.begin (); itr != xShiftsByYOffset.end (); itr++) {
+    PointMatchDirectRow sampleRow;
+    sampleRow.yOffset = itr.key ();
+    sampleRow.xShifts = itr.value ();
+    sampleRows << sampleRow;
+  }
+
+  int threadCount = QThreadPool::globalInstance()->maxThreadCount();
+  int bandCount = 1;
+  if (threadCount > 1) {
+    bandCount = qMax (1, qMin (threadCount * BANDS_PER_THREAD,
+                               height / MIN_ROWS_PER_BAND));
+  }
+
+  LOG4CPP_INFO_S ((*mainCat)) << "PointMatchDirect::correlate"
+                              << " width=" << width
+                              << " height=" << height
+                              << " sampleOn=" << m_sampleOffsetsOn.count ()
+                              << " sampleRows=" << sampleRows.count ()
+                              << " bands=" << bandCount;
+
+  int countOnImage = m_bitPlaneMatched.countOn ();
+
+  QList<PointMatchDirectBand> bands;
+  for (int band = 0; band < bandCount; band++) {
+
+    PointMatchDirectBand directBand;
+    directBand.bitPlane = &m_bitPlaneMatched;
+    directBand.sampleRows = &sampleRows;
+    directBand.threadRequesting = QThread::currentThread ();
+    directBand.convolution = convolution;
+    directBand.width = width;
+    directBand.height = height;
+    directBand.countOnImage = countOnImage;
+    directBand.countOnSample = m_sampleOffsetsOn.count ();
+    directBand.yStart = (band * height) / bandCount;
+    directBand.yStop = ((band + 1) * height) / bandCount;
+
+    bands << directBand;
+  }
+
+  if (bandCount == 1) {
+    correlateBand (bands.first ());
+  } else {
+    QtConcurrent::blockingMap (bands,
+                               correlateBand);
+  }
+}
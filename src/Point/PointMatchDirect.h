@@ -0,0 +1,47 @@
+/******************************************************************************************************
+ * (C) 2014 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#ifndef POINT_MATCH_DIRECT_H
+#define POINT_MATCH_DIRECT_H
+
+#include <QList>
+#include <QPoint>
+
+class BitPlane;
+
+/// Correlation of a point match sample with the image, computed directly rather than with transforms. This gives
+/// the same convolution array as the transforms in PointMatchAlgorithm, including the padding, the wrap around at
+/// the edges and the scale factor of the backward transform, so the local maxima are found the same way.
+///
+/// Image and sample pixels are +1 when on and -1 when off, so the correlation at each position reduces to the
+/// number of on image pixels under the on sample pixels, plus terms that are the same everywhere. Only the on
+/// pixels of the packed image are visited, a word at a time so empty words are skipped, and each adds one to the
+/// count of every position that puts an on sample pixel over it. The cost is proportional to the product of the
+/// on pixel counts, which is much less than the cost of the transforms when the sample is small. Bands of rows are
+/// correlated concurrently by the global QThreadPool
+class PointMatchDirect
+{
+public:
+  /// Single constructor. The image has the pixels near existing points already turned off. The offsets of the on
+  /// sample pixels are relative to the sample center
+  PointMatchDirect (const BitPlane &bitPlaneMatched,
+                    const QList<QPoint> &sampleOffsetsOn);
+
+  /// Fill the width by height convolution array, which is indexed like the arrays of PointMatchAlgorithm. The
+  /// padded size must be at least the image size. This gives up, leaving the convolution incomplete, if
+  /// interruption of the current thread is requested
+  void correlate (double *convolution,
+                  int width,
+                  int height) const;
+
+private:
+  PointMatchDirect ();
+
+  const BitPlane &m_bitPlaneMatched;
+  QList<QPoint> m_sampleOffsetsOn;
+};
+
+#endif // POINT_MATCH_DIRECT_H
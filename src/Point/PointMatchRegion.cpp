@@ -0,0 +1,25 @@
+/******************************************************************************************************
+ * (C) 2014 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#include "PointMatchRegion.h"
+#include <QObject>
+
+QString pointMatchRegionToString (PointMatchRegion pointMatchRegion)
+{
+  switch (pointMatchRegion) {
+    case POINT_MATCH_REGION_IMAGE:
+      return QObject::tr ("Image");
+
+    case POINT_MATCH_REGION_AXES:
+      return QObject::tr ("Axes");
+
+    case POINT_MATCH_REGION_RECTANGLE:
+      return QObject::tr ("Rectangle");
+
+    default:
+      return QObject::tr ("Unknown");
+  }
+}
@@ -0,0 +1,23 @@
+/******************************************************************************************************
+ * (C) 2014 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#ifndef POINT_MATCH_REGION_H
+#define POINT_MATCH_REGION_H
+
+#include <QString>
+
+/// Options for the part of the image that is searched by point match. Smaller regions take proportionally less time
+/// and memory
+enum PointMatchRegion
+{
+  POINT_MATCH_REGION_IMAGE,
+  POINT_MATCH_REGION_AXES,
+  POINT_MATCH_REGION_RECTANGLE
+};
+
+extern QString pointMatchRegionToString (PointMatchRegion pointMatchRegion);
+
+#endif // POINT_MATCH_REGION_H
@@ -0,0 +1,119 @@
+/******************************************************************************************************
+ * (C) 2014 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#include "Logger.h"
+#include "PointMatchAlgorithm.h"
+#include "PointMatchThread.h"
+
+QSet<PointMatchThread*> PointMatchThread::m_threadsAbandoned;
+
+PointMatchThread::PointMatchThread(const QList<QList<PointMatchPixel> > &samplesPointPixels,
+                                   const BitPlane &bitPlaneProcessed,
+                                   const DocumentModelPointMatch &modelPointMatch,
+                                   const Points &pointsExisting,
+                                   const QRect &region,
+                                   bool isGnuplot,
+                                   QSharedPointer<PointMatchCache> cache,
+                                   int matchId) :
+  m_samplesPointPixels (samplesPointPixels),
+  m_bitPlaneProcessed (bitPlaneProcessed),
+  m_modelPointMatch (modelPointMatch),
+  m_pointsExisting (pointsExisting),
+  m_region (region),
+  m_isGnuplot (isGnuplot),
+  m_cache (cache),
+  m_matchId (matchId)
+{
+  // Delete this object in the gui thread after run returns, whether or not the match was abandoned
+  connect (this, SIGNAL (finished ()), this, SLOT (deleteLater ()));
+}
+
+PointMatchThread::~PointMatchThread()
+{
+  m_threadsAbandoned.remove (this);
+}
+
+void PointMatchThread::abandon ()
+{
+  LOG4CPP_INFO_S ((*mainCat)) << "PointMatchThread::abandon"
+                              << " matchId=" << m_matchId;
+
+  disconnect (this, SIGNAL (signalPointMatchFinished (int, QList<QPoint>, QList<int>)), 0, 0);
+  disconnect (this, SIGNAL (signalPointMatchProgress (int, int)), 0, 0);
+
+  requestInterruption ();
+
+  m_threadsAbandoned.insert (this);
+}
+
+QList<QPoint> PointMatchThread::findPoints (QList<int> &sampleIndexes)
+{
+  PointMatchAlgorithm pointMatchAlgorithm (m_isGnuplot,
+                                           *m_cache);
+  pointMatchAlgorithm.setRegion (m_region);
+
+  // The algorithm lives in this thread, so a direct connection is needed to reach slotProgress here rather than
+  // through the event loop of the gui thread that this object belongs to
+  connect (&pointMatchAlgorithm, SIGNAL (signalProgress (int)),
+           this, SLOT (slotProgress (int)), Qt::DirectConnection);
+
+  return pointMatchAlgorithm.findPoints (m_samplesPointPixels,
+                                         m_bitPlaneProcessed,
+                                         m_modelPointMatch,
+                                         m_pointsExisting,
+                                         sampleIndexes);
+}
+
+void PointMatchThread::run ()
+{
+  LOG4CPP_INFO_S ((*mainCat)) << "PointMatchThread::run"
+                              << " matchId=" << m_matchId
+                              << " samples=" << m_samplesPointPixels.count ();
+
+  QList<int> sampleIndexes;
+  QList<QPoint> candidates = findPoints (sampleIndexes);
+
+  // Release the cache in this thread. If the owner has abandoned this thread, this deletes the cache and its plans,
+  // which can wait for the FftwPlannerLock, and that should not happen in the gui thread
+  m_cache.clear ();
+
+  if (isInterruptionRequested ()) {
+
+    LOG4CPP_INFO_S ((*mainCat)) << "PointMatchThread::run cancelled"
+                                << " matchId=" << m_matchId;
+    return;
+  }
+
+  LOG4CPP_INFO_S ((*mainCat)) << "PointMatchThread::run"
+                              << " matchId=" << m_matchId
+                              << " candidates=" << candidates.count ();
+
+  emit signalPointMatchFinished (m_matchId,
+                                 candidates,
+                                 sampleIndexes);
+}
+
+void PointMatchThread::waitForAbandonedThreads ()
+{
+  // Deleting a thread removes it from the set, so the set is copied first
+  QSet<PointMatchThread*> threads = m_threadsAbandoned;
+
+  LOG4CPP_INFO_S ((*mainCat)) << "PointMatchThread::waitForAbandonedThreads"
+                              << " threads=" << threads.count ();
+
+  QSet<PointMatchThread*>::iterator itr;
+  for (itr = threads.begin (); itr != threads.end (); itr++) {
+    PointMatchThread *thread = *itr;
+    thread->wait ();
+    delete thread;
+  }
+}
+
+void PointMatchThread::slotProgress (int percent)
+{
+  emit signalPointMatchProgress (m_matchId,
+                                 percent);
+}
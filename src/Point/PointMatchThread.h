@@ -0,0 +1,93 @@
+/******************************************************************************************************
+ * (C) 2014 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#ifndef POINT_MATCH_THREAD_H
+#define POINT_MATCH_THREAD_H
+
+#include "BitPlane.h"
+#include "DocumentModelPointMatch.h"
+#include "PointMatchPixel.h"
+#include "Points.h"
+#include <QList>
+#include <QObject>
+#include <QPoint>
+#include <QRect>
+#include <QSet>
+#include <QSharedPointer>
+#include <QThread>
+
+class PointMatchCache;
+
+/// Thread that runs PointMatchAlgorithm so the gui thread stays responsive while large images are matched. Progress
+/// and the final candidate list are sent back as signals, tagged with the match identifier so the receiver can
+/// ignore signals from a match that it has since replaced.
+///
+/// The thread deletes itself once run has returned, so the owner only forgets its pointer after the candidates
+/// arrive. The match is cancelled with abandon, rather than by waiting for the thread, since FFTW planning cannot be
+/// interrupted. The cache is shared with the owner, and used by this thread until run returns, so the owner must not
+/// touch the cache until then. An owner that abandons the thread should make a new cache for the next match
+class PointMatchThread : public QThread
+{
+  Q_OBJECT;
+
+public:
+  /// Single constructor. There can be several samples, such as one for each curve, which are matched in a single
+  /// pass. The region is passed to PointMatchAlgorithm::setRegion. The inputs, except for the cache, are copied so
+  /// the caller can change them while the match runs
+  PointMatchThread(const QList<QList<PointMatchPixel> > &samplesPointPixels,
+                   const BitPlane &bitPlaneProcessed,
+                   const DocumentModelPointMatch &modelPointMatch,
+                   const Points &pointsExisting,
+                   const QRect &region,
+                   bool isGnuplot,
+                   QSharedPointer<PointMatchCache> cache,
+                   int matchId);
+  ~PointMatchThread();
+
+  /// Cancel the match without waiting for it. No more signals are delivered, and this object still deletes itself
+  /// once run has returned, which releases this thread's share of the cache
+  void abandon ();
+
+  /// Wait for the abandoned threads that are still running, and delete them. This is for shutdown, when the event
+  /// loop that would delete them has stopped, and FFTW must not be in use when the application exits
+  static void waitForAbandonedThreads ();
+
+  /// Run this thread.
+  virtual void run();
+
+signals:
+  /// Send the candidate points, sorted from best match to worst match, and the index of the sample that best
+  /// matches each candidate. This is not sent if the match was cancelled
+  void signalPointMatchFinished (int matchId,
+                                 QList<QPoint> candidates,
+                                 QList<int> sampleIndexes);
+
+  /// Send the percentage of the match that has been completed so far
+  void signalPointMatchProgress (int matchId,
+                                 int percent);
+
+private slots:
+  void slotProgress (int percent);
+
+private:
+  PointMatchThread();
+
+  QList<QPoint> findPoints (QList<int> &sampleIndexes);
+
+  QList<QList<PointMatchPixel> > m_samplesPointPixels;
+  BitPlane m_bitPlaneProcessed;
+  DocumentModelPointMatch m_modelPointMatch;
+  Points m_pointsExisting;
+  QRect m_region;
+  bool m_isGnuplot;
+  QSharedPointer<PointMatchCache> m_cache;
+  int m_matchId;
+
+  // Threads that were abandoned and have not been deleted yet. This is only used in the gui thread
+  static QSet<PointMatchThread*> m_threadsAbandoned;
+};
+
+#endif // POINT_MATCH_THREAD_H
@@ -29,8 +29,13 @@ bool PointMatchTriplet::operator<(const PointMatchTriplet &other) const
 
   if (m_correlation == other.correlation ()) {
 
-    // To reduce jumping around, we prefer points on the left when the correlations are equal
-    isLess = (m_x < other.x());
+    // To reduce jumping around, we prefer points on the left when the correlations are equal, and then points on
+    // the top so the order is complete
+    if (m_x == other.x()) {
+      isLess = (m_y < other.y());
+    } else {
+      isLess = (m_x < other.x());
+    }
 
   } else {
 
@@ -18,7 +18,8 @@ public:
                     int y,
                     double correlation);
 
-  /// Comparison operator for sorting lists of this class using qSort
+  /// Comparison operator for sorting lists of this class using qSort, or keeping them in a heap, with the best
+  /// correlation first
   bool operator<(const PointMatchTriplet &other) const;
 
   /// Get method for correlation
@@ -9,38 +9,38 @@
 
 #include <QList>
 #include <QObject>
+#include <QPoint>
 #include <QPointF>
+#include <QVector>
 
 class DocumentModelSegments;
 class QGraphicsScene;
-class QTextStream;
 class SegmentLine;
 
 /// Selectable piecewise-defined line that follows a filtered line in the image. Clicking on a
-/// Segment results in the immediate creation of multiple Points along that Segment.
+/// Segment results in the immediate creation of multiple Points along that Segment. Hovering and clicking are
+/// detected by DigitizeStateSegment using a SegmentIndex, rather than by the SegmentLine.
+///
+/// The lines are built and folded by SegmentSimplifier while the image is scanned, so a Segment starts out complete.
+/// Its lines are kept as a vector of points, and are only put into the scene, as a single SegmentLine, by createLine
 class Segment : public QObject
 { 
   Q_OBJECT;
 
 public:
-  /// Single constructor.
+  /// Single constructor. The points are the ends of the already folded lines, and the length is the total length
+  /// of the lines before folding
   Segment(QGraphicsScene &scene,
-          int yLast,
-          bool isGnuplot);
+          const QVector<QPoint> &points,
+          double length);
   ~Segment();
 
-  /// Add some more pixels in a new column to an active segment
-  void appendColumn(int x, int y, const DocumentModelSegments &modelSegments);
+  /// Create the SegmentLine that shows this segment and responds to hover and clicks. This is called once, so no
+  /// scene item is ever created for lines that get folded away
+  void createLine (const DocumentModelSegments &modelSegments);
 
-  /// Create evenly spaced points along the segment
-  QList<QPoint> fillPoints(const DocumentModelSegments &modelSegments);
-
-  /// Coordinates of first point in Segment. This info can be used to uniquely identify a Segment. This method relies
-  /// on SegmentFactory::removeEmptySegments to guarantee every Segment has at least one line
-  QPointF firstPoint () const;
-
-  /// Forward mouse press event from a component SegmentLine that was just clicked on
-  void forwardMousePress ();
+  /// Create evenly spaced points along the segment. This has no side effects so it can be called from any thread
+  QList<QPoint> fillPoints(const DocumentModelSegments &modelSegments) const;
 
   /// Get method for length in pixels
   double length() const;
@@ -48,25 +48,17 @@ public:
   /// Get method for number of lines
   int lineCount() const;
 
-  /// Try to compress a segment that was just completed, by folding together line from
-  /// point i to point i+1, with the line from i+1 to i+2, then the line from i+2 to i+3,
-  /// until one of the points is more than a half pixel from the folded line. this should
-  /// save memory and improve user interface responsiveness
-  void removeUnneededLines(int *foldedLines);
+  /// Ends of the lines, with each line starting where the previous one ended
+  const QVector<QPoint> &points () const;
 
   /// Update this segment given the new settings
   void updateModelSegment(const DocumentModelSegments &modelSegments);
 
 public slots:
 
-  /// Slot for hover enter/leave events in the associated SegmentLines
+  /// Slot for hover enter/leave, which highlights the associated SegmentLine
   void slotHover (bool hover);
 
-signals:
-
-  /// Pass mouse press event, with coordinates of first point in the Segment since that info uniquely identifies the owning Segment
-  void signalMouseClickOnSegment (QPointF posSegmentStart);
-
 private:
   Segment();
 
@@ -81,26 +73,14 @@ private:
                              double *xPrev,
                              double *yPrev,
                              double x,
-                             double y);
-
-  /// Dump pixels into gnuplot script file with embedded data, ready for input straight into gnuplot. This
-  /// method revealed, when called from removeUnneededLines, that the algorithms have to allow for cases
-  /// when lineOld->line().p2() is not equal to lineNew->line().p1(). In those cases, one Segment is ending
-  /// and another is starting
-  ///
-  /// This method does nothing unless the logging level is set to DEBUG
-  void dumpToGnuplot (QTextStream &strDump,
-                      int xInt,
-                      int yInt,
-                      const SegmentLine *lineOld,
-                      const SegmentLine *lineNew) const;
+                             double y) const;
 
   // Create evenly spaced points along the segment, with extra points to fill in corners.This algorithm is the
   // same as fillPointsWithoutFillingCorners except extra points are inserted at the corners
-  QList<QPoint> fillPointsFillingCorners(const DocumentModelSegments &modelSegments);
+  QList<QPoint> fillPointsFillingCorners(const DocumentModelSegments &modelSegments) const;
 
   // Create evenly spaced points along the segment, without extra points in corners
-  QList<QPoint> fillPointsWithoutFillingCorners(const DocumentModelSegments &modelSegments);
+  QList<QPoint> fillPointsWithoutFillingCorners(const DocumentModelSegments &modelSegments) const;
 
   // A corner is defined as a point where the incoming slope is positive and the outgoing slope is zero
   // or negative, or incoming slope is negative and the outgoing slope is zero or positive
@@ -108,27 +88,16 @@ private:
                  double yPrev,
                  double yNext) const;
 
-  // Return true if point are a half pixel or less away from a line
-  bool pointIsCloseToLine(double xLeft, double yLeft, double xInt, double yInt,
-    double xRight, double yRight);
-
-  // Return true if points are a half pixel or less away from a line
-  bool pointsAreCloseToLine(double xLeft, double yLeft, QList<QPoint> removedPoints,
-    double xRight, double yRight);
-
   QGraphicsScene &m_scene;
 
-  // Y value of last point which is in previous column
-  int m_yLast;
-
   // Total length of lines owned by this segment, as floating point to allow fractional increments
   double m_length;
 
-  // This segment is drawn as a series of line segments
-  QList<SegmentLine*> m_lines;
+  // Ends of the lines of this segment, with each line starting where the previous one ended
+  QVector<QPoint> m_points;
 
-  // True for gnuplot input files for debugging
-  bool m_isGnuplot;
+  // Graphics item that draws all of the lines, or null until createLine is called
+  SegmentLine *m_line;
 };
 
 #endif // SEGMENT_H
@@ -0,0 +1,29 @@
+/******************************************************************************************************
+ * (C) 2014 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#ifndef SEGMENT_GEOMETRY_H
+#define SEGMENT_GEOMETRY_H
+
+#include <QList>
+#include <QPoint>
+#include <QVector>
+
+/// Helper class so SegmentScan can build segments without touching a QGraphicsScene, which is only allowed in the
+/// gui thread. SegmentFactory::segmentFromGeometry turns this into a Segment.
+struct SegmentGeometry {
+  /// Ends of the lines after folding, with each line starting where the previous one ended. See SegmentSimplifier.
+  QVector<QPoint> points;
+
+  /// Total length in pixels before folding, computed exactly like Segment::length.
+  double length;
+
+  /// Number of lines that were removed by folding, for debug spew.
+  int foldedLines;
+};
+
+typedef QList<SegmentGeometry> SegmentGeometries;
+
+#endif // SEGMENT_GEOMETRY_H
@@ -0,0 +1,184 @@
+/******************************************************************************************************
+ * (C) 2014 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#include "EngaugeAssert.h"
+#include "Logger.h"
+#include <qmath.h>
+#include "Segment.h"
+#include "SegmentIndex.h"
+
+// Width and height of each cell in pixels. Smaller cells hold fewer lines but folded lines, which can be long,
+// go into more cells
+const int CELL_SIZE = 16;
+
+static double distanceSquaredToLine (const QPointF &pos,
+                                     const QPoint &p1,
+                                     const QPoint &p2)
+{
+  // Project onto the line, and move the projection to the nearer end if it falls outside the line
+  double dx = p2.x () - p1.x ();
+  double dy = p2.y () - p1.y ();
+  double vx = pos.x () - p1.x ();
+  double vy = pos.y () - p1.y ();
+
+  double lengthSquared = dx * dx + dy * dy;
+  double s = 0;
+  if (lengthSquared > 0) {
+    s = qMax (0.0, qMin (1.0, (vx * dx + vy * dy) / lengthSquared));
+  }
+
+  double ex = vx - s * dx;
+  double ey = vy - s * dy;
+
+  return ex * ex + ey * ey;
+}
+
+SegmentIndex::SegmentIndex ()
+{
+}
+
+void SegmentIndex::addLine (const Line &line)
+{
+  // Order the ends from left to right
+  double xLeft = line.p1.x (), yLeft = line.p1.y ();
+  double xRight = line.p2.x (), yRight = line.p2.y ();
+  if (xRight < xLeft) {
+    qSwap (xLeft, xRight);
+    qSwap (yLeft, yRight);
+  }
+
+  int columnLeft = cellOf (xLeft);
+  int columnRight = cellOf (xRight);
+
+  if (columnLeft == columnRight) {
+
+    // Entire line is in one column of cells, which includes vertical lines
+    addLineToColumn (line,
+                     columnLeft,
+                     qMin (yLeft, yRight),
+                     qMax (yLeft, yRight));
+
+  } else {
+
+    // Visit each column of cells, with the rows covered by the part of the line inside that column
+    double slope = (yRight - yLeft) / (xRight - xLeft);
+    for (int column = columnLeft; column <= columnRight; column++) {
+
+      double xStart = qMax (xLeft, (double) column * CELL_SIZE);
+      double xStop = qMin (xRight, (double) (column + 1) * CELL_SIZE);
+      double yStart = yLeft + slope * (xStart - xLeft);
+      double yStop = yLeft + slope * (xStop - xLeft);
+
+      addLineToColumn (line,
+                       column,
+                       qMin (yStart, yStop),
+                       qMax (yStart, yStop));
+    }
+  }
+}
+
+void SegmentIndex::addLineToColumn (const Line &line,
+                                    int column,
+                                    double yLow,
+                                    double yHigh)
+{
+  int rowStop = cellOf (yHigh);
+  for (int row = cellOf (yLow); row <= rowStop; row++) {
+    m_cells [cellKey (column, row)].append (line);
+  }
+}
+
+void SegmentIndex::addSegment (Segment *segment)
+{
+  ENGAUGE_CHECK_PTR (segment);
+
+  const QVector<QPoint> &points = segment->points ();
+  for (int index = 1; index < points.count (); index++) {
+
+    Line line;
+    line.segment = segment;
+    line.p1 = points.at (index - 1);
+    line.p2 = points.at (index);
+
+    addLine (line);
+  }
+}
+
+quint64 SegmentIndex::cellKey (int column,
+                               int row) const
+{
+  return ((quint64) (quint32) column << 32) | (quint64) (quint32) row;
+}
+
+int SegmentIndex::cellOf (double coordinate) const
+{
+  return qFloor (coordinate / CELL_SIZE);
+}
+
+void SegmentIndex::clear ()
+{
+  LOG4CPP_DEBUG_S ((*mainCat)) << "SegmentIndex::clear"
+                               << " cells=" << m_cells.count ();
+
+  m_cells.clear ();
+}
+
+Segment *SegmentIndex::nearest (const QPointF &pos,
+                                double distanceMax,
+                                const Segment *segmentOnly) const
+{
+  // Any line within distanceMax of the point passes through the square around the point, so only the cells
+  // overlapping that square are searched
+  int columnStop = cellOf (pos.x () + distanceMax);
+  int rowStop = cellOf (pos.y () + distanceMax);
+
+  Segment *segmentNearest = 0;
+  double distanceSquaredNearest = distanceMax * distanceMax;
+
+  for (int column = cellOf (pos.x () - distanceMax); column <= columnStop; column++) {
+    for (int row = cellOf (pos.y () - distanceMax); row <= rowStop; row++) {
+
+      QHash<quint64, Lines>::const_iterator itrCell = m_cells.find (cellKey (column, row));
+      if (itrCell != m_cells.end ()) {
+
+        const Lines &lines = itrCell.value ();
+        for (int index = 0; index < lines.count (); index++) {
+
+          const Line &line = lines.at (index);
+          if ((segmentOnly == 0) || (line.segment == segmentOnly)) {
+
+            double distanceSquared = distanceSquaredToLine (pos,
+                                                            line.p1,
+                                                            line.p2);
+            if (distanceSquared <= distanceSquaredNearest) {
+              distanceSquaredNearest = distanceSquared;
+              segmentNearest = line.segment;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  return segmentNearest;
+}
+
+bool SegmentIndex::segmentIsNear (const Segment *segment,
+                                  const QPointF &pos,
+                                  double distanceMax) const
+{
+  return nearest (pos,
+                  distanceMax,
+                  segment) != 0;
+}
+
+Segment *SegmentIndex::segmentNearest (const QPointF &pos,
+                                       double distanceMax) const
+{
+  return nearest (pos,
+                  distanceMax,
+                  0);
+}
@@ -0,0 +1,79 @@
+/******************************************************************************************************
+ * (C) 2014 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#ifndef SEGMENT_INDEX_H
+#define SEGMENT_INDEX_H
+
+#include <QHash>
+#include <QPoint>
+#include <QPointF>
+#include <QVector>
+
+class Segment;
+
+/// Uniform grid over the lines of Segments, for finding the Segment under the cursor. Each line is entered into the
+/// cells that it passes through, so a search only looks at the few lines near the cursor no matter how many Segments
+/// there are. This replaces hover and click detection by QGraphicsScene, which has to build and test the stroked
+/// outline of every SegmentLine near the cursor on every mouse move
+class SegmentIndex
+{
+public:
+  /// Single constructor.
+  SegmentIndex();
+
+  /// Add the lines of a Segment. The Segment must not change or be deleted until clear is called
+  void addSegment (Segment *segment);
+
+  /// Remove all Segments
+  void clear ();
+
+  /// Return true if a line of the specified Segment is within the specified distance of the point
+  bool segmentIsNear (const Segment *segment,
+                      const QPointF &pos,
+                      double distanceMax) const;
+
+  /// Return the Segment whose closest line is nearest to the point, or null if no line is within the specified
+  /// distance
+  Segment *segmentNearest (const QPointF &pos,
+                           double distanceMax) const;
+
+private:
+
+  /// Helper class so each grid cell can list the lines that pass through it
+  struct Line {
+    Segment *segment;
+    QPoint p1;
+    QPoint p2;
+  };
+
+  typedef QVector<Line> Lines;
+
+  // Add a line to every cell that it passes through
+  void addLine (const Line &line);
+
+  // Add a line to the cells of one column of cells, from yLow to yHigh
+  void addLineToColumn (const Line &line,
+                        int column,
+                        double yLow,
+                        double yHigh);
+
+  // Key of a cell in the grid
+  quint64 cellKey (int column,
+                   int row) const;
+
+  // Cell that contains a coordinate
+  int cellOf (double coordinate) const;
+
+  // Search the cells within the specified distance of the point. If segmentOnly is not null then only its lines are
+  // considered. Returns null if no line was close enough
+  Segment *nearest (const QPointF &pos,
+                    double distanceMax,
+                    const Segment *segmentOnly) const;
+
+  QHash<quint64, Lines> m_cells;
+};
+
+#endif // SEGMENT_INDEX_H
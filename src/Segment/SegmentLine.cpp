@@ -9,6 +9,7 @@
 #include "GraphicsItemType.h"
 #include "Logger.h"
 #include <QGraphicsScene>
+#include <QPainterPathStroker>
 #include <QPen>
 #include "Segment.h"
 #include "SegmentLine.h"
@@ -18,23 +19,23 @@ SegmentLine::SegmentLine(QGraphicsScene  &scene,
                          const DocumentModelSegments &modelSegments,
                          Segment *segment) :
   m_modelSegments (modelSegments),
-  m_segment (segment)
+  m_segment (segment),
+  m_shapeWidth (0)
 {
   LOG4CPP_DEBUG_S ((*mainCat)) << "SegmentLine::SegmentLine"
                                << " address=0x" << std::hex << (quintptr) this;
 
   setData (DATA_KEY_GRAPHICS_ITEM_TYPE, QVariant (GRAPHICS_ITEM_TYPE_SEGMENT));
 
-  // Make this transparent now, but always visible so hover events work
+  // Make this transparent until the cursor hovers over its Segment, as detected by DigitizeStateSegment
   scene.addItem (this);
   setPen (QPen (Qt::transparent));
   setZValue (Z_VALUE_CURVE);
   setVisible (true);
-  setAcceptHoverEvents (true);
-  setHover (false); // Initially the cursor is not hovering over this object. Later a hover event will change this state
+  setAcceptHoverEvents (false);
+  setAcceptedMouseButtons (Qt::NoButton);
+  setHover (false);
   setFlags (QGraphicsItem::ItemIsFocusable);
-
-  connect (this, SIGNAL (signalHover (bool)), segment, SLOT (slotHover (bool)));
 }
 
 SegmentLine::~SegmentLine ()
@@ -43,27 +44,6 @@ SegmentLine::~SegmentLine ()
                                << " address=0x" << std::hex << (quintptr) this;
 }
 
-void SegmentLine::hoverEnterEvent(QGraphicsSceneHoverEvent * /* event */)
-{
-  LOG4CPP_INFO_S ((*mainCat)) << "SegmentLine::hoverEnterEvent";
-
-  emit (signalHover (true));
-}
-
-void SegmentLine::hoverLeaveEvent(QGraphicsSceneHoverEvent * /* event */)
-{
-  LOG4CPP_INFO_S ((*mainCat)) << "SegmentLine::hoverLeaveEvent";
-
-  emit (signalHover (false));
-}
-
-void SegmentLine::mousePressEvent(QGraphicsSceneMouseEvent * /* event */)
-{
-  LOG4CPP_INFO_S ((*mainCat)) << "SegmentLine::mousePressEvent";
-
-  m_segment->forwardMousePress();
-}
-
 Segment *SegmentLine::segment() const
 {
   return m_segment;
@@ -85,6 +65,24 @@ void SegmentLine::setHover (bool hover)
   }
 }
 
+QPainterPath SegmentLine::shape () const
+{
+  // Same width as the pen, with a minimum of one pixel so the transparent line still has an outline
+  qreal width = qMax ((qreal) 1.0, pen().widthF ());
+
+  if ((width != m_shapeWidth) || (path () != m_shapePath)) {
+
+    QPainterPathStroker stroker;
+    stroker.setWidth (width);
+
+    m_shape = stroker.createStroke (path ());
+    m_shapePath = path ();
+    m_shapeWidth = width;
+  }
+
+  return m_shape;
+}
+
 void SegmentLine::updateModelSegment(const DocumentModelSegments &modelSegments)
 {
   LOG4CPP_INFO_S ((*mainCat)) << "SegmentLine::updateModelSegment";
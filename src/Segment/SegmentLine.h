@@ -8,13 +8,19 @@
 #define SEGMENT_LINE_H
 
 #include "DocumentModelSegments.h"
-#include <QGraphicsLineItem>
+#include <QGraphicsPathItem>
+#include <QPainterPath>
 
 class QGraphicsScene;
 class Segment;
 
-/// This class is a special case of the standard QGraphicsLineItem for segments.
-class SegmentLine : public QObject, public QGraphicsLineItem
+/// This class is a special case of the standard QGraphicsPathItem for segments. A single SegmentLine draws all of
+/// the lines of its Segment as one open polyline, which keeps the number of scene items and QObjects down to one
+/// per Segment.
+///
+/// Hover and clicks are not handled here. DigitizeStateSegment finds the Segment under the cursor with a SegmentIndex,
+/// so the scene does not have to test this item on every mouse move, and then highlights only that Segment
+class SegmentLine : public QObject, public QGraphicsPathItem
 {
   Q_OBJECT;
 
@@ -25,33 +31,30 @@ public:
               Segment *segment);
   ~SegmentLine();
 
-  /// Highlight this and all other SegmentLines belonging to the same Segment upon hover enter
-  virtual void hoverEnterEvent(QGraphicsSceneHoverEvent *event);
-
-  /// Unset highlighting triggered by hover enter
-  virtual void hoverLeaveEvent(QGraphicsSceneHoverEvent *event);
-
-  /// Create points along this curve
-  virtual void mousePressEvent(QGraphicsSceneMouseEvent *event);
-
   /// Segment that owns this line
   Segment *segment() const;
 
+  /// Outline of the stroked polyline, for scene queries. The QGraphicsPathItem outline would also include the area
+  /// enclosed by the polyline, as if it were a closed polygon. The outline is computed when first needed after the
+  /// path or pen width changes, rather than on every call
+  virtual QPainterPath shape () const;
+
   /// Apply/remove highlighting triggered by hover enter/leave
   void setHover (bool hover);
 
   /// Update this segment line with new settings
   void updateModelSegment(const DocumentModelSegments &modelSegments);
 
-signals:
-  /// Pass hover enter/leave events to Segment that owns this
-  void signalHover (bool);
-
 private:
   SegmentLine();
 
   DocumentModelSegments m_modelSegments;
   Segment *m_segment;
+
+  // Cached outline for shape, with the path and width it was computed from
+  mutable QPainterPath m_shape;
+  mutable QPainterPath m_shapePath;
+  mutable qreal m_shapeWidth;
 };
 
 #endif // SEGMENT_LINE_H
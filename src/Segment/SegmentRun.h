@@ -0,0 +1,20 @@
+/******************************************************************************************************
+ * (C) 2014 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#ifndef SEGMENT_RUN_H
+#define SEGMENT_RUN_H
+
+/// Helper class so SegmentFactory can represent each column of the filtered image as the runs of on pixels in
+/// that column, rather than one flag per pixel.
+struct SegmentRun {
+  /// First row of the run.
+  int yStart;
+
+  /// Last row of the run, inclusive.
+  int yStop;
+};
+
+#endif // SEGMENT_RUN_H
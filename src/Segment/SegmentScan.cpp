@@ -0,0 +1,314 @@
+/******************************************************************************************************
+ * (C) 2014 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#include "BitPlane.h"
+#include "EngaugeAssert.h"
+#include "gnuplot.h"
+#include <iostream>
+#include "Logger.h"
+#include <QFile>
+#include <QSet>
+#include <QtAlgorithms>
+#include <QTextStream>
+#include "SegmentScan.h"
+#include "SegmentSimplifier.h"
+
+SegmentScan::SegmentScan(const BitPlane &bitPlaneFiltered,
+                         const DocumentModelSegments &modelSegments,
+                         bool isGnuplot) :
+  m_modelSegments (modelSegments),
+  m_columns (bitPlaneFiltered.width()),
+  m_lastRuns (&m_runsOutside),
+  m_currRuns (&m_runsOutside),
+  m_nextRuns (&m_runsOutside),
+  m_x (0),
+  m_madeLines (0),
+  m_shortLines (0),
+  m_fileDump (0),
+  m_strDump (0)
+{
+  if (isGnuplot) {
+
+    QString filename ("segment.gnuplot");
+
+    std::cout << GNUPLOT_FILE_MESSAGE.toLatin1().data() << filename.toLatin1().data() << "\n";
+
+    m_fileDump = new QFile (filename);
+    m_fileDump->open (QIODevice::WriteOnly | QIODevice::Text);
+    m_strDump = new QTextStream (m_fileDump);
+  }
+
+  loadRuns (bitPlaneFiltered);
+
+  if (0 < m_columns.count ()) {
+    m_currRuns = &m_columns [0];
+  }
+  if (1 < m_columns.count ()) {
+    m_nextRuns = &m_columns [1];
+  }
+}
+
+SegmentScan::~SegmentScan()
+{
+  // Discard the segments that are still in work. Entries for finished segments were already overwritten when the
+  // columns were scrolled
+  QSet<SegmentSimplifier*> segmentsInWork;
+  for (unsigned int index = 0; index < m_lastSegment.size (); index++) {
+    if (m_lastSegment [index]) {
+      segmentsInWork.insert (m_lastSegment [index]);
+    }
+  }
+
+  qDeleteAll (segmentsInWork);
+
+  if (m_strDump != 0) {
+
+    // Final gnuplot processing
+    *m_strDump << "set terminal x11 persist\n";
+    m_fileDump->close ();
+    delete m_strDump;
+    delete m_fileDump;
+  }
+}
+
+int SegmentScan::adjacentRuns(const SegmentRuns &runs,
+                              int &index,
+                              int yStart,
+                              int yStop) const
+{
+  // Skip runs that end above yStart-1. Since the runs are sorted, they also end above the rows of any later call
+  while ((index < runs.count ()) &&
+         (runs [index].yStop < yStart - 1)) {
+    ++index;
+  }
+
+  int adjacentRuns = 0;
+  for (int i = index; (i < runs.count ()) && (runs [i].yStart <= yStop + 1); i++) {
+    ++adjacentRuns;
+  }
+
+  return adjacentRuns;
+}
+
+void SegmentScan::finishRun(int &indexLast,
+                            int &indexNext,
+                            int indexCurr,
+                            int yStart,
+                            int yStop)
+{
+  // When looking at adjacent columns, include pixels that touch diagonally since
+  // those may also diagonally touch nearby runs in the same column (which would indicate
+  // a branch)
+  int runsOnLeft = adjacentRuns (*m_lastRuns, indexLast, yStart, yStop);
+  int runsOnRight = adjacentRuns (*m_nextRuns, indexNext, yStart, yStop);
+
+  LOG4CPP_DEBUG_S ((*mainCat)) << "SegmentScan::finishRun"
+                               << " column=" << m_x
+                               << " rows=" << yStart << "-" << yStop
+                               << " runsOnLeft=" << runsOnLeft
+                               << " runsOnRight=" << runsOnRight;
+
+  // Count runs that touch on the left
+  if (runsOnLeft > 1) {
+    return;
+  }
+
+  // Count runs that touch on the right
+  if (runsOnRight > 1) {
+    return;
+  }
+
+  int y = (int) (0.5 + (yStart + yStop) / 2.0);
+
+  SegmentSimplifier *seg;
+  if ((runsOnLeft == 0) || (m_lastSegment [indexLast] == 0)) {
+
+    // This is the start of a new segment
+    seg = new SegmentSimplifier (QPoint (m_x, y),
+                                 m_strDump != 0);
+    ENGAUGE_CHECK_PTR (seg);
+
+  } else {
+
+    // This is the continuation of an existing segment, whose last line is folded right away if possible
+    seg = m_lastSegment [indexLast];
+    ENGAUGE_CHECK_PTR(seg);
+
+    ++m_madeLines;
+    seg->appendColumn (QPoint (m_x, y));
+  }
+
+  m_currSegment [indexCurr] = seg;
+}
+
+bool SegmentScan::isDone () const
+{
+  return m_x >= m_columns.count ();
+}
+
+void SegmentScan::loadRuns (const BitPlane &bitPlane)
+{
+  // A run starts at each on pixel whose upper neighbor is off, and stops at each on pixel whose lower neighbor is
+  // off, so whole words of starts and stops come from comparing each row with the rows above and below it. Rows
+  // are visited from top to bottom, so each column receives its runs in order, and a stop always belongs to the
+  // last run that was started in its column
+  for (int y = 0; y < bitPlane.height(); y++) {
+
+    const quint32 *rowPrev = (y > 0 ? bitPlane.row (y - 1) : 0);
+    const quint32 *row = bitPlane.row (y);
+    const quint32 *rowNext = (y + 1 < bitPlane.height() ? bitPlane.row (y + 1) : 0);
+
+    for (int w = 0; w < bitPlane.wordsPerRow(); w++) {
+
+      quint32 word = row [w];
+      if (word != 0) {
+
+        quint32 starts = word & ~(rowPrev != 0 ? rowPrev [w] : 0);
+        for (int x = 32 * w; starts != 0; x++, starts >>= 1) {
+          if (starts & 1) {
+            SegmentRun run;
+            run.yStart = y;
+            run.yStop = y;
+            m_columns [x].append (run);
+          }
+        }
+
+        quint32 stops = word & ~(rowNext != 0 ? rowNext [w] : 0);
+        for (int x = 32 * w; stops != 0; x++, stops >>= 1) {
+          if (stops & 1) {
+            m_columns [x].last ().yStop = y;
+          }
+        }
+      }
+    }
+  }
+}
+
+int SegmentScan::madeLines () const
+{
+  return m_madeLines;
+}
+
+void SegmentScan::matchRunsToSegments(SegmentGeometries &geometries)
+{
+  m_currSegment.assign (m_currRuns->count (),
+                        0);
+
+  // The runs of the current column move down monotonically, so the searches of the adjacent columns only move down too
+  int indexLast = 0, indexNext = 0;
+  for (int indexCurr = 0; indexCurr < m_currRuns->count (); indexCurr++) {
+
+    const SegmentRun &run = m_currRuns->at (indexCurr);
+    finishRun(indexLast,
+              indexNext,
+              indexCurr,
+              run.yStart,
+              run.yStop);
+  }
+
+  removeUnneededLines(geometries);
+}
+
+void SegmentScan::removeUnneededLines(SegmentGeometries &geometries)
+{
+  LOG4CPP_DEBUG_S ((*mainCat)) << "SegmentScan::removeUnneededLines";
+
+  // Segments that are still in work since they continue into the current column
+  QSet<SegmentSimplifier*> segmentsInCurr;
+  for (unsigned int indexCurr = 0; indexCurr < m_currSegment.size (); indexCurr++) {
+    if (m_currSegment [indexCurr]) {
+      segmentsInCurr.insert (m_currSegment [indexCurr]);
+    }
+  }
+
+  SegmentSimplifier *segLast = 0;
+  for (unsigned int indexLast = 0; indexLast < m_lastSegment.size (); indexLast++) {
+
+    if (m_lastSegment [indexLast] && (m_lastSegment [indexLast] != segLast)) {
+
+      segLast = m_lastSegment [indexLast];
+
+      // If the segment is found in the current column then it is still in work so postpone processing
+      if (!segmentsInCurr.contains (segLast)) {
+
+        ENGAUGE_CHECK_PTR(segLast);
+        if (segLast->length () < (m_modelSegments.minLength() - 1) * m_modelSegments.pointSeparation()) {
+
+          // Remove whole segment since it is too short
+          m_shortLines += segLast->lineCount ();
+
+        } else {
+
+          // Add to the output array since it is done and sufficiently long
+          segLast->finish ();
+
+          if (m_strDump != 0) {
+            segLast->dumpToGnuplot (*m_strDump);
+          }
+
+          SegmentGeometry geometry;
+          geometry.points = segLast->points ();
+          geometry.length = segLast->length ();
+          geometry.foldedLines = segLast->foldedLines ();
+          geometries.append (geometry);
+
+        }
+
+        delete segLast;
+      }
+    }
+  }
+}
+
+void SegmentScan::scanColumns (int columnCount,
+                               SegmentGeometries &geometries)
+{
+  // For each new column of pixels, loop through the runs. a run is defined as
+  // one or more colored pixels that are all touching, with one uncolored pixel or the
+  // image boundary at each end of the set. for each set in the current column, count
+  // the number of runs it touches in the adjacent (left and right) columns. here is
+  // the pseudocode:
+  //   if ((L > 1) || (R > 1))
+  //     "this run is at a branch point so ignore the set"
+  //   else
+  //     if (L == 0)
+  //       "this run is the start of a new segment"
+  //     else
+  //       "this run is appended to the segment on the left
+  int xStop = qMin (m_x + columnCount,
+                    m_columns.count ());
+
+  for (; m_x < xStop; m_x++) {
+
+    matchRunsToSegments (geometries);
+
+    // Get ready for next column, which is m_x + 1, so the column to its right is m_x + 2. The per pixel loop that
+    // this replaced loaded m_x + 1 here, so each column was compared with itself rather than its right neighbor
+    m_lastRuns = m_currRuns;
+    m_currRuns = m_nextRuns;
+    if (m_x + 2 < m_columns.count ()) {
+      m_nextRuns = &m_columns [m_x + 2];
+    } else {
+      m_nextRuns = &m_runsOutside;
+    }
+    m_lastSegment.swap (m_currSegment);
+  }
+}
+
+int SegmentScan::shortLines () const
+{
+  return m_shortLines;
+}
+
+int SegmentScan::width () const
+{
+  return m_columns.count ();
+}
+
+int SegmentScan::x () const
+{
+  return m_x;
+}
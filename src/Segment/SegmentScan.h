@@ -0,0 +1,118 @@
+/******************************************************************************************************
+ * (C) 2014 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#ifndef SEGMENT_SCAN_H
+#define SEGMENT_SCAN_H
+
+#include "DocumentModelSegments.h"
+#include "SegmentGeometry.h"
+#include "SegmentRun.h"
+#include <QVector>
+#include <vector>
+
+class BitPlane;
+class QFile;
+class QTextStream;
+class SegmentSimplifier;
+
+typedef std::vector<SegmentSimplifier*> SegmentVector;
+
+typedef QVector<SegmentRun> SegmentRuns; // Runs of one column, from top to bottom
+
+/// Column by column scan of the filtered image that finds the segments, for SegmentFactory. The scan can be advanced a
+/// few columns at a time, with each step returning the segments that were finished in those columns. Nothing here
+/// touches a QGraphicsScene, so the scan can run in a worker thread (see SegmentScanThread).
+///
+/// Each column is represented by its runs of on pixels, which are extracted from the packed rows of the filtered image
+/// in a single pass. Finding the runs that touch a run in an adjacent column is then a merge of two sorted lists of
+/// intervals, so the cost is proportional to the number of runs rather than the number of pixels.
+///
+/// Lines are folded by SegmentSimplifier as each column is appended, so finished segments are already simplified
+class SegmentScan
+{
+public:
+  /// Single constructor. The runs of all columns are extracted here. The folds are dumped into a gnuplot script if
+  /// isGnuplot is true
+  SegmentScan(const BitPlane &bitPlaneFiltered,
+              const DocumentModelSegments &modelSegments,
+              bool isGnuplot);
+  ~SegmentScan();
+
+  /// True after the last column has been scanned
+  bool isDone () const;
+
+  /// Number of lines appended to segments so far, for debug spew
+  int madeLines () const;
+
+  /// Scan the next columns, up to the right side of the image. Segments that finish and are long enough are appended
+  /// to geometries. Segments that are still in work when the last column is scanned are discarded
+  void scanColumns (int columnCount,
+                    SegmentGeometries &geometries);
+
+  /// Number of lines discarded since their segments were too short, for debug spew
+  int shortLines () const;
+
+  /// Number of columns, which is the width of the image
+  int width () const;
+
+  /// Next column to be scanned
+  int x () const;
+
+private:
+  SegmentScan();
+
+  // Return the number of runs adjacent to the pixels from yStart to yStop (inclusive). Diagonal neighbors count, so
+  // these are the runs that overlap yStart-1 to yStop+1. On input, index is the first run that might overlap, and
+  // it must not decrease from one call to the next for the same column. On output, index is the first overlapping run
+  int adjacentRuns(const SegmentRuns &runs,
+                   int &index,
+                   int yStart,
+                   int yStop) const;
+
+  // Process a run of pixels. If there are fewer than two adjacent pixel runs on
+  // either side, this run will be added to an existing segment, or the start of
+  // a new segment
+  void finishRun(int &indexLast,
+                 int &indexNext,
+                 int indexCurr,
+                 int yStart,
+                 int yStop);
+
+  // Extract the runs of every column from the rows of the image
+  void loadRuns (const BitPlane &bitPlane);
+
+  // Identify the runs in the current column, and connect them to segments
+  void matchRunsToSegments (SegmentGeometries &geometries);
+
+  // Remove segments that just finished in the previous column, keeping only those that are long enough
+  void removeUnneededLines(SegmentGeometries &geometries);
+
+  DocumentModelSegments m_modelSegments;
+
+  QVector<SegmentRuns> m_columns;
+  SegmentRuns m_runsOutside; // Column beyond either side of the image, which has no runs
+
+  // Columns are scrolled by pointer
+  const SegmentRuns *m_lastRuns;
+  const SegmentRuns *m_currRuns;
+  const SegmentRuns *m_nextRuns;
+
+  // One entry per run in m_lastRuns and m_currRuns
+  SegmentVector m_lastSegment;
+  SegmentVector m_currSegment;
+
+  int m_x;
+
+  // Statistics that show up in debug spew
+  int m_madeLines;
+  int m_shortLines; // Lines rejected since their segments are too short
+
+  // Gnuplot input file for debugging, or null
+  QFile *m_fileDump;
+  QTextStream *m_strDump;
+};
+
+#endif // SEGMENT_SCAN_H
@@ -0,0 +1,59 @@
+/******************************************************************************************************
+ * (C) 2014 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#include "Logger.h"
+#include "SegmentScan.h"
+#include "SegmentScanThread.h"
+
+// Columns scanned between checks for interruption and batches of finished segments. Small enough that segments
+// appear smoothly and each batch is quick to turn into scene items, large enough to keep the signal traffic low
+const int COLUMNS_PER_BATCH = 32;
+
+SegmentScanThread::SegmentScanThread(const BitPlane &bitPlaneFiltered,
+                                     const DocumentModelSegments &modelSegments,
+                                     bool isGnuplot,
+                                     int scanId) :
+  m_bitPlaneFiltered (bitPlaneFiltered),
+  m_modelSegments (modelSegments),
+  m_isGnuplot (isGnuplot),
+  m_scanId (scanId)
+{
+}
+
+void SegmentScanThread::run ()
+{
+  LOG4CPP_INFO_S ((*mainCat)) << "SegmentScanThread::run"
+                              << " scanId=" << m_scanId;
+
+  SegmentScan scan (m_bitPlaneFiltered,
+                    m_modelSegments,
+                    m_isGnuplot);
+
+  while (!scan.isDone ()) {
+
+    if (isInterruptionRequested ()) {
+
+      LOG4CPP_INFO_S ((*mainCat)) << "SegmentScanThread::run cancelled"
+                                  << " scanId=" << m_scanId
+                                  << " column=" << scan.x ();
+      return;
+    }
+
+    SegmentGeometries geometries;
+    scan.scanColumns (COLUMNS_PER_BATCH,
+                      geometries);
+
+    if (geometries.count () > 0) {
+      emit signalSegmentsFinished (m_scanId,
+                                   geometries);
+    }
+  }
+
+  LOG4CPP_INFO_S ((*mainCat)) << "SegmentScanThread::run"
+                              << " scanId=" << m_scanId
+                              << " linesCreated=" << scan.madeLines ()
+                              << " linesTooShortSoRemoved=" << scan.shortLines ();
+}
@@ -0,0 +1,50 @@
+/******************************************************************************************************
+ * (C) 2014 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#ifndef SEGMENT_SCAN_THREAD_H
+#define SEGMENT_SCAN_THREAD_H
+
+#include "BitPlane.h"
+#include "DocumentModelSegments.h"
+#include <QObject>
+#include "SegmentGeometry.h"
+#include <QThread>
+
+/// Thread that scans the filtered image for segments so the gui thread stays responsive on large images. The
+/// finished segments are sent back in batches as the scan moves across the image, and the receiver creates the
+/// Segments (which add items to the scene) in the gui thread using SegmentFactory::segmentFromGeometry.
+///
+/// The scan is cancelled with QThread::requestInterruption. Batches that were already sent are tagged with the scan
+/// identifier, so the receiver can ignore batches from a scan that it has since replaced
+class SegmentScanThread : public QThread
+{
+  Q_OBJECT;
+
+public:
+  /// Single constructor. The inputs are copied so the caller can change them while the scan runs
+  SegmentScanThread(const BitPlane &bitPlaneFiltered,
+                    const DocumentModelSegments &modelSegments,
+                    bool isGnuplot,
+                    int scanId);
+
+  /// Run this thread.
+  virtual void run();
+
+signals:
+  /// Send segments that were finished in the latest columns. Empty batches are not sent
+  void signalSegmentsFinished (int scanId,
+                               SegmentGeometries geometries);
+
+private:
+  SegmentScanThread();
+
+  BitPlane m_bitPlaneFiltered;
+  DocumentModelSegments m_modelSegments;
+  bool m_isGnuplot;
+  int m_scanId;
+};
+
+#endif // SEGMENT_SCAN_THREAD_H
@@ -0,0 +1,248 @@
+/******************************************************************************************************
+ * (C) 2014 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#include "Logger.h"
+#include <qmath.h>
+#include <QString>
+#include <QTextStream>
+#include "SegmentSimplifier.h"
+
+// Directions are only trusted when they are farther than this from either end of the interval. Distances of
+// integer points from lines through integer points are never exactly half a pixel, and floating point errors in
+// the angles are many orders of magnitude smaller than this, so this only sends real near misses to the exact check
+const double ANGLE_EPSILON = 1.0e-9;
+
+SegmentSimplifier::SegmentSimplifier(const QPoint &pointStart,
+                                     bool isGnuplot) :
+  m_count (1),
+  m_foldedLines (0),
+  m_length (0),
+  m_isGnuplot (isGnuplot)
+{
+  m_points.append (pointStart);
+
+  resetInterval ();
+}
+
+void SegmentSimplifier::appendColumn (const QPoint &point)
+{
+  // Update total length using distance formula, exactly as the lines are appended
+  int yLast = m_points.last ().y ();
+  int y = point.y ();
+  m_length += qSqrt((1.0) * (1.0) + (y - yLast) * (y - yLast));
+
+  appendPoint (point);
+  ++m_count;
+}
+
+void SegmentSimplifier::appendPoint (const QPoint &pointRight)
+{
+  if (m_points.count () < 2) {
+
+    // First line
+    m_points.append (pointRight);
+    return;
+  }
+
+  const QPoint &pointLeft = m_points.at (m_points.count () - 2);
+  const QPoint &pointInt = m_points.last ();
+
+  // The intermediate point joins the folded points for this check
+  double angleLow = m_angleLow;
+  double angleHigh = m_angleHigh;
+  narrowInterval (pointLeft,
+                  pointInt,
+                  angleLow,
+                  angleHigh);
+
+  double angle = qAtan2 (pointRight.y () - pointLeft.y (),
+                         pointRight.x () - pointLeft.x ());
+
+  bool isClose;
+  if ((angle - angleLow > ANGLE_EPSILON) && (angleHigh - angle > ANGLE_EPSILON)) {
+    isClose = true;
+  } else if ((angleLow - angle > ANGLE_EPSILON) || (angle - angleHigh > ANGLE_EPSILON)) {
+    isClose = false;
+  } else {
+    isClose = pointsAreCloseToLine (pointRight);
+  }
+
+  if (isClose) {
+
+    if (m_isGnuplot) {
+      FoldEvent event;
+      event.lineOld = QLine (pointLeft, pointInt);
+      event.lineNew = QLine (pointInt, pointRight);
+      m_foldEvents.append (event);
+    }
+
+    // Remove intermediate point, which stretches the new line back to the left point
+    ++m_foldedLines;
+
+    m_pointsRemoved.append (pointInt);
+    m_angleLow = angleLow;
+    m_angleHigh = angleHigh;
+    m_points.last () = pointRight;
+
+  } else {
+
+    // Keeping this intermediate point and clear out the removed points
+    resetInterval ();
+    m_points.append (pointRight);
+
+  }
+}
+
+void SegmentSimplifier::dumpToGnuplot (QTextStream &strDump) const
+{
+  // Only show this dump spew when logging is opened up completely
+  if (mainCat->getPriority() == log4cpp::Priority::DEBUG) {
+
+    QList<FoldEvent>::const_iterator itr;
+    for (itr = m_foldEvents.begin (); itr != m_foldEvents.end (); itr++) {
+
+      const QLine &lineOld = itr->lineOld;
+      const QLine &lineNew = itr->lineNew;
+      int xInt = lineOld.x2 ();
+      int yInt = lineOld.y2 ();
+
+      // Show "before" and "after" line info. Note that the merged line starts with lineOld.p1()
+      // and ends with lineNew.p2()
+      QString label = QString ("Old: (%1,%2) to (%3,%4), New: (%5,%6) to (%7,%8)")
+                      .arg (lineOld.x1())
+                      .arg (lineOld.y1())
+                      .arg (lineOld.x2())
+                      .arg (lineOld.y2())
+                      .arg (lineNew.x1())
+                      .arg (lineNew.y1())
+                      .arg (lineNew.x2())
+                      .arg (lineNew.y2());
+
+      strDump << "unset label\n";
+      strDump << "set label \"" << label << "\" at graph 0, graph 0.02\n";
+      strDump << "set grid xtics\n";
+      strDump << "set grid ytics\n";
+
+      // Horizontal and vertical width is computed so merged line mostly fills the plot window,
+      // and (xInt,yInt) is at the center
+      int halfWidthX = 1.5 * qMax (qAbs (lineOld.dx()),
+                                   qAbs (lineNew.dx()));
+      int halfWidthY = 1.5 * qMax (qAbs (lineOld.dy()),
+                                   qAbs (lineNew.dy()));
+
+      // Zoom in so changes are easier to see
+      strDump << "set xrange [" << (xInt - halfWidthX - 1) << ":" << (xInt + halfWidthX + 1) << "]\n";
+      strDump << "set yrange [" << (yInt - halfWidthY - 1) << ":" << (yInt + halfWidthY + 1) << "]\n";
+
+      // One small curve shows xInt as horizontal line, and another shows yInt as vertical line.
+      // A small curve shows the replacement line, and the last curve shows the folded Segment
+      strDump << "plot \\\n"
+              << "\"-\" title \"\" with lines, \\\n"
+              << "\"-\" title \"\" with lines, \\\n"
+              << "\"-\" title \"Replacement\" with lines, \\\n"
+              << "\"-\" title \"Folded segment\" with linespoints\n"
+              << xInt << " " << (yInt - halfWidthY) << "\n"
+              << xInt << " " << (yInt + halfWidthY) << "\n"
+              << "end\n"
+              << (xInt - halfWidthX) << " " << yInt << "\n"
+              << (xInt + halfWidthY) << " " << yInt << "\n"
+              << "end\n"
+              << lineOld.x1() << " " << lineOld.y1() << "\n"
+              << lineNew.x2() << " " << lineNew.y2() << "\n"
+              << "end\n";
+
+      QVector<QPoint>::const_iterator itrPoint;
+      for (itrPoint = m_points.begin (); itrPoint != m_points.end (); itrPoint++) {
+        strDump << itrPoint->x () << " " << itrPoint->y () << "\n";
+      }
+
+      strDump << "end\n";
+      strDump << "pause -1 \"Hit Enter to continue\"\n";
+      strDump << flush;
+    }
+  }
+}
+
+void SegmentSimplifier::finish ()
+{
+  LOG4CPP_DEBUG_S ((*mainCat)) << "SegmentSimplifier::finish"
+                               << " points=" << m_count
+                               << " folded=" << m_foldedLines;
+
+  // Release memory that is no longer needed
+  m_pointsRemoved.clear ();
+  m_points.squeeze ();
+}
+
+int SegmentSimplifier::foldedLines () const
+{
+  return m_foldedLines;
+}
+
+double SegmentSimplifier::length () const
+{
+  return m_length;
+}
+
+int SegmentSimplifier::lineCount () const
+{
+  return m_count - 1;
+}
+
+void SegmentSimplifier::narrowInterval (const QPoint &pointLeft,
+                                        const QPoint &point,
+                                        double &angleLow,
+                                        double &angleHigh) const
+{
+  // Points are to the right of the left point, so these angles are between -pi/2 and pi/2. A line at angle a through
+  // the left point passes within half a pixel of the point when |sin(a-angle)|*distance < 1/2
+  double dx = point.x () - pointLeft.x ();
+  double dy = point.y () - pointLeft.y ();
+  double angle = qAtan2 (dy, dx);
+  double halfWidth = qAsin (0.5 / qSqrt (dx * dx + dy * dy));
+
+  angleLow = qMax (angleLow, angle - halfWidth);
+  angleHigh = qMin (angleHigh, angle + halfWidth);
+}
+
+bool SegmentSimplifier::pointsAreCloseToLine (const QPoint &pointRight) const
+{
+  // A point is less than half a pixel from the line when twice the cross product is less than the line length. Since
+  // every point is strictly between the ends in x, its projection onto the line is between the ends whenever it is
+  // that close, so this is the same as measuring the distance to the line segment
+  const QPoint &pointLeft = m_points.at (m_points.count () - 2);
+  qint64 dx = pointRight.x () - pointLeft.x ();
+  qint64 dy = pointRight.y () - pointLeft.y ();
+  quint64 lengthSquared = (quint64) (dx * dx + dy * dy);
+
+  for (int index = 0; index <= m_pointsRemoved.count (); index++) {
+
+    const QPoint &point = (index < m_pointsRemoved.count () ? m_pointsRemoved.at (index) : m_points.last ());
+
+    qint64 cross = dx * (point.y () - pointLeft.y ()) - dy * (point.x () - pointLeft.x ());
+    quint64 crossAbs = (quint64) qAbs (cross);
+
+    // Large cross products are far from the line, and are rejected before squaring them could overflow
+    if ((crossAbs > 0x7fffffff) ||
+        (4 * crossAbs * crossAbs >= lengthSquared)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+const QVector<QPoint> &SegmentSimplifier::points () const
+{
+  return m_points;
+}
+
+void SegmentSimplifier::resetInterval ()
+{
+  m_pointsRemoved.clear ();
+  m_angleLow = -M_PI;
+  m_angleHigh = M_PI;
+}
@@ -0,0 +1,96 @@
+/******************************************************************************************************
+ * (C) 2014 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#ifndef SEGMENT_SIMPLIFIER_H
+#define SEGMENT_SIMPLIFIER_H
+
+#include <QLine>
+#include <QList>
+#include <QPoint>
+#include <QVector>
+
+class QTextStream;
+
+/// Segment that is still being built by SegmentScan, which folds its lines as each new column arrives so no second
+/// pass is needed when the segment finishes. A line from point i to point i+1 is folded with the line from i+1 to
+/// i+2 when every point between the two ends is less than half a pixel from the folded line.
+///
+/// Rather than checking every folded point again for each new point, the directions (from the left end) that pass
+/// within half a pixel of all folded points are kept as an interval of angles, so each new point is accepted or
+/// rejected in constant time. Only points very close to the edge of the interval are checked exactly, point by point.
+///
+/// Unlike the QList based algorithm that Segment previously used, every line is checked for folding. That algorithm
+/// erased lines from the list while iterating over it, and skipped some lines near the end of long segments
+class SegmentSimplifier
+{
+public:
+  /// Single constructor. The segment starts at the center of a run. Fold events are only kept for the gnuplot
+  /// dump if isGnuplot is true
+  SegmentSimplifier(const QPoint &pointStart,
+                    bool isGnuplot);
+
+  /// Add the center of the run in the next column
+  void appendColumn (const QPoint &point);
+
+  /// Dump the folds into a gnuplot script, for debugging. This is called after finish
+  void dumpToGnuplot (QTextStream &strDump) const;
+
+  /// Release the memory that is only needed while columns are appended
+  void finish ();
+
+  /// Number of lines removed by folding
+  int foldedLines () const;
+
+  /// Total length in pixels of the lines before folding, which does not change when lines are folded
+  double length () const;
+
+  /// Number of lines appended, before folding
+  int lineCount () const;
+
+  /// Ends of the folded lines. Each line starts where the previous one ended
+  const QVector<QPoint> &points () const;
+
+private:
+  SegmentSimplifier();
+
+  /// Helper class for the gnuplot dump
+  struct FoldEvent {
+    QLine lineOld;
+    QLine lineNew;
+  };
+
+  // Add the new point to m_points, folding the last line if possible
+  void appendPoint (const QPoint &pointRight);
+
+  // Narrow the interval of good directions from the left point to also pass within half a pixel of the point
+  void narrowInterval (const QPoint &pointLeft,
+                       const QPoint &point,
+                       double &angleLow,
+                       double &angleHigh) const;
+
+  // Exact check of the folded points and the intermediate point against the line to the right point
+  bool pointsAreCloseToLine (const QPoint &pointRight) const;
+
+  // Forget the folded points after a line is kept
+  void resetInterval ();
+
+  QVector<QPoint> m_points;
+
+  // Points folded since the current left point, m_points [count - 2], and the interval of directions from the left
+  // point that pass within half a pixel of them
+  QVector<QPoint> m_pointsRemoved;
+  double m_angleLow;
+  double m_angleHigh;
+
+  int m_count; // Points appended, including the start point
+  int m_foldedLines;
+  double m_length;
+
+  bool m_isGnuplot;
+  QList<FoldEvent> m_foldEvents;
+};
+
+#endif // SEGMENT_SIMPLIFIER_H
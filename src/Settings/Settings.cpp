@@ -88,3 +88,7 @@ const QString SETTINGS_GROUP_EXPORT ("Export");
 // Dialogs for import cropping group
 const QString SETTINGS_GROUP_IMPORT_CROPPING ("ImportCropping");
 const QString SETTINGS_IMPORT_CROPPING_POS ("pos");
+
+// Point match group
+const QString SETTINGS_GROUP_POINT_MATCH ("PointMatch");
+const QString SETTINGS_POINT_MATCH_FFTW_WISDOM ("fftwWisdom");
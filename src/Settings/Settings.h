@@ -53,6 +53,7 @@ extern const QString SETTINGS_GROUP_GENERAL;
 extern const QString SETTINGS_GROUP_IMPORT;
 extern const QString SETTINGS_GROUP_IMPORT_CROPPING;
 extern const QString SETTINGS_GROUP_MAIN_WINDOW;
+extern const QString SETTINGS_GROUP_POINT_MATCH;
 extern const QString SETTINGS_HELP_POS;
 extern const QString SETTINGS_HELP_SIZE;
 extern const QString SETTINGS_HIGHLIGHT_OPACITY;
@@ -63,6 +64,7 @@ extern const QString SETTINGS_LOCALE_COUNTRY;
 extern const QString SETTINGS_LOCALE_LANGUAGE;
 extern const QString SETTINGS_MAIN_TITLE_BAR_FORMAT;
 extern const QString SETTINGS_MAXIMUM_GRID_LINES;
+extern const QString SETTINGS_POINT_MATCH_FFTW_WISDOM;
 extern const QString SETTINGS_POS;
 extern const QString SETTINGS_RECENT_FILE_LIST;
 extern const QString SETTINGS_SIGNIFICANT_DIGITS;
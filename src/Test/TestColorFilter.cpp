@@ -0,0 +1,420 @@
+#include "BitPlane.h"
+#include "ColorFilter.h"
+#include "ColorFilterEngine.h"
+#include "ColorFilterEntry.h"
+#include "ColorFilterHistogram.h"
+#include "ColorFilterStrategyForeground.h"
+#include "ColorFilterStrategyHue.h"
+#include "ColorFilterStrategyIntensity.h"
+#include "ColorFilterStrategySaturation.h"
+#include "ColorFilterStrategyValue.h"
+#include "Logger.h"
+#include "MainWindow.h"
+#include <QImage>
+#include <QList>
+#include <QPair>
+#include <QThread>
+#include <QtTest/QtTest>
+#include "Test/TestColorFilter.h"
+
+QTEST_MAIN (TestColorFilter)
+
+const QString BENCHMARK_IMAGE ("../samples/gnuplot_x_y_lines_grid.png");
+
+TestColorFilter::TestColorFilter(QObject *parent) :
+  QObject(parent)
+{
+}
+
+void TestColorFilter::benchmarkFilterImagePixelLoop ()
+{
+  QDir::setCurrent (QApplication::applicationDirPath());
+
+  QImage img (BENCHMARK_IMAGE);
+  QImage imageFiltered (img.width (),
+                        img.height (),
+                        QImage::Format_RGB32);
+
+  ColorFilter filter;
+  QRgb rgbBackground = filter.marginColor (&img);
+
+  QBENCHMARK {
+    filterImageByPixel (filter,
+                        img,
+                        imageFiltered,
+                        COLOR_FILTER_MODE_INTENSITY,
+                        0.0,
+                        0.5,
+                        rgbBackground);
+  }
+}
+
+void TestColorFilter::benchmarkFilterImageScanline ()
+{
+  benchmarkFilterImageScanlineThreads (1);
+}
+
+void TestColorFilter::benchmarkFilterImageScanlineAllThreads ()
+{
+  benchmarkFilterImageScanlineThreads (QThread::idealThreadCount ());
+}
+
+void TestColorFilter::benchmarkFilterImageScanlineThreads (int threadCount)
+{
+  QDir::setCurrent (QApplication::applicationDirPath());
+
+  QImage img (BENCHMARK_IMAGE);
+  QImage imageFiltered (img.width (),
+                        img.height (),
+                        QImage::Format_RGB32);
+
+  ColorFilter filter;
+  QRgb rgbBackground = filter.marginColor (&img);
+
+  QBENCHMARK {
+    filter.filterImage (img,
+                        imageFiltered,
+                        COLOR_FILTER_MODE_INTENSITY,
+                        0.0,
+                        0.5,
+                        rgbBackground,
+                        threadCount);
+  }
+}
+
+void TestColorFilter::cleanupTestCase ()
+{
+}
+
+void TestColorFilter::filterImageByPixel (const ColorFilter &filter,
+                                          const QImage &imageOriginal,
+                                          QImage &imageFiltered,
+                                          ColorFilterMode colorFilterMode,
+                                          double low,
+                                          double high,
+                                          QRgb rgbBackground) const
+{
+  // Original per-pixel algorithm, which serves as the reference
+  for (int x = 0; x < imageOriginal.width(); x++) {
+    for (int y = 0; y < imageOriginal.height (); y++) {
+
+      QColor pixel = imageOriginal.pixel (x, y);
+      bool isOn = false;
+      if (pixel.rgb() != rgbBackground) {
+
+        isOn = filter.pixelUnfilteredIsOn (colorFilterMode,
+                                           pixel,
+                                           rgbBackground,
+                                           low,
+                                           high);
+      }
+
+      imageFiltered.setPixel (x, y, (isOn ?
+                                     QColor (Qt::black).rgb () :
+                                     QColor (Qt::white).rgb ()));
+    }
+  }
+}
+
+void TestColorFilter::initTestCase ()
+{
+  const QString NO_ERROR_REPORT_LOG_FILE;
+  const QString NO_REGRESSION_OPEN_FILE;
+  const bool NO_GNUPLOT_LOG_FILES = false;
+  const bool NO_REGRESSION_IMPORT = false;
+  const bool NO_RESET = false;
+  const bool NO_EXPORT_ONLY = false;
+  const bool NO_EXTRACT_IMAGE_ONLY = false;
+  const QString NO_EXTRACT_IMAGE_EXTENSION;
+  const bool DEBUG_FLAG = false;
+  const QStringList NO_LOAD_STARTUP_FILES;
+  const QStringList NO_COMMAND_LINE;
+
+  initializeLogging ("engauge_test",
+                     "engauge_test.log",
+                     DEBUG_FLAG);
+
+  MainWindow w (NO_ERROR_REPORT_LOG_FILE,
+                NO_REGRESSION_OPEN_FILE,
+                NO_REGRESSION_IMPORT,
+                NO_GNUPLOT_LOG_FILES,
+                NO_RESET,
+                NO_EXPORT_ONLY,
+                NO_EXTRACT_IMAGE_ONLY,
+                NO_EXTRACT_IMAGE_EXTENSION,
+                NO_LOAD_STARTUP_FILES,
+                NO_COMMAND_LINE);
+  w.show ();
+}
+
+QImage TestColorFilter::loadRandomImage () const
+{
+  // Mixture of gray (achromatic) pixels, translucent pixels and arbitrary colors. Width is not a multiple
+  // of the vector length so the scalar remainder code is exercised
+  const int WIDTH = 203, HEIGHT = 37;
+
+  QImage img (WIDTH, HEIGHT, QImage::Format_ARGB32);
+
+  qsrand (1);
+  for (int y = 0; y < HEIGHT; y++) {
+    for (int x = 0; x < WIDTH; x++) {
+      int gray = qrand () % 256;
+      QRgb rgb;
+      switch (qrand () % 3) {
+      case 0:
+        rgb = qRgb (gray, gray, gray);
+        break;
+
+      case 1:
+        rgb = qRgba (qrand () % 256, qrand () % 256, qrand () % 256, qrand () % 256);
+        break;
+
+      default:
+        rgb = qRgb (qrand () % 256, qrand () % 256, qrand () % 256);
+        break;
+      }
+      img.setPixel (x, y, rgb);
+    }
+  }
+
+  return img;
+}
+
+void TestColorFilter::testFilterImageMatchesPixelLoop ()
+{
+  QDir::setCurrent (QApplication::applicationDirPath());
+
+  QList<QImage> images;
+  images << QImage ("../samples/corners.png");
+  images << QImage ("../samples/gnuplot_x_y_lines_grid.png");
+  images << loadRandomImage ();
+
+  // Low/high pairs include the empty, single and two range (low greater than high) cases
+  QList<QPair<double, double> > thresholds;
+  thresholds << QPair<double, double> (0.0, 1.0);
+  thresholds << QPair<double, double> (0.0, 0.5);
+  thresholds << QPair<double, double> (0.1, 0.9);
+  thresholds << QPair<double, double> (0.3, 0.3);
+  thresholds << QPair<double, double> (0.7, 0.2);
+  thresholds << QPair<double, double> (1.0, 0.0);
+  thresholds << QPair<double, double> (1.0, 1.0);
+
+  // Same order as ColorFilterMode
+  ColorFilterStrategyForeground strategyForeground;
+  ColorFilterStrategyHue strategyHue;
+  ColorFilterStrategyIntensity strategyIntensity;
+  ColorFilterStrategySaturation strategySaturation;
+  ColorFilterStrategyValue strategyValue;
+  const ColorFilterStrategyAbstractBase *strategies [] = {&strategyForeground,
+                                                          &strategyHue,
+                                                          &strategyIntensity,
+                                                          &strategySaturation,
+                                                          &strategyValue};
+
+  ColorFilter filter;
+
+  bool success = true;
+  for (int indexImage = 0; indexImage < images.count(); indexImage++) {
+
+    const QImage &img = images [indexImage];
+    QRgb rgbBackground = filter.marginColor (&img);
+
+    for (int mode = 0; mode < NUM_COLOR_FILTER_MODES; mode++) {
+
+      ColorFilterMode colorFilterMode = (ColorFilterMode) mode;
+
+      for (int indexThreshold = 0; indexThreshold < thresholds.count(); indexThreshold++) {
+
+        double low = thresholds [indexThreshold].first;
+        double high = thresholds [indexThreshold].second;
+
+        QImage imageExpected (img.width (),
+                              img.height (),
+                              QImage::Format_RGB32);
+        filterImageByPixel (filter,
+                            img,
+                            imageExpected,
+                            colorFilterMode,
+                            low,
+                            high,
+                            rgbBackground);
+
+        // Packed form must survive the round trip
+        if (BitPlane (imageExpected).toImage () != imageExpected) {
+          qDebug() << "Bit plane round trip mismatch for image" << indexImage << "mode" << mode;
+          success = false;
+        }
+
+        // Go through every instruction set the cpu supports, with and without splitting into bands. Odd thread count
+        // leads to uneven bands
+        for (int instructionSet = ColorFilterEngine::INSTRUCTION_SET_SCALAR;
+             instructionSet <= ColorFilterEngine::bestInstructionSet (); instructionSet++) {
+          for (int threadCount = 1; threadCount <= 3; threadCount += 2) {
+
+            ColorFilterEngine engine (*strategies [mode],
+                                      colorFilterMode,
+                                      low,
+                                      high,
+                                      rgbBackground);
+            engine.setInstructionSet ((ColorFilterEngine::InstructionSet) instructionSet);
+
+            QImage imageFiltered (img.width (),
+                                  img.height (),
+                                  QImage::Format_RGB32);
+            engine.filterImage (img,
+                                imageFiltered,
+                                threadCount);
+
+            if (imageFiltered != imageExpected) {
+              qDebug() << "Mismatch for image" << indexImage << "mode" << mode << "low" << low << "high" << high
+                       << "instruction set" << instructionSet << "threads" << threadCount;
+              success = false;
+            }
+
+            BitPlane bitPlaneFiltered (img.width (),
+                                       img.height ());
+            engine.filterImage (img,
+                                bitPlaneFiltered,
+                                threadCount);
+
+            if (bitPlaneFiltered.toImage () != imageExpected) {
+              qDebug() << "Bit plane mismatch for image" << indexImage << "mode" << mode << "low" << low << "high" << high
+                       << "instruction set" << instructionSet << "threads" << threadCount;
+              success = false;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  QVERIFY (success);
+}
+
+void TestColorFilter::testHistogramAllModesMatchesPixelLoop ()
+{
+  const int HISTOGRAM_BINS = ColorFilterHistogram::HISTOGRAM_BINS ();
+
+  QImage img = loadRandomImage ();
+  QRgb rgbBackground = qRgb (240, 230, 220);
+
+  ColorFilter filter;
+  ColorFilterHistogram histogram;
+  histogram.generateAllModes (filter,
+                              img,
+                              rgbBackground);
+
+  bool success = true;
+  for (int mode = 0; mode < NUM_COLOR_FILTER_MODES; mode++) {
+
+    ColorFilterMode colorFilterMode = (ColorFilterMode) mode;
+
+    // Reference is the original column by column walk through every pixel
+    QVector<double> binsExpected (HISTOGRAM_BINS, 0);
+    int maxBinCountExpected = 0;
+    for (int x = 0; x < img.width (); x++) {
+      for (int y = 0; y < img.height (); y++) {
+        int bin = histogram.binFromPixel (filter,
+                                          colorFilterMode,
+                                          QColor (img.pixel (x, y)),
+                                          rgbBackground);
+        if (bin >= 0) {
+          ++(binsExpected [bin]);
+          maxBinCountExpected = qMax (maxBinCountExpected, (int) binsExpected [bin]);
+        }
+      }
+    }
+
+    QVector<double> binsAllModes (HISTOGRAM_BINS), binsOneMode (HISTOGRAM_BINS);
+    int maxBinCountAllModes, maxBinCountOneMode;
+    histogram.histogram (colorFilterMode,
+                         binsAllModes.data (),
+                         maxBinCountAllModes);
+    histogram.generate (filter,
+                        binsOneMode.data (),
+                        colorFilterMode,
+                        img,
+                        rgbBackground,
+                        maxBinCountOneMode);
+
+    if (binsAllModes != binsExpected ||
+        binsOneMode != binsExpected ||
+        maxBinCountAllModes != maxBinCountExpected ||
+        maxBinCountOneMode != maxBinCountExpected) {
+      qDebug() << "Mismatch for mode" << colorFilterModeToString (colorFilterMode);
+      success = false;
+    }
+  }
+
+  QVERIFY (success);
+}
+
+void TestColorFilter::testMarginColorMatchesLinearSearch ()
+{
+  QDir::setCurrent (QApplication::applicationDirPath());
+
+  QList<QImage> images;
+  images << QImage ("../samples/corners.png");
+  images << QImage ("../samples/gnuplot_x_y_lines_grid.png");
+  images << loadRandomImage (); // Thousands of distinct border colors
+
+  ColorFilter filter;
+
+  bool success = true;
+  for (int indexImage = 0; indexImage < images.count(); indexImage++) {
+
+    const QImage &img = images [indexImage];
+    if (filter.marginColor (&img) != marginColorByLinearSearch (filter, img)) {
+      qDebug() << "Mismatch for image" << indexImage;
+      success = false;
+    }
+  }
+
+  QVERIFY (success);
+}
+
+QRgb TestColorFilter::marginColorByLinearSearch (const ColorFilter &filter,
+                                                 const QImage &image) const
+{
+  // Original algorithm, which searches a list of the colors seen so far, serves as the reference
+  QList<ColorFilterEntry> colorCounts;
+
+  QList<QPoint> border;
+  for (int x = 0; x < image.width (); x++) {
+    border << QPoint (x, 0) << QPoint (x, image.height () - 1);
+  }
+  for (int y = 0; y < image.height (); y++) {
+    border << QPoint (0, y) << QPoint (image.width () - 1, y);
+  }
+
+  for (int i = 0; i < border.count(); i++) {
+
+    ColorFilterEntry entry;
+    entry.color = image.pixel (border.at (i));
+    entry.count = 0;
+
+    bool found = false;
+    for (int j = 0; j < colorCounts.count(); j++) {
+      if (filter.colorCompare (entry.color.rgb(),
+                               colorCounts [j].color.rgb())) {
+        found = true;
+        ++colorCounts [j].count;
+        break;
+      }
+    }
+
+    if (!found) {
+      colorCounts.append (entry);
+    }
+  }
+
+  ColorFilterEntry entryMax;
+  entryMax.count = 0;
+  for (int j = 0; j < colorCounts.count(); j++) {
+    if (colorCounts [j].count > entryMax.count) {
+      entryMax = colorCounts [j];
+    }
+  }
+
+  return entryMax.color.rgb();
+}
@@ -0,0 +1,46 @@
+#ifndef TEST_COLOR_FILTER_H
+#define TEST_COLOR_FILTER_H
+
+#include "ColorFilterMode.h"
+#include <QObject>
+#include <QRgb>
+
+class ColorFilter;
+class QImage;
+
+/// Unit test and benchmark of scanline color filter engine against the original per-pixel color filter loop
+class TestColorFilter : public QObject
+{
+  Q_OBJECT
+public:
+  /// Single constructor.
+  explicit TestColorFilter(QObject *parent = 0);
+
+signals:
+
+private slots:
+  void cleanupTestCase ();
+  void initTestCase ();
+
+  void benchmarkFilterImagePixelLoop ();
+  void benchmarkFilterImageScanline ();
+  void benchmarkFilterImageScanlineAllThreads ();
+  void testFilterImageMatchesPixelLoop ();
+  void testHistogramAllModesMatchesPixelLoop ();
+  void testMarginColorMatchesLinearSearch ();
+
+private:
+  void benchmarkFilterImageScanlineThreads (int threadCount);
+  void filterImageByPixel (const ColorFilter &filter,
+                           const QImage &imageOriginal,
+                           QImage &imageFiltered,
+                           ColorFilterMode colorFilterMode,
+                           double low,
+                           double high,
+                           QRgb rgbBackground) const;
+  QImage loadRandomImage () const;
+  QRgb marginColorByLinearSearch (const ColorFilter &filter,
+                                  const QImage &image) const;
+};
+
+#endif // TEST_COLOR_FILTER_H
@@ -0,0 +1,207 @@
+#include "BitPlane.h"
+#include "ConnectedComponents.h"
+#include "Logger.h"
+#include "MainWindow.h"
+#include <QImage>
+#include <QQueue>
+#include <QThreadPool>
+#include <QtTest/QtTest>
+#include "Test/TestConnectedComponents.h"
+
+QTEST_MAIN (TestConnectedComponents)
+
+const double EPSILON = 1e-9;
+
+// Label every pixel with a breadth first flood fill, numbering the components in the order their first pixels are
+// reached by a row by row scan, which is also the order used by ConnectedComponents
+static int floodFillLabels (const BitPlane &bitPlane,
+                            bool on,
+                            QVector<int> &labels)
+{
+  int width = bitPlane.width ();
+  int height = bitPlane.height ();
+  int count = 0;
+
+  labels.fill (-1, width * height);
+
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      if ((bitPlane.pixel (x, y) == on) && (labels [y * width + x] < 0)) {
+
+        QQueue<QPoint> queue;
+        labels [y * width + x] = count;
+        queue.enqueue (QPoint (x, y));
+
+        while (!queue.isEmpty ()) {
+          QPoint p = queue.dequeue ();
+          for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+              int xN = p.x () + dx;
+              int yN = p.y () + dy;
+              if ((0 <= xN) && (xN < width) && (0 <= yN) && (yN < height) &&
+                  (bitPlane.pixel (xN, yN) == on) && (labels [yN * width + xN] < 0)) {
+                labels [yN * width + xN] = count;
+                queue.enqueue (QPoint (xN, yN));
+              }
+            }
+          }
+        }
+
+        ++count;
+      }
+    }
+  }
+
+  return count;
+}
+
+TestConnectedComponents::TestConnectedComponents(QObject *parent) :
+  QObject(parent)
+{
+}
+
+void TestConnectedComponents::cleanupTestCase ()
+{
+}
+
+void TestConnectedComponents::initTestCase ()
+{
+  const QString NO_ERROR_REPORT_LOG_FILE;
+  const QString NO_REGRESSION_OPEN_FILE;
+  const bool NO_GNUPLOT_LOG_FILES = false;
+  const bool NO_REGRESSION_IMPORT = false;
+  const bool NO_RESET = false;
+  const bool NO_EXPORT_ONLY = false;
+  const bool NO_EXTRACT_IMAGE_ONLY = false;
+  const QString NO_EXTRACT_IMAGE_EXTENSION;
+  const bool DEBUG_FLAG = false;
+  const QStringList NO_LOAD_STARTUP_FILES;
+  const QStringList NO_COMMAND_LINE;
+
+  initializeLogging ("engauge_test",
+                     "engauge_test.log",
+                     DEBUG_FLAG);
+
+  MainWindow w (NO_ERROR_REPORT_LOG_FILE,
+                NO_REGRESSION_OPEN_FILE,
+                NO_REGRESSION_IMPORT,
+                NO_GNUPLOT_LOG_FILES,
+                NO_RESET,
+                NO_EXPORT_ONLY,
+                NO_EXTRACT_IMAGE_ONLY,
+                NO_EXTRACT_IMAGE_EXTENSION,
+                NO_LOAD_STARTUP_FILES,
+                NO_COMMAND_LINE);
+  w.show ();
+}
+
+void TestConnectedComponents::testBandsMatchOneBand ()
+{
+  const int WIDTH = 700;
+  const int HEIGHT = 900;
+  const int THREADS_MANY = 8;
+
+  // Random blobs, from a fixed linear congruential sequence so the test is repeatable, with enough rows for many
+  // bands
+  BitPlane bitPlane (WIDTH, HEIGHT);
+  quint32 seed = 12345;
+  for (int y = 0; y < HEIGHT; y++) {
+    for (int x = 0; x < WIDTH; x++) {
+      seed = seed * 1103515245 + 12345;
+      bitPlane.setPixel (x, y, ((seed >> 16) & 7) < 3);
+    }
+  }
+
+  int threadCountOriginal = QThreadPool::globalInstance ()->maxThreadCount ();
+
+  QThreadPool::globalInstance ()->setMaxThreadCount (1);
+  ConnectedComponents componentsOneBand (bitPlane);
+
+  QThreadPool::globalInstance ()->setMaxThreadCount (THREADS_MANY);
+  ConnectedComponents componentsManyBands (bitPlane);
+
+  QThreadPool::globalInstance ()->setMaxThreadCount (threadCountOriginal);
+
+  bool success = (componentsOneBand.count () == componentsManyBands.count ());
+  for (int y = 0; success && (y < HEIGHT); y++) {
+
+    int countOneBand, countManyBands;
+    const ConnectedComponentRun *runsOneBand = componentsOneBand.rowRuns (y, countOneBand);
+    const ConnectedComponentRun *runsManyBands = componentsManyBands.rowRuns (y, countManyBands);
+
+    success = (countOneBand == countManyBands);
+    for (int index = 0; success && (index < countOneBand); index++) {
+      success = (runsOneBand [index].xStart == runsManyBands [index].xStart) &&
+                (runsOneBand [index].xStop == runsManyBands [index].xStop) &&
+                (runsOneBand [index].label == runsManyBands [index].label);
+    }
+  }
+
+  QVERIFY (success);
+}
+
+bool TestConnectedComponents::testFloodFill (const QString &filename,
+                                             bool on) const
+{
+  // The relative paths in this method will fail unless the directory is correct
+  QDir::setCurrent (QApplication::applicationDirPath());
+
+  BitPlane bitPlane (QImage (filename));
+  int width = bitPlane.width ();
+  int height = bitPlane.height ();
+
+  QVector<int> labels;
+  int count = floodFillLabels (bitPlane,
+                               on,
+                               labels);
+
+  ConnectedComponents components (bitPlane,
+                                  on);
+
+  bool success = (width > 0) && (count == components.count ());
+
+  // Same label for every pixel
+  for (int y = 0; success && (y < height); y++) {
+    for (int x = 0; success && (x < width); x++) {
+      success = (components.label (x, y) == labels [y * width + x]);
+    }
+  }
+
+  // Same statistics for every component
+  QVector<int> areas (count, 0);
+  QVector<QRect> boundingRects (count);
+  QVector<double> sumsX (count, 0), sumsY (count, 0);
+  for (int y = 0; success && (y < height); y++) {
+    for (int x = 0; x < width; x++) {
+      int label = labels [y * width + x];
+      if (label >= 0) {
+        ++areas [label];
+        boundingRects [label] = boundingRects [label].united (QRect (x, y, 1, 1));
+        sumsX [label] += x;
+        sumsY [label] += y;
+      }
+    }
+  }
+
+  for (int label = 0; success && (label < count); label++) {
+    const ConnectedComponent &component = components.component (label);
+    success = (component.area == areas [label]) &&
+              (component.boundingRect == boundingRects [label]) &&
+              (qAbs (component.centroid.x () - sumsX [label] / areas [label]) < EPSILON) &&
+              (qAbs (component.centroid.y () - sumsY [label] / areas [label]) < EPSILON);
+  }
+
+  return success;
+}
+
+void TestConnectedComponents::testFloodFillOff ()
+{
+  QVERIFY (testFloodFill ("../samples/corners.png", false));
+  QVERIFY (testFloodFill ("../samples/gnuplot_x_y_lines_grid.png", false));
+}
+
+void TestConnectedComponents::testFloodFillOn ()
+{
+  QVERIFY (testFloodFill ("../samples/corners.png", true));
+  QVERIFY (testFloodFill ("../samples/gnuplot_x_y_lines_grid.png", true));
+}
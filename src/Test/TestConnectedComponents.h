@@ -0,0 +1,29 @@
+#ifndef TEST_CONNECTED_COMPONENTS_H
+#define TEST_CONNECTED_COMPONENTS_H
+
+#include <QObject>
+
+/// Unit test of ConnectedComponents class
+class TestConnectedComponents : public QObject
+{
+  Q_OBJECT
+public:
+  /// Single constructor.
+  explicit TestConnectedComponents(QObject *parent = 0);
+
+signals:
+
+private slots:
+  void cleanupTestCase ();
+  void initTestCase ();
+
+  void testBandsMatchOneBand ();
+  void testFloodFillOff ();
+  void testFloodFillOn ();
+
+private:
+  bool testFloodFill (const QString &filename,
+                      bool on) const;
+};
+
+#endif // TEST_CONNECTED_COMPONENTS_H
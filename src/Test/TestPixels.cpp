@@ -0,0 +1,304 @@
+#include "BitPlane.h"
+#include "ConnectedComponents.h"
+#include <cstring>
+#include "Logger.h"
+#include "MainWindow.h"
+#include "Pixels.h"
+#include <QImage>
+#include <QList>
+#include <QQueue>
+#include <QtTest/QtTest>
+#include "Test/TestPixels.h"
+
+QTEST_MAIN (TestPixels)
+
+const QString SAMPLES_DIRECTORY ("../samples");
+
+// Fill white regions smaller than the threshold by flood filling each region separately, as Pixels::fillHoles did
+// before it used ConnectedComponents
+static void fillHolesByFloodFill (QImage &image,
+                                  int thresholdCount)
+{
+  int width = image.width ();
+  int height = image.height ();
+
+  QVector<bool> visited (width * height, false);
+
+  for (int row = 0; row < height; row++) {
+    for (int col = 0; col < width; col++) {
+      if (!visited [row * width + col] && !Pixels::pixelIsBlack (image, col, row)) {
+
+        QList<QPoint> region;
+        QQueue<QPoint> queue;
+        visited [row * width + col] = true;
+        queue.enqueue (QPoint (col, row));
+
+        while (!queue.isEmpty ()) {
+          QPoint p = queue.dequeue ();
+          region.append (p);
+          for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+              int colN = p.x () + dx;
+              int rowN = p.y () + dy;
+              if ((0 <= colN) && (colN < width) && (0 <= rowN) && (rowN < height) &&
+                  !visited [rowN * width + colN] && !Pixels::pixelIsBlack (image, colN, rowN)) {
+                visited [rowN * width + colN] = true;
+                queue.enqueue (QPoint (colN, rowN));
+              }
+            }
+          }
+        }
+
+        if (region.count () < thresholdCount) {
+          for (int index = 0; index < region.count (); index++) {
+            image.setPixel (region.at (index),
+                            Qt::black);
+          }
+        }
+      }
+    }
+  }
+}
+
+// Fill white pixels with more than 4 black neighbors one pixel at a time, as Pixels::fillIsolatedWhitePixels did
+// before it counted neighbors in the packed image
+static void fillIsolatedWhitePixelsByPixel (QImage &image)
+{
+  int height = image.height();
+  int width = image.width();
+
+  QVector<bool> pixelsAreBlack (width * height);
+  for (int row = 0; row < height; row++) {
+    for (int col = 0; col < width; col++) {
+      pixelsAreBlack [row * width + col] = Pixels::pixelIsBlack (image, col, row);
+    }
+  }
+
+  for (int row = 1; row < height - 1; row++) {
+    for (int col = 1; col < width - 1; col++) {
+      int count = 0;
+      for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+          if ((dx != 0 || dy != 0) && pixelsAreBlack [(row + dy) * width + col + dx]) {
+            ++count;
+          }
+        }
+      }
+      if (count > 4) {
+        image.setPixel (col,
+                        row,
+                        Qt::black);
+      }
+    }
+  }
+}
+
+// Compare the raw scanlines, since QImage::operator== and QImage::pixel hide the alpha of Format_RGB32 pixels
+static bool imagesHaveSameScanLines (const QImage &image1,
+                                     const QImage &image2)
+{
+  if ((image1.format () != image2.format ()) ||
+      (image1.size () != image2.size ())) {
+    return false;
+  }
+
+  // Both images are copies of one image, so any padding at the ends of the scanlines also matches
+  for (int row = 0; row < image1.height (); row++) {
+    if (memcmp (image1.constScanLine (row),
+                image2.constScanLine (row),
+                image1.bytesPerLine ()) != 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+TestPixels::TestPixels(QObject *parent) :
+  QObject(parent)
+{
+}
+
+void TestPixels::benchmarkFillIsolatedWhitePixels ()
+{
+  QList<QImage> images = loadSampleImages ();
+  Pixels pixels;
+
+  QBENCHMARK {
+    for (int index = 0; index < images.count (); index++) {
+      QImage image = images.at (index);
+      pixels.fillIsolatedWhitePixels (image);
+    }
+  }
+}
+
+void TestPixels::benchmarkFillIsolatedWhitePixelsByPixel ()
+{
+  QList<QImage> images = loadSampleImages ();
+
+  QBENCHMARK {
+    for (int index = 0; index < images.count (); index++) {
+      QImage image = images.at (index);
+      fillIsolatedWhitePixelsByPixel (image);
+    }
+  }
+}
+
+void TestPixels::cleanupTestCase ()
+{
+}
+
+void TestPixels::initTestCase ()
+{
+  const QString NO_ERROR_REPORT_LOG_FILE;
+  const QString NO_REGRESSION_OPEN_FILE;
+  const bool NO_GNUPLOT_LOG_FILES = false;
+  const bool NO_REGRESSION_IMPORT = false;
+  const bool NO_RESET = false;
+  const bool NO_EXPORT_ONLY = false;
+  const bool NO_EXTRACT_IMAGE_ONLY = false;
+  const QString NO_EXTRACT_IMAGE_EXTENSION;
+  const bool DEBUG_FLAG = false;
+  const QStringList NO_LOAD_STARTUP_FILES;
+  const QStringList NO_COMMAND_LINE;
+
+  initializeLogging ("engauge_test",
+                     "engauge_test.log",
+                     DEBUG_FLAG);
+
+  MainWindow w (NO_ERROR_REPORT_LOG_FILE,
+                NO_REGRESSION_OPEN_FILE,
+                NO_REGRESSION_IMPORT,
+                NO_GNUPLOT_LOG_FILES,
+                NO_RESET,
+                NO_EXPORT_ONLY,
+                NO_EXTRACT_IMAGE_ONLY,
+                NO_EXTRACT_IMAGE_EXTENSION,
+                NO_LOAD_STARTUP_FILES,
+                NO_COMMAND_LINE);
+  w.show ();
+}
+
+QList<QImage> TestPixels::loadSampleImages () const
+{
+  // The relative paths in this method will fail unless the directory is correct
+  QDir::setCurrent (QApplication::applicationDirPath());
+
+  QDir dir (SAMPLES_DIRECTORY);
+  QStringList filenames = dir.entryList (QStringList () << "*.png" << "*.gif" << "*.jpg",
+                                         QDir::Files,
+                                         QDir::Name);
+
+  QList<QImage> images;
+  for (int index = 0; index < filenames.count (); index++) {
+    QImage image (dir.filePath (filenames.at (index)));
+    if (!image.isNull ()) {
+      images << image.convertToFormat (QImage::Format_RGB32);
+    }
+  }
+
+  return images;
+}
+
+void TestPixels::testCountBlackPixelsAroundPoint ()
+{
+  const int STOP_COUNTS [] = {1, 10, 100, 100000};
+  const int NUM_STOP_COUNTS = sizeof (STOP_COUNTS) / sizeof (STOP_COUNTS [0]);
+
+  // The relative paths in this method will fail unless the directory is correct
+  QDir::setCurrent (QApplication::applicationDirPath());
+
+  BitPlane bitPlane (QImage ("../samples/corners.png"));
+  ConnectedComponents components (bitPlane);
+
+  // One instance for all calls, so leftovers in the scratch buffers from one call would break later calls
+  Pixels pixels;
+
+  bool success = (bitPlane.countOn () > 0);
+  for (int index = 0; success && (index < NUM_STOP_COUNTS); index++) {
+    int stopCountAt = STOP_COUNTS [index];
+
+    for (int y = -1; success && (y <= bitPlane.height ()); y++) {
+      for (int x = -1; success && (x <= bitPlane.width ()); x++) {
+
+        int countExpected = qMin (components.area (x, y),
+                                  stopCountAt);
+
+        success = (pixels.countBlackPixelsAroundPoint (bitPlane,
+                                                       x,
+                                                       y,
+                                                       stopCountAt) == countExpected);
+      }
+    }
+  }
+
+  QVERIFY (success);
+}
+
+void TestPixels::testFillHoles ()
+{
+  const int THRESHOLD_COUNTS [] = {1, 10, 1000, 1000000};
+  const int NUM_THRESHOLD_COUNTS = sizeof (THRESHOLD_COUNTS) / sizeof (THRESHOLD_COUNTS [0]);
+  const QImage::Format FORMATS [] = {QImage::Format_RGB32, QImage::Format_ARGB32, QImage::Format_ARGB32_Premultiplied,
+                                     QImage::Format_RGB888};
+  const int NUM_FORMATS = sizeof (FORMATS) / sizeof (FORMATS [0]);
+  const QString FILENAMES [] = {"../samples/corners.png", "../samples/gnuplot_x_y_linespoints_grid.png"};
+  const int NUM_FILENAMES = sizeof (FILENAMES) / sizeof (FILENAMES [0]);
+
+  // The relative paths in this method will fail unless the directory is correct
+  QDir::setCurrent (QApplication::applicationDirPath());
+
+  Pixels pixels;
+
+  bool success = true;
+  for (int indexN = 0; success && (indexN < NUM_FILENAMES); indexN++) {
+
+    QImage imageOriginal (FILENAMES [indexN]);
+    success = !imageOriginal.isNull ();
+
+    for (int indexF = 0; success && (indexF < NUM_FORMATS); indexF++) {
+      for (int indexT = 0; success && (indexT < NUM_THRESHOLD_COUNTS); indexT++) {
+
+        QImage imageExpected = imageOriginal.convertToFormat (FORMATS [indexF]);
+        QImage imageGot = imageExpected;
+
+        fillHolesByFloodFill (imageExpected,
+                              THRESHOLD_COUNTS [indexT]);
+        pixels.fillHoles (imageGot,
+                          THRESHOLD_COUNTS [indexT]);
+
+        success = imagesHaveSameScanLines (imageGot,
+                                           imageExpected);
+      }
+    }
+  }
+
+  QVERIFY (success);
+}
+
+void TestPixels::testFillIsolatedWhitePixels ()
+{
+  const QImage::Format FORMATS [] = {QImage::Format_RGB32, QImage::Format_ARGB32, QImage::Format_ARGB32_Premultiplied,
+                                     QImage::Format_RGB888};
+  const int NUM_FORMATS = sizeof (FORMATS) / sizeof (FORMATS [0]);
+
+  QList<QImage> images = loadSampleImages ();
+  Pixels pixels;
+
+  bool success = (images.count () > 0);
+  for (int index = 0; success && (index < images.count ()); index++) {
+    for (int indexF = 0; success && (indexF < NUM_FORMATS); indexF++) {
+
+      QImage imageExpected = images.at (index).convertToFormat (FORMATS [indexF]);
+      QImage imageGot = imageExpected;
+
+      fillIsolatedWhitePixelsByPixel (imageExpected);
+      pixels.fillIsolatedWhitePixels (imageGot);
+
+      success = imagesHaveSameScanLines (imageGot,
+                                         imageExpected);
+    }
+  }
+
+  QVERIFY (success);
+}
@@ -0,0 +1,34 @@
+#ifndef TEST_PIXELS_H
+#define TEST_PIXELS_H
+
+#include <QImage>
+#include <QList>
+#include <QObject>
+
+/// Unit test of Pixels class
+class TestPixels : public QObject
+{
+  Q_OBJECT
+public:
+  /// Single constructor.
+  explicit TestPixels(QObject *parent = 0);
+
+signals:
+
+private slots:
+  void cleanupTestCase ();
+  void initTestCase ();
+
+  void benchmarkFillIsolatedWhitePixels ();
+  void benchmarkFillIsolatedWhitePixelsByPixel ();
+
+  void testCountBlackPixelsAroundPoint ();
+  void testFillHoles ();
+  void testFillIsolatedWhitePixels ();
+
+private:
+  QList<QImage> loadSampleImages () const;
+
+};
+
+#endif // TEST_PIXELS_H
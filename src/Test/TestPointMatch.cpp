@@ -0,0 +1,511 @@
+#include "BitPlane.h"
+#include "DocumentModelPointMatch.h"
+#include "Logger.h"
+#include "MainWindow.h"
+#include "Point.h"
+#include "PointMatchAlgorithm.h"
+#include "PointMatchCache.h"
+#include "Points.h"
+#include <QImage>
+#include <qmath.h>
+#include <QSet>
+#include <QtTest/QtTest>
+#include "Test/TestPointMatch.h"
+
+QTEST_MAIN (TestPointMatch)
+
+const QString BENCHMARK_IMAGE ("../samples/gnuplot_x_y_points_nogrid.png");
+
+const int ARM_LENGTH = 3;
+const int IMAGE_WIDTH = 60;
+const int IMAGE_HEIGHT = 45;
+const int MAX_POINT_SIZE = 10;
+
+// Crosses drawn far enough apart, and far enough from the borders, that each is matched on its own
+static QList<QPoint> crossCenters ()
+{
+  QList<QPoint> centers;
+  centers << QPoint (10, 10)
+          << QPoint (35, 12)
+          << QPoint (50, 34)
+          << QPoint (17, 36);
+
+  return centers;
+}
+
+static BitPlane crossesBitPlane ()
+{
+  BitPlane bitPlane (IMAGE_WIDTH,
+                     IMAGE_HEIGHT);
+
+  QList<QPoint> centers = crossCenters ();
+  for (int i = 0; i < centers.count (); i++) {
+    for (int delta = -ARM_LENGTH; delta <= ARM_LENGTH; delta++) {
+      bitPlane.setPixel (centers.at (i).x () + delta, centers.at (i).y (), true);
+      bitPlane.setPixel (centers.at (i).x (), centers.at (i).y () + delta, true);
+    }
+  }
+
+  // A few stray pixels that should not be mistaken for crosses
+  bitPlane.setPixel (42, 4, true);
+  bitPlane.setPixel (3, 25, true);
+
+  return bitPlane;
+}
+
+// Circle outline, two pixels wide, like the point symbols of a typical plot
+static QList<PointMatchPixel> ringPointPixels (int pointSize)
+{
+  QList<PointMatchPixel> pixels;
+
+  int radiusMax = pointSize / 2;
+  for (int xOffset = -radiusMax; xOffset <= radiusMax; xOffset++) {
+    for (int yOffset = -radiusMax; yOffset <= radiusMax; yOffset++) {
+
+      int radius = qSqrt (xOffset * xOffset + yOffset * yOffset);
+      if (radius <= radiusMax) {
+        pixels << PointMatchPixel (xOffset,
+                                   yOffset,
+                                   radius >= radiusMax - 1);
+      }
+    }
+  }
+
+  return pixels;
+}
+
+TestPointMatch::TestPointMatch(QObject *parent) :
+  QObject(parent)
+{
+}
+
+void TestPointMatch::benchmarkEngine (PointMatchAlgorithm::Engine engine)
+{
+  QFETCH (int, pointSize);
+
+  QDir::setCurrent (QApplication::applicationDirPath());
+
+  BitPlane bitPlane (QImage (BENCHMARK_IMAGE));
+  QList<PointMatchPixel> pixels = ringPointPixels (pointSize);
+
+  DocumentModelPointMatch modelPointMatch;
+  modelPointMatch.setMaxPointSize (pointSize);
+
+  PointMatchCache cache;
+  PointMatchAlgorithm algorithm (false,
+                                 cache);
+  algorithm.setEngine (engine);
+
+  // The first match makes the plans and transforms the image, which later matches of the same image skip
+  algorithm.findPoints (pixels,
+                        bitPlane,
+                        modelPointMatch,
+                        Points ());
+
+  QBENCHMARK {
+    algorithm.findPoints (pixels,
+                          bitPlane,
+                          modelPointMatch,
+                          Points ());
+  }
+
+  // Compare the timings of the two benchmarks for each point size with this choice to check the cost model
+  int countOnSample = 0;
+  QSet<int> sampleRows;
+  for (int i = 0; i < pixels.count (); i++) {
+    if (pixels.at (i).pixelIsOn ()) {
+      ++countOnSample;
+      sampleRows << pixels.at (i).yOffset ();
+    }
+  }
+
+  PointMatchAlgorithm::Engine engineCheaper = PointMatchAlgorithm::cheaperEngine (bitPlane.countOn (),
+                                                                                  countOnSample,
+                                                                                  sampleRows.count (),
+                                                                                  bitPlane.width (),
+                                                                                  bitPlane.height (),
+                                                                                  true);
+  qDebug() << "Point size" << pointSize << "with" << countOnSample << "on pixels is estimated to be faster with"
+           << (engineCheaper == PointMatchAlgorithm::ENGINE_DIRECT ? "direct" : "fft");
+}
+
+void TestPointMatch::benchmarkEngineData ()
+{
+  QTest::addColumn<int> ("pointSize");
+
+  QTest::newRow ("8") << 8;
+  QTest::newRow ("16") << 16;
+  QTest::newRow ("32") << 32;
+  QTest::newRow ("64") << 64;
+  QTest::newRow ("128") << 128;
+}
+
+void TestPointMatch::benchmarkEngineDirect ()
+{
+  benchmarkEngine (PointMatchAlgorithm::ENGINE_DIRECT);
+}
+
+void TestPointMatch::benchmarkEngineDirect_data ()
+{
+  benchmarkEngineData ();
+}
+
+void TestPointMatch::benchmarkEngineFft ()
+{
+  benchmarkEngine (PointMatchAlgorithm::ENGINE_FFT);
+}
+
+void TestPointMatch::benchmarkEngineFft_data ()
+{
+  benchmarkEngineData ();
+}
+
+void TestPointMatch::cleanupTestCase ()
+{
+}
+
+void TestPointMatch::initTestCase ()
+{
+  const QString NO_ERROR_REPORT_LOG_FILE;
+  const QString NO_REGRESSION_OPEN_FILE;
+  const bool NO_GNUPLOT_LOG_FILES = false;
+  const bool NO_REGRESSION_IMPORT = false;
+  const bool NO_RESET = false;
+  const bool NO_EXPORT_ONLY = false;
+  const bool NO_EXTRACT_IMAGE_ONLY = false;
+  const QString NO_EXTRACT_IMAGE_EXTENSION;
+  const bool DEBUG_FLAG = false;
+  const QStringList NO_LOAD_STARTUP_FILES;
+  const QStringList NO_COMMAND_LINE;
+
+  initializeLogging ("engauge_test",
+                     "engauge_test.log",
+                     DEBUG_FLAG);
+
+  MainWindow w (NO_ERROR_REPORT_LOG_FILE,
+                NO_REGRESSION_OPEN_FILE,
+                NO_REGRESSION_IMPORT,
+                NO_GNUPLOT_LOG_FILES,
+                NO_RESET,
+                NO_EXPORT_ONLY,
+                NO_EXTRACT_IMAGE_ONLY,
+                NO_EXTRACT_IMAGE_EXTENSION,
+                NO_LOAD_STARTUP_FILES,
+                NO_COMMAND_LINE);
+  w.show ();
+}
+
+QList<PointMatchPixel> TestPointMatch::samplePointPixels (const BitPlane &bitPlane,
+                                                          const QPoint &posScreen) const
+{
+  // Same circular sample as DigitizeStatePointMatch::extractSamplePointPixels
+  QList<PointMatchPixel> pixels;
+
+  int radiusMax = MAX_POINT_SIZE / 2;
+  for (int xOffset = -radiusMax; xOffset <= radiusMax; xOffset++) {
+    for (int yOffset = -radiusMax; yOffset <= radiusMax; yOffset++) {
+
+      int radius = qSqrt (xOffset * xOffset + yOffset * yOffset);
+      if (radius <= radiusMax) {
+        pixels << PointMatchPixel (xOffset,
+                                   yOffset,
+                                   bitPlane.pixel (posScreen.x () + xOffset,
+                                                   posScreen.y () + yOffset));
+      }
+    }
+  }
+
+  return pixels;
+}
+
+void TestPointMatch::testCacheReuse ()
+{
+  BitPlane bitPlane = crossesBitPlane ();
+  QList<QPoint> centers = crossCenters ();
+
+  DocumentModelPointMatch modelPointMatch;
+  modelPointMatch.setMaxPointSize (MAX_POINT_SIZE);
+
+  Points pointsNone;
+  Points pointsOne;
+  pointsOne << Point ("Curve1",
+                      QPointF (centers.at (2)),
+                      1.0);
+
+  // Matches through a cache that has already transformed the image, or has transformed it with different existing
+  // points, must equal the matches through a new cache
+  PointMatchCache cacheReused;
+  PointMatchAlgorithm algorithmReused (false,
+                                       cacheReused);
+  algorithmReused.findPoints (samplePointPixels (bitPlane, centers.at (0)),
+                              bitPlane,
+                              modelPointMatch,
+                              pointsNone);
+
+  QList<QPoint> pointsReusedSameImage = algorithmReused.findPoints (samplePointPixels (bitPlane, centers.at (1)),
+                                                                    bitPlane,
+                                                                    modelPointMatch,
+                                                                    pointsNone);
+  QList<QPoint> pointsReusedOtherPoints = algorithmReused.findPoints (samplePointPixels (bitPlane, centers.at (1)),
+                                                                      bitPlane,
+                                                                      modelPointMatch,
+                                                                      pointsOne);
+
+  PointMatchCache cacheNew0, cacheNew1;
+  QList<QPoint> pointsNewSameImage = PointMatchAlgorithm (false,
+                                                          cacheNew0).findPoints (samplePointPixels (bitPlane, centers.at (1)),
+                                                                                 bitPlane,
+                                                                                 modelPointMatch,
+                                                                                 pointsNone);
+  QList<QPoint> pointsNewOtherPoints = PointMatchAlgorithm (false,
+                                                            cacheNew1).findPoints (samplePointPixels (bitPlane, centers.at (1)),
+                                                                                   bitPlane,
+                                                                                   modelPointMatch,
+                                                                                   pointsOne);
+
+  QVERIFY (!pointsNewSameImage.isEmpty ());
+  QVERIFY (pointsReusedSameImage == pointsNewSameImage);
+  QVERIFY (pointsReusedOtherPoints == pointsNewOtherPoints);
+  QVERIFY (pointsNewSameImage != pointsNewOtherPoints);
+}
+
+void TestPointMatch::testEnginesAgree ()
+{
+  BitPlane bitPlane = crossesBitPlane ();
+  QList<QPoint> centers = crossCenters ();
+
+  DocumentModelPointMatch modelPointMatch;
+  modelPointMatch.setMaxPointSize (MAX_POINT_SIZE);
+
+  Points pointsOne;
+  pointsOne << Point ("Curve1",
+                      QPointF (centers.at (2)),
+                      1.0);
+
+  PointMatchCache cache;
+  PointMatchAlgorithm algorithm (false,
+                                 cache);
+
+  // Every candidate, in the same order, for samples near the edges where the correlation wraps around, and with
+  // pixels turned off near an existing point
+  bool success = true;
+  for (int i = 0; success && (i < centers.count ()); i++) {
+    for (int withPoint = 0; success && (withPoint < 2); withPoint++) {
+
+      Points pointsExisting = (withPoint ? pointsOne : Points ());
+
+      algorithm.setEngine (PointMatchAlgorithm::ENGINE_DIRECT);
+      QList<QPoint> pointsDirect = algorithm.findPoints (samplePointPixels (bitPlane, centers.at (i)),
+                                                         bitPlane,
+                                                         modelPointMatch,
+                                                         pointsExisting);
+
+      algorithm.setEngine (PointMatchAlgorithm::ENGINE_FFT);
+      QList<QPoint> pointsFft = algorithm.findPoints (samplePointPixels (bitPlane, centers.at (i)),
+                                                      bitPlane,
+                                                      modelPointMatch,
+                                                      pointsExisting);
+
+      success = !pointsDirect.isEmpty () && (pointsDirect == pointsFft);
+    }
+  }
+
+  QVERIFY (success);
+}
+
+void TestPointMatch::testFindCrosses ()
+{
+  BitPlane bitPlane = crossesBitPlane ();
+  QList<QPoint> centers = crossCenters ();
+
+  DocumentModelPointMatch modelPointMatch;
+  modelPointMatch.setMaxPointSize (MAX_POINT_SIZE);
+
+  PointMatchCache cache;
+  PointMatchAlgorithm algorithm (false,
+                                 cache);
+  QList<QPoint> points = algorithm.findPoints (samplePointPixels (bitPlane, centers.at (0)),
+                                               bitPlane,
+                                               modelPointMatch,
+                                               Points ());
+
+  // The best matches are the crosses, in any order
+  bool success = (points.count () >= centers.count ());
+  for (int i = 0; success && (i < centers.count ()); i++) {
+    success = centers.contains (points.at (i));
+  }
+
+  QVERIFY (success);
+}
+
+void TestPointMatch::testMaxCandidates ()
+{
+  const int MAX_CANDIDATES_FEW = 3;
+
+  BitPlane bitPlane = crossesBitPlane ();
+  QList<QPoint> centers = crossCenters ();
+
+  DocumentModelPointMatch modelPointMatch;
+  modelPointMatch.setMaxPointSize (MAX_POINT_SIZE);
+
+  PointMatchCache cache;
+  PointMatchAlgorithm algorithm (false,
+                                 cache);
+  QList<QPoint> pointsAll = algorithm.findPoints (samplePointPixels (bitPlane, centers.at (0)),
+                                                  bitPlane,
+                                                  modelPointMatch,
+                                                  Points ());
+
+  modelPointMatch.setMaxCandidates (MAX_CANDIDATES_FEW);
+  QList<QPoint> pointsFew = algorithm.findPoints (samplePointPixels (bitPlane, centers.at (0)),
+                                                  bitPlane,
+                                                  modelPointMatch,
+                                                  Points ());
+
+  // Keeping fewer candidates must keep the best ones, in the same order
+  QVERIFY (pointsAll.count () > MAX_CANDIDATES_FEW);
+  QVERIFY (pointsFew == pointsAll.mid (0, MAX_CANDIDATES_FEW));
+}
+
+void TestPointMatch::testMultipleSamples ()
+{
+  const int BOX_HALF_WIDTH = 3;
+
+  // Hollow boxes between the crosses, like a second curve with a different point symbol
+  BitPlane bitPlane = crossesBitPlane ();
+  QList<QPoint> centersCrosses = crossCenters ();
+  QList<QPoint> centersBoxes;
+  centersBoxes << QPoint (26, 25)
+               << QPoint (48, 21);
+  for (int i = 0; i < centersBoxes.count (); i++) {
+    int x = centersBoxes.at (i).x ();
+    int y = centersBoxes.at (i).y ();
+    for (int delta = -BOX_HALF_WIDTH; delta <= BOX_HALF_WIDTH; delta++) {
+      bitPlane.setPixel (x + delta, y - BOX_HALF_WIDTH, true);
+      bitPlane.setPixel (x + delta, y + BOX_HALF_WIDTH, true);
+      bitPlane.setPixel (x - BOX_HALF_WIDTH, y + delta, true);
+      bitPlane.setPixel (x + BOX_HALF_WIDTH, y + delta, true);
+    }
+  }
+
+  DocumentModelPointMatch modelPointMatch;
+  modelPointMatch.setMaxPointSize (MAX_POINT_SIZE);
+
+  QList<QList<PointMatchPixel> > samples;
+  samples << samplePointPixels (bitPlane, centersCrosses.at (0))
+          << samplePointPixels (bitPlane, centersBoxes.at (0));
+
+  PointMatchCache cache;
+  PointMatchAlgorithm algorithm (false,
+                                 cache);
+
+  // The best matches are the crosses and the boxes, in any order, each assigned to its own sample by either engine
+  int countBest = centersCrosses.count () + centersBoxes.count ();
+  QList<QPoint> pointsFirstEngine;
+  bool success = true;
+  for (int engine = 0; success && (engine < 2); engine++) {
+
+    algorithm.setEngine (engine == 0 ? PointMatchAlgorithm::ENGINE_DIRECT : PointMatchAlgorithm::ENGINE_FFT);
+
+    QList<int> sampleIndexes;
+    QList<QPoint> points = algorithm.findPoints (samples,
+                                                 bitPlane,
+                                                 modelPointMatch,
+                                                 Points (),
+                                                 sampleIndexes);
+
+    success = (points.count () >= countBest) &&
+              (sampleIndexes.count () == points.count ());
+    for (int i = 0; success && (i < countBest); i++) {
+      if (centersCrosses.contains (points.at (i))) {
+        success = (sampleIndexes.at (i) == 0);
+      } else {
+        success = centersBoxes.contains (points.at (i)) && (sampleIndexes.at (i) == 1);
+      }
+    }
+
+    if (engine == 0) {
+      pointsFirstEngine = points;
+    } else {
+      success = success && (points == pointsFirstEngine);
+    }
+  }
+
+  QVERIFY (success);
+}
+
+void TestPointMatch::testRegion ()
+{
+  BitPlane bitPlane = crossesBitPlane ();
+  QList<QPoint> centers = crossCenters ();
+
+  DocumentModelPointMatch modelPointMatch;
+  modelPointMatch.setMaxPointSize (MAX_POINT_SIZE);
+
+  PointMatchCache cache;
+  PointMatchAlgorithm algorithm (false,
+                                 cache);
+
+  // A region covering the whole image changes nothing
+  QList<QPoint> pointsImage = algorithm.findPoints (samplePointPixels (bitPlane, centers.at (0)),
+                                                    bitPlane,
+                                                    modelPointMatch,
+                                                    Points ());
+  algorithm.setRegion (QRect (-10, -10, IMAGE_WIDTH + 20, IMAGE_HEIGHT + 20));
+  QList<QPoint> pointsCovering = algorithm.findPoints (samplePointPixels (bitPlane, centers.at (0)),
+                                                       bitPlane,
+                                                       modelPointMatch,
+                                                       Points ());
+
+  // The top half holds the first two crosses, which must be the best matches, in image coordinates, with no
+  // candidates outside the region
+  QRect regionTop (0, 0, IMAGE_WIDTH, IMAGE_HEIGHT / 2);
+  algorithm.setRegion (regionTop);
+  QList<QPoint> pointsTop = algorithm.findPoints (samplePointPixels (bitPlane, centers.at (0)),
+                                                  bitPlane,
+                                                  modelPointMatch,
+                                                  Points ());
+
+  bool success = (pointsTop.count () >= 2) &&
+                 centers.mid (0, 2).contains (pointsTop.at (0)) &&
+                 centers.mid (0, 2).contains (pointsTop.at (1));
+  for (int i = 0; success && (i < pointsTop.count ()); i++) {
+    success = regionTop.contains (pointsTop.at (i));
+  }
+
+  // Regions smaller than the sample, such as a thin rectangle along the row of the first cross, or a rectangle that
+  // is mostly outside the image, are matched without overflowing the padded arrays, and still give only candidates
+  // inside the region
+  QRect regionThin (0, centers.at (0).y () - 1, IMAGE_WIDTH, 3);
+  algorithm.setRegion (regionThin);
+  QList<QPoint> pointsThin = algorithm.findPoints (samplePointPixels (bitPlane, centers.at (0)),
+                                                   bitPlane,
+                                                   modelPointMatch,
+                                                   Points ());
+
+  bool successThin = (regionThin.height () < MAX_POINT_SIZE) &&
+                     !pointsThin.isEmpty () &&
+                     (pointsThin.at (0) == centers.at (0));
+  for (int i = 0; successThin && (i < pointsThin.count ()); i++) {
+    successThin = regionThin.contains (pointsThin.at (i));
+  }
+
+  QRect regionOutside (-MAX_POINT_SIZE, IMAGE_HEIGHT - 2, 2 * MAX_POINT_SIZE, MAX_POINT_SIZE);
+  algorithm.setRegion (regionOutside);
+  QList<QPoint> pointsOutside = algorithm.findPoints (samplePointPixels (bitPlane, centers.at (0)),
+                                                      bitPlane,
+                                                      modelPointMatch,
+                                                      Points ());
+
+  QRect regionOutsideInImage = regionOutside.intersected (QRect (0, 0, IMAGE_WIDTH, IMAGE_HEIGHT));
+  bool successOutside = true;
+  for (int i = 0; successOutside && (i < pointsOutside.count ()); i++) {
+    successOutside = regionOutsideInImage.contains (pointsOutside.at (i));
+  }
+
+  QVERIFY (!pointsImage.isEmpty ());
+  QVERIFY (pointsCovering == pointsImage);
+  QVERIFY (success);
+  QVERIFY (successThin);
+  QVERIFY (successOutside);
+}
@@ -0,0 +1,45 @@
+#ifndef TEST_POINT_MATCH_H
+#define TEST_POINT_MATCH_H
+
+#include "PointMatchAlgorithm.h"
+#include "PointMatchPixel.h"
+#include <QList>
+#include <QObject>
+#include <QPoint>
+
+class BitPlane;
+
+/// Unit test of PointMatchAlgorithm, PointMatchCache and PointMatchDirect
+class TestPointMatch : public QObject
+{
+  Q_OBJECT
+public:
+  /// Single constructor.
+  explicit TestPointMatch(QObject *parent = 0);
+
+signals:
+
+private slots:
+  void cleanupTestCase ();
+  void initTestCase ();
+
+  void benchmarkEngineDirect ();
+  void benchmarkEngineDirect_data ();
+  void benchmarkEngineFft ();
+  void benchmarkEngineFft_data ();
+  void testCacheReuse ();
+  void testEnginesAgree ();
+  void testFindCrosses ();
+  void testMaxCandidates ();
+  void testMultipleSamples ();
+  void testRegion ();
+
+private:
+  void benchmarkEngine (PointMatchAlgorithm::Engine engine);
+  void benchmarkEngineData ();
+  QList<PointMatchPixel> samplePointPixels (const BitPlane &bitPlane,
+                                            const QPoint &posScreen) const;
+
+};
+
+#endif // TEST_POINT_MATCH_H
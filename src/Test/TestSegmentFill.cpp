@@ -1,3 +1,4 @@
+#include "BitPlane.h"
 #include <iostream>
 #include "Logger.h"
 #include "MainWindow.h"
@@ -6,10 +7,14 @@
 #include <QGraphicsView>
 #include <QList>
 #include <qmath.h>
+#include <QSet>
 #include <QTextStream>
 #include <QtTest/QtTest>
 #include "Segment.h"
 #include "SegmentFactory.h"
+#include "SegmentIndex.h"
+#include "SegmentScan.h"
+#include "SegmentSimplifier.h"
 #include "Spline.h"
 #include "SplinePair.h"
 #include "Test/TestSegmentFill.h"
@@ -18,6 +23,220 @@ QTEST_MAIN (TestSegmentFill)
 
 using namespace std;
 
+// Distance from a point to the nearest line of a segment, by brute force
+static double distanceToSegment (const Segment *segment,
+                                 const QPointF &pos)
+{
+  double distanceSquaredMin = -1;
+
+  const QVector<QPoint> &points = segment->points ();
+  for (int index = 1; index < points.count (); index++) {
+
+    QPointF p1 = points.at (index - 1);
+    QPointF p2 = points.at (index);
+    QPointF d = p2 - p1;
+    QPointF v = pos - p1;
+
+    double lengthSquared = d.x () * d.x () + d.y () * d.y ();
+    double s = (lengthSquared > 0 ? qMax (0.0, qMin (1.0, (v.x () * d.x () + v.y () * d.y ()) / lengthSquared)) : 0);
+    QPointF e = v - s * d;
+    double distanceSquared = e.x () * e.x () + e.y () * e.y ();
+
+    if ((distanceSquaredMin < 0) || (distanceSquared < distanceSquaredMin)) {
+      distanceSquaredMin = distanceSquared;
+    }
+  }
+
+  return qSqrt (distanceSquaredMin);
+}
+
+// Number of runs of on pixels from yStart-1 to yStop+1 in one column, checking one pixel at a time
+static int adjacentRunsByPixel (const QVector<bool> &columnBool,
+                                int yStart,
+                                int yStop)
+{
+  int runs = 0;
+  bool inRun = false;
+  for (int y = yStart - 1; y <= yStop + 1; y++) {
+    if ((0 <= y) && (y < columnBool.count ())) {
+      if (!inRun && columnBool [y]) {
+        inRun = true;
+        ++runs;
+      } else if (inRun && !columnBool [y]) {
+        inRun = false;
+      }
+    }
+  }
+
+  return runs;
+}
+
+// One flag per pixel of column x, with every flag off outside the image
+static void loadBoolByPixel (QVector<bool> &columnBool,
+                             const BitPlane &bitPlane,
+                             int x)
+{
+  for (int y = 0; y < columnBool.count (); y++) {
+    columnBool [y] = bitPlane.pixel (x, y);
+  }
+}
+
+// Find the segments by scanning every pixel of every column, with one segment pointer per pixel, as
+// SegmentFactory did before SegmentScan represented each column by its runs
+static SegmentGeometries scanByPixel (const BitPlane &bitPlane,
+                                      const DocumentModelSegments &modelSegments,
+                                      int &madeLines,
+                                      int &shortLines)
+{
+  const bool NO_GNUPLOT = false;
+
+  int width = bitPlane.width ();
+  int height = bitPlane.height ();
+
+  SegmentGeometries geometries;
+  QVector<bool> lastBool (height), currBool (height), nextBool (height);
+  QVector<SegmentSimplifier*> lastSegment (height, 0);
+  QVector<SegmentSimplifier*> currSegment (height, 0);
+
+  loadBoolByPixel (lastBool, bitPlane, -1);
+  loadBoolByPixel (currBool, bitPlane, 0);
+  loadBoolByPixel (nextBool, bitPlane, 1);
+
+  madeLines = 0;
+  shortLines = 0;
+
+  for (int x = 0; x < width; x++) {
+
+    currSegment.fill (0);
+
+    for (int y = 0; y < height; y++) {
+
+      // Each run is handled at its top pixel
+      if (!currBool [y] || ((y > 0) && currBool [y - 1])) {
+        continue;
+      }
+
+      int yStart = y;
+      int yStop = y;
+      while ((yStop + 1 < height) && currBool [yStop + 1]) {
+        ++yStop;
+      }
+
+      // Runs at branch points are skipped
+      if ((adjacentRunsByPixel (lastBool, yStart, yStop) > 1) ||
+          (adjacentRunsByPixel (nextBool, yStart, yStop) > 1)) {
+        continue;
+      }
+
+      SegmentSimplifier *seg = 0;
+      for (int yLast = qMax (0, yStart - 1); (seg == 0) && (yLast <= qMin (height - 1, yStop + 1)); yLast++) {
+        seg = lastSegment [yLast];
+      }
+
+      int yCenter = (int) (0.5 + (yStart + yStop) / 2.0);
+      if (seg == 0) {
+        seg = new SegmentSimplifier (QPoint (x, yCenter),
+                                     NO_GNUPLOT);
+      } else {
+        ++madeLines;
+        seg->appendColumn (QPoint (x, yCenter));
+      }
+
+      for (int yCurr = yStart; yCurr <= yStop; yCurr++) {
+        currSegment [yCurr] = seg;
+      }
+    }
+
+    // Segments in the previous column that do not continue into this column are finished
+    SegmentSimplifier *segLast = 0;
+    for (int yLast = 0; yLast < height; yLast++) {
+      if (lastSegment [yLast] && (lastSegment [yLast] != segLast)) {
+
+        segLast = lastSegment [yLast];
+        if (!currSegment.contains (segLast)) {
+
+          if (segLast->length () < (modelSegments.minLength () - 1) * modelSegments.pointSeparation ()) {
+            shortLines += segLast->lineCount ();
+          } else {
+            segLast->finish ();
+
+            SegmentGeometry geometry;
+            geometry.points = segLast->points ();
+            geometry.length = segLast->length ();
+            geometry.foldedLines = segLast->foldedLines ();
+            geometries.append (geometry);
+          }
+
+          delete segLast;
+        }
+      }
+    }
+
+    // Get ready for next column
+    lastBool = currBool;
+    currBool = nextBool;
+    loadBoolByPixel (nextBool, bitPlane, x + 2);
+    lastSegment.swap (currSegment);
+  }
+
+  // Segments that reach the right side are discarded
+  QSet<SegmentSimplifier*> segmentsInWork;
+  for (int y = 0; y < height; y++) {
+    if (lastSegment [y]) {
+      segmentsInWork.insert (lastSegment [y]);
+    }
+  }
+  qDeleteAll (segmentsInWork);
+
+  return geometries;
+}
+
+// Curves that wander, cross each other and change thickness, plus specks, so there are plenty of branches and
+// segments that start and stop. The width is not a multiple of 32 so the last word of each row is partly used
+static BitPlane randomCurves (quint32 seed)
+{
+  const int WIDTH = 203;
+  const int HEIGHT = 157;
+  const int CURVES = 40;
+  const int SPECKS = 300;
+
+  BitPlane bitPlane (WIDTH,
+                     HEIGHT);
+
+  for (int curve = 0; curve < CURVES; curve++) {
+
+    seed = seed * 1103515245 + 12345;
+    int xStart = (seed >> 8) % WIDTH;
+    seed = seed * 1103515245 + 12345;
+    int xStop = xStart + (seed >> 8) % (WIDTH - xStart);
+    seed = seed * 1103515245 + 12345;
+    int y = (seed >> 8) % HEIGHT;
+
+    for (int x = xStart; x <= xStop; x++) {
+
+      seed = seed * 1103515245 + 12345;
+      int step = (seed >> 8) % 8;
+      y += (step == 0 ? -2 : (step == 1 ? 2 : (step < 4 ? -1 : (step < 6 ? 1 : 0))));
+
+      seed = seed * 1103515245 + 12345;
+      int thickness = 1 + (seed >> 8) % 3;
+      for (int t = 0; t < thickness; t++) {
+        bitPlane.setPixel (x, y + t, true);
+      }
+    }
+  }
+
+  for (int speck = 0; speck < SPECKS; speck++) {
+    seed = seed * 1103515245 + 12345;
+    int x = (seed >> 8) % WIDTH;
+    seed = seed * 1103515245 + 12345;
+    int y = (seed >> 8) % HEIGHT;
+    bitPlane.setPixel (x, y, true);
+  }
+
+  return bitPlane;
+}
+
 TestSegmentFill::TestSegmentFill(QObject *parent) :
   QObject(parent)
 {
@@ -59,6 +278,44 @@ void TestSegmentFill::initTestCase ()
   m.show ();
 }
 
+void TestSegmentFill::testFillAllSegments()
+{
+  const bool NO_GNUPLOT = false;
+  const bool NO_DLG = false;
+
+  QList<Segment*> segments;
+
+  // The relative paths in this method will fail unless the directory is correct
+  QDir::setCurrent (QApplication::applicationDirPath());
+
+  QImage img ("../samples/corners.png");
+
+  QGraphicsScene *scene = new QGraphicsScene;
+  SegmentFactory segmentFactory (*scene,
+                                 NO_GNUPLOT);
+
+  DocumentModelSegments modelSegments;
+
+  segmentFactory.makeSegments (BitPlane (img),
+                               modelSegments,
+                               segments,
+                               NO_DLG);
+
+  // Points of all segments, filled concurrently, must match the points of each segment in turn
+  QList<QPoint> pointsExpected;
+  for (int indexS = 0; indexS < segments.count(); indexS++) {
+    pointsExpected += segments [indexS]->fillPoints (modelSegments);
+  }
+
+  QList<QPoint> pointsActual = segmentFactory.fillPoints (modelSegments,
+                                                          segments);
+
+  segmentFactory.clearSegments (segments);
+
+  QVERIFY (pointsExpected.count () > 0);
+  QVERIFY (pointsActual == pointsExpected);
+}
+
 void TestSegmentFill::testFindSegments()
 {
   const bool NO_GNUPLOT = false;
@@ -82,7 +339,7 @@ void TestSegmentFill::testFindSegments()
   segmentFactory.clearSegments (segments);
 
   // This will crash if dialog box appears since QApplication is not executing and therefore cannot process events
-  segmentFactory.makeSegments (img,
+  segmentFactory.makeSegments (BitPlane (img),
                                modelSegments,
                                segments,
                                NO_DLG);
@@ -136,3 +393,126 @@ void TestSegmentFill::testFindSegments()
 
   QVERIFY (success);
 }
+
+void TestSegmentFill::testScanMatchesPixelScan ()
+{
+  const bool NO_GNUPLOT = false;
+  const int RANDOM_IMAGES = 20;
+  const int COLUMNS_PER_STEP = 7;
+
+  // The relative paths in this method will fail unless the directory is correct
+  QDir::setCurrent (QApplication::applicationDirPath());
+
+  QList<BitPlane> bitPlanes;
+  bitPlanes << BitPlane (QImage ("../samples/corners.png"));
+  for (int index = 0; index < RANDOM_IMAGES; index++) {
+    bitPlanes << randomCurves (index);
+  }
+
+  // Short segments are kept by the second model, so every segment is compared and not just the long ones
+  DocumentModelSegments modelSegmentsDefault;
+  DocumentModelSegments modelSegmentsShort;
+  modelSegmentsShort.setMinLength (0);
+  QList<DocumentModelSegments> models;
+  models << modelSegmentsDefault << modelSegmentsShort;
+
+  bool success = (bitPlanes.first ().countOn () > 0);
+  for (int indexB = 0; success && (indexB < bitPlanes.count ()); indexB++) {
+    for (int indexM = 0; success && (indexM < models.count ()); indexM++) {
+
+      const BitPlane &bitPlane = bitPlanes.at (indexB);
+      const DocumentModelSegments &modelSegments = models.at (indexM);
+
+      int madeLinesExpected, shortLinesExpected;
+      SegmentGeometries geometriesExpected = scanByPixel (bitPlane,
+                                                          modelSegments,
+                                                          madeLinesExpected,
+                                                          shortLinesExpected);
+
+      // Scan a few columns at a time, like SegmentScanThread
+      SegmentGeometries geometriesGot;
+      SegmentScan scan (bitPlane,
+                        modelSegments,
+                        NO_GNUPLOT);
+      while (!scan.isDone ()) {
+        scan.scanColumns (COLUMNS_PER_STEP,
+                          geometriesGot);
+      }
+
+      success = (geometriesGot.count () == geometriesExpected.count ()) &&
+                (scan.madeLines () == madeLinesExpected) &&
+                (scan.shortLines () == shortLinesExpected);
+
+      for (int indexG = 0; success && (indexG < geometriesGot.count ()); indexG++) {
+        const SegmentGeometry &got = geometriesGot.at (indexG);
+        const SegmentGeometry &expected = geometriesExpected.at (indexG);
+        success = (got.points == expected.points) &&
+                  (got.length == expected.length) &&
+                  (got.foldedLines == expected.foldedLines);
+      }
+    }
+  }
+
+  QVERIFY (success);
+}
+
+void TestSegmentFill::testSegmentIndex()
+{
+  const bool NO_GNUPLOT = false;
+  const bool NO_DLG = false;
+  const double DISTANCE_MAX = 2.5;
+  const double STEP = 0.75;
+  const double EPSILON = 1e-9;
+
+  QList<Segment*> segments;
+
+  // The relative paths in this method will fail unless the directory is correct
+  QDir::setCurrent (QApplication::applicationDirPath());
+
+  QImage img ("../samples/corners.png");
+
+  QGraphicsScene *scene = new QGraphicsScene;
+  SegmentFactory segmentFactory (*scene,
+                                 NO_GNUPLOT);
+
+  DocumentModelSegments modelSegments;
+
+  segmentFactory.makeSegments (BitPlane (img),
+                               modelSegments,
+                               segments,
+                               NO_DLG);
+
+  SegmentIndex segmentIndex;
+  for (int indexS = 0; indexS < segments.count(); indexS++) {
+    segmentIndex.addSegment (segments [indexS]);
+  }
+
+  // Nearest segment from the index must be as close as the nearest segment found by checking every segment
+  bool success = (segments.count () > 0);
+  for (double y = 0; success && (y < img.height ()); y += STEP) {
+    for (double x = 0; success && (x < img.width ()); x += STEP) {
+
+      QPointF pos (x, y);
+
+      double distanceExpected = DISTANCE_MAX + 1;
+      for (int indexS = 0; indexS < segments.count(); indexS++) {
+        distanceExpected = qMin (distanceExpected,
+                                 distanceToSegment (segments [indexS], pos));
+      }
+
+      Segment *segment = segmentIndex.segmentNearest (pos,
+                                                      DISTANCE_MAX);
+      if (segment == 0) {
+        success = (distanceExpected > DISTANCE_MAX);
+      } else {
+        double distanceActual = distanceToSegment (segment, pos);
+        success = (qAbs (distanceActual - distanceExpected) < EPSILON) &&
+                  segmentIndex.segmentIsNear (segment, pos, distanceActual + EPSILON);
+      }
+    }
+  }
+
+  segmentFactory.clearSegments (segments);
+
+  QVERIFY (success);
+}
@@ -17,7 +17,10 @@ private slots:
   void cleanupTestCase ();
   void initTestCase ();
 
+  void testFillAllSegments ();
   void testFindSegments ();
+  void testScanMatchesPixelScan ();
+  void testSegmentIndex ();
 
 };
 
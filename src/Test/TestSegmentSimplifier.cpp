@@ -0,0 +1,197 @@
+#include "Logger.h"
+#include "MainWindow.h"
+#include <qmath.h>
+#include <QPoint>
+#include <QtTest/QtTest>
+#include <QVector>
+#include "SegmentSimplifier.h"
+#include "Test/TestSegmentSimplifier.h"
+
+QTEST_MAIN (TestSegmentSimplifier)
+
+const bool NO_GNUPLOT = false;
+
+// Fold the lines through the column centers by checking every folded point again for each new point, which is
+// the definition that SegmentSimplifier speeds up with its interval of directions
+static QVector<QPoint> foldByReference (const QVector<QPoint> &centers)
+{
+  QVector<QPoint> points;
+  QVector<QPoint> pointsRemoved;
+
+  for (int index = 0; index < centers.count (); index++) {
+
+    const QPoint &pointRight = centers.at (index);
+    if (points.count () < 2) {
+      points.append (pointRight);
+      continue;
+    }
+
+    // Every folded point, and the intermediate point, must be less than half a pixel from the longer line
+    QPoint pointLeft = points.at (points.count () - 2);
+    QVector<QPoint> pointsChecked = pointsRemoved;
+    pointsChecked.append (points.last ());
+
+    qint64 dx = pointRight.x () - pointLeft.x ();
+    qint64 dy = pointRight.y () - pointLeft.y ();
+
+    bool isClose = true;
+    for (int i = 0; isClose && (i < pointsChecked.count ()); i++) {
+      const QPoint &point = pointsChecked.at (i);
+      qint64 cross = dx * (point.y () - pointLeft.y ()) - dy * (point.x () - pointLeft.x ());
+      isClose = (4 * cross * cross < dx * dx + dy * dy);
+    }
+
+    if (isClose) {
+      pointsRemoved.append (points.last ());
+      points.last () = pointRight;
+    } else {
+      pointsRemoved.clear ();
+      points.append (pointRight);
+    }
+  }
+
+  return points;
+}
+
+// Append the column centers, after the start point, to a new simplifier
+static void appendCenters (SegmentSimplifier &simplifier,
+                           const QVector<QPoint> &centers)
+{
+  for (int index = 1; index < centers.count (); index++) {
+    simplifier.appendColumn (centers.at (index));
+  }
+  simplifier.finish ();
+}
+
+TestSegmentSimplifier::TestSegmentSimplifier(QObject *parent) :
+  QObject(parent)
+{
+}
+
+void TestSegmentSimplifier::cleanupTestCase ()
+{
+}
+
+void TestSegmentSimplifier::initTestCase ()
+{
+  const QString NO_ERROR_REPORT_LOG_FILE;
+  const QString NO_REGRESSION_OPEN_FILE;
+  const bool NO_GNUPLOT_LOG_FILES = false;
+  const bool NO_REGRESSION_IMPORT = false;
+  const bool NO_RESET = false;
+  const bool NO_EXPORT_ONLY = false;
+  const bool NO_EXTRACT_IMAGE_ONLY = false;
+  const QString NO_EXTRACT_IMAGE_EXTENSION;
+  const bool DEBUG_FLAG = false;
+  const QStringList NO_LOAD_STARTUP_FILES;
+  const QStringList NO_COMMAND_LINE;
+
+  initializeLogging ("engauge_test",
+                     "engauge_test.log",
+                     DEBUG_FLAG);
+
+  MainWindow w (NO_ERROR_REPORT_LOG_FILE,
+                NO_REGRESSION_OPEN_FILE,
+                NO_REGRESSION_IMPORT,
+                NO_GNUPLOT_LOG_FILES,
+                NO_RESET,
+                NO_EXPORT_ONLY,
+                NO_EXTRACT_IMAGE_ONLY,
+                NO_EXTRACT_IMAGE_EXTENSION,
+                NO_LOAD_STARTUP_FILES,
+                NO_COMMAND_LINE);
+  w.show ();
+}
+
+void TestSegmentSimplifier::testBend ()
+{
+  // Flat for ten columns, then climbing one pixel per column for ten columns, which folds into exactly two lines
+  QVector<QPoint> centers;
+  for (int x = 0; x <= 20; x++) {
+    centers.append (QPoint (x, (x <= 10 ? 50 : 50 + x - 10)));
+  }
+
+  SegmentSimplifier simplifier (centers.first (),
+                                NO_GNUPLOT);
+  appendCenters (simplifier,
+                 centers);
+
+  QVector<QPoint> pointsExpected;
+  pointsExpected << QPoint (0, 50) << QPoint (10, 50) << QPoint (20, 60);
+
+  QVERIFY (simplifier.points () == pointsExpected);
+  QVERIFY (simplifier.lineCount () == 20);
+  QVERIFY (simplifier.foldedLines () == 18);
+  QVERIFY (qAbs (simplifier.length () - (10 + 10 * qSqrt (2.0))) < 1e-9);
+}
+
+void TestSegmentSimplifier::testLongStraightLine ()
+{
+  // Every line of a long straight segment folds, including the lines near the end that the QList based algorithm
+  // used to skip
+  const int COLUMNS = 2000;
+
+  QVector<QPoint> centers;
+  for (int x = 0; x < COLUMNS; x++) {
+    centers.append (QPoint (x, 7));
+  }
+
+  SegmentSimplifier simplifier (centers.first (),
+                                NO_GNUPLOT);
+  appendCenters (simplifier,
+                 centers);
+
+  QVERIFY (simplifier.points ().count () == 2);
+  QVERIFY (simplifier.points ().last () == QPoint (COLUMNS - 1, 7));
+  QVERIFY (simplifier.foldedLines () == COLUMNS - 2);
+}
+
+void TestSegmentSimplifier::testRandomWalksMatchReference ()
+{
+  const int WALKS = 200;
+  const int COLUMNS_MAX = 400;
+
+  // Walks from a fixed linear congruential sequence so the test is repeatable. Small steps give long folds whose
+  // directions often graze the edge of the interval, and occasional big steps break them up
+  quint32 seed = 12345;
+  bool success = true;
+  for (int walk = 0; success && (walk < WALKS); walk++) {
+
+    seed = seed * 1103515245 + 12345;
+    int columns = 1 + (seed >> 8) % COLUMNS_MAX;
+
+    QVector<QPoint> centers;
+    int y = 0;
+    for (int x = 0; x < columns; x++) {
+      seed = seed * 1103515245 + 12345;
+      int step = (seed >> 8) % 16;
+      y += (step == 0 ? 5 : (step < 3 ? 1 : (step < 5 ? -1 : 0)));
+      centers.append (QPoint (x, y));
+    }
+
+    SegmentSimplifier simplifier (centers.first (),
+                                  NO_GNUPLOT);
+    appendCenters (simplifier,
+                   centers);
+
+    QVector<QPoint> pointsExpected = foldByReference (centers);
+
+    success = (simplifier.points () == pointsExpected) &&
+              (simplifier.lineCount () == columns - 1) &&
+              (simplifier.foldedLines () == columns - pointsExpected.count ());
+  }
+
+  QVERIFY (success);
+}
+
+void TestSegmentSimplifier::testSinglePoint ()
+{
+  SegmentSimplifier simplifier (QPoint (3, 4),
+                                NO_GNUPLOT);
+  simplifier.finish ();
+
+  QVERIFY (simplifier.points ().count () == 1);
+  QVERIFY (simplifier.lineCount () == 0);
+  QVERIFY (simplifier.foldedLines () == 0);
+  QVERIFY (simplifier.length () == 0);
+}
@@ -0,0 +1,27 @@
+#ifndef TEST_SEGMENT_SIMPLIFIER_H
+#define TEST_SEGMENT_SIMPLIFIER_H
+
+#include <QObject>
+
+/// Unit test of SegmentSimplifier class
+class TestSegmentSimplifier : public QObject
+{
+  Q_OBJECT
+public:
+  /// Single constructor.
+  explicit TestSegmentSimplifier(QObject *parent = 0);
+
+signals:
+
+private slots:
+  void cleanupTestCase ();
+  void initTestCase ();
+
+  void testBend ();
+  void testLongStraightLine ();
+  void testRandomWalksMatchReference ();
+  void testSinglePoint ();
+
+};
+
+#endif // TEST_SEGMENT_SIMPLIFIER_H
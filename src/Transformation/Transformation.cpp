@@ -50,7 +50,7 @@ Transformation &Transformation::operator=(const Transformation &other)
   return *this;
 }
 
-bool Transformation::operator!=(const Transformation &other)
+bool Transformation::operator!=(const Transformation &other) const
 {
   return (m_transformIsDefined != other.transformIsDefined()) ||
          (m_transform != other.transformMatrix ());
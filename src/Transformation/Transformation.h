@@ -49,7 +49,7 @@ public:
   void identity();
 
   /// Inequality operator. This is marked as defined.
-  bool operator!=(const Transformation &other);
+  bool operator!=(const Transformation &other) const;
 
   /// Calculate QTransform using from/to points that have already been adjusted for, when applicable,
   /// log scaling and polar coordinates. The points are linear and cartesian.
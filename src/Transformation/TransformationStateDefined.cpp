@@ -4,9 +4,11 @@
  * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
  ******************************************************************************************************/
 
+#include "BitPlane.h"
 #include "CallbackAxesCheckerFromAxesPoints.h"
 #include "Checker.h"
 #include "CmdMediator.h"
+#include "ColorFilter.h"
 #include "Document.h"
 #include "EnumsToQt.h"
 #include "FilterImage.h"
@@ -82,13 +84,17 @@ void TransformationStateDefined::initializeModelGridRemoval (bool isGnuplot,
   LOG4CPP_INFO_S ((*mainCat)) << "TransformationStateDefined::initializeModelGridRemoval";
 
   // Generate filtered image
+  QImage imageUnfiltered = cmdMediator.document().pixmap().toImage();
+  ColorFilter colorFilter;
   FilterImage filterImage;
-  QPixmap pixmapFiltered = filterImage.filter (isGnuplot,
-                                               cmdMediator.document().pixmap().toImage(),
-                                               transformation,
-                                               selectedGraphCurve,
-                                               cmdMediator.document().modelColorFilter(),
-                                               cmdMediator.document().modelGridRemoval());
+  BitPlane bitPlaneFiltered = filterImage.filter (isGnuplot,
+                                                  imageUnfiltered,
+                                                  colorFilter.marginColor (&imageUnfiltered),
+                                                  transformation,
+                                                  selectedGraphCurve,
+                                                  cmdMediator.document().modelColorFilter(),
+                                                  cmdMediator.document().modelGridRemoval());
+  QPixmap pixmapFiltered = QPixmap::fromImage (bitPlaneFiltered.toImage ());
 
   // Initialize grid removal settings so user does not have to
   int countX, countY;
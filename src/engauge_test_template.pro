@@ -35,6 +35,7 @@ HEADERS  += \
     Background/BackgroundStateNone.h \
     Background/BackgroundStateOriginal.h \
     Background/BackgroundStateUnloaded.h \
+    util/BitPlane.h \
     Callback/CallbackAddPointsInCurvesGraphs.h \
     Callback/CallbackAxesCheckerFromAxesPoints.h \
     Callback/CallbackAxisPointsAbstract.h \
@@ -94,8 +95,10 @@ HEADERS  += \
     Cmd/CmdUndoForTest.h \
     Color/ColorConstants.h \
     Color/ColorFilter.h \
+    Color/ColorFilterEngine.h \
     Color/ColorFilterEntry.h \
     Color/ColorFilterHistogram.h \
+    Color/ColorFilterLookup.h \
     Color/ColorFilterMode.h \
     Color/ColorFilterSettings.h \
     Color/ColorFilterSettingsStrategyAbstractBase.h \
@@ -111,6 +114,7 @@ HEADERS  += \
     Color/ColorFilterStrategySaturation.h \
     Color/ColorFilterStrategyValue.h \
     Color/ColorPalette.h \
+    util/ConnectedComponents.h \
     Coord/CoordScale.h \
     Coord/CoordsType.h \
     Coord/CoordSymbol.h \
@@ -232,6 +236,7 @@ HEADERS  += \
     Export/ExportValuesOrdinal.h \
     Export/ExportValuesXOrY.h \
     Export/ExportXThetaValuesMergedFunctions.h \
+    util/FftwPlannerLock.h \
     FileCmd/FileCmdAbstract.h \
     FileCmd/FileCmdClose.h \
     FileCmd/FileCmdExport.h \
@@ -330,7 +335,11 @@ HEADERS  += \
     Point/PointComparator.h \
     Point/PointIdentifiers.h \
     Point/PointMatchAlgorithm.h \
+    Point/PointMatchCache.h \
+    Point/PointMatchDirect.h \
     Point/PointMatchPixel.h \
+    Point/PointMatchRegion.h \
+    Point/PointMatchThread.h \
     Point/PointMatchTriplet.h \
     Point/Points.h \
     Point/PointShape.h \
@@ -339,7 +348,13 @@ HEADERS  += \
     ScaleBar/ScaleBarAxisPointsUnite.h \
     Segment/Segment.h \
     Segment/SegmentFactory.h \
+    Segment/SegmentGeometry.h \
+    Segment/SegmentIndex.h \
     Segment/SegmentLine.h \
+    Segment/SegmentRun.h \
+    Segment/SegmentScan.h \
+    Segment/SegmentScanThread.h \
+    Segment/SegmentSimplifier.h \
     Settings/Settings.h \
     Settings/SettingsForGraph.h \
     Spline/Spline.h \
@@ -399,6 +414,7 @@ SOURCES += \
     Background/BackgroundStateNone.cpp \
     Background/BackgroundStateOriginal.cpp \
     Background/BackgroundStateUnloaded.cpp \
+    util/BitPlane.cpp \
     Callback/CallbackAddPointsInCurvesGraphs.cpp \
     Callback/CallbackAxesCheckerFromAxesPoints.cpp \
     Callback/CallbackAxisPointsAbstract.cpp \
@@ -456,7 +472,9 @@ SOURCES += \
     Cmd/CmdStackShadow.cpp \
     Cmd/CmdUndoForTest.cpp \
     Color/ColorFilter.cpp \
+    Color/ColorFilterEngine.cpp \
     Color/ColorFilterHistogram.cpp \
+    Color/ColorFilterLookup.cpp \
     Color/ColorFilterMode.cpp \
     Color/ColorFilterSettings.cpp \
     Color/ColorFilterSettingsStrategyAbstractBase.cpp \
@@ -472,6 +490,7 @@ SOURCES += \
     Color/ColorFilterStrategySaturation.cpp \
     Color/ColorFilterStrategyValue.cpp \
     Color/ColorPalette.cpp \
+    util/ConnectedComponents.cpp \
     Coord/CoordScale.cpp \
     Coord/CoordsType.cpp \
     Coord/CoordSymbol.cpp \
@@ -586,6 +605,7 @@ SOURCES += \
     Export/ExportToClipboard.cpp \
     Export/ExportToFile.cpp \
     Export/ExportXThetaValuesMergedFunctions.cpp \
+    util/FftwPlannerLock.cpp \
     FileCmd/FileCmdAbstract.cpp \
     FileCmd/FileCmdClose.cpp \
     FileCmd/FileCmdExport.cpp \
@@ -674,7 +694,11 @@ SOURCES += \
     Point/Point.cpp \
     Point/PointIdentifiers.cpp \
     Point/PointMatchAlgorithm.cpp \
+    Point/PointMatchCache.cpp \
+    Point/PointMatchDirect.cpp \
     Point/PointMatchPixel.cpp \
+    Point/PointMatchRegion.cpp \
+    Point/PointMatchThread.cpp \
     Point/PointMatchTriplet.cpp \
     Point/PointShape.cpp \
     Point/PointStyle.cpp \
@@ -682,7 +706,11 @@ SOURCES += \
     ScaleBar/ScaleBarAxisPointsUnite.cpp \    
     Segment/Segment.cpp \
     Segment/SegmentFactory.cpp \
+    Segment/SegmentIndex.cpp \
     Segment/SegmentLine.cpp \
+    Segment/SegmentScan.cpp \
+    Segment/SegmentScanThread.cpp \
+    Segment/SegmentSimplifier.cpp \
     Settings/Settings.cpp \
     Settings/SettingsForGraph.cpp \
     Spline/Spline.cpp \
@@ -731,7 +759,7 @@ SOURCES += \
 
 TARGET = ../bin/TEST
 
-QT += core gui network printsupport testlib widgets xml help
+QT += concurrent core gui network printsupport testlib widgets xml help
 
 LIBS += -L$$(LOG4CPP_HOME)/lib -L$$(FFTW_HOME)/lib
 
@@ -739,7 +767,7 @@ win32-g++* {
 CONFIG += windows
 }
 
-LIBS += -llog4cpp -lfftw3
+LIBS += -llog4cpp -lfftw3_threads -lfftw3
 INCLUDEPATH += Background \
                Callback \
                Checker \
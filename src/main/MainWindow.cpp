@@ -287,6 +287,11 @@ void MainWindow::closeEvent(QCloseEvent *event)
   }
 }
 
+const BitPlane &MainWindow::bitPlaneFiltered () const
+{
+  return m_backgroundStateContext->bitPlaneForCurveState();
+}
+
 void MainWindow::cmdFileClose()
 {
   LOG4CPP_INFO_S ((*mainCat)) << "MainWindow::cmdFileClose";
@@ -796,11 +801,6 @@ void MainWindow::handlerFileExtractImage ()
   }
 }
 
-QImage MainWindow::imageFiltered () const
-{
-  return m_backgroundStateContext->imageForCurveState();
-}
-
 bool MainWindow::isGnuplot() const
 {
   return m_isGnuplot;
@@ -1135,6 +1135,11 @@ bool MainWindow::modeMap () const
   return success;
 }
 
+QRgb MainWindow::marginColor () const
+{
+  return m_backgroundStateContext->marginColor();
+}
+
 bool MainWindow::maybeSave()
 {
   if (m_cmdMediator != 0) {
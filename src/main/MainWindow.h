@@ -17,6 +17,7 @@
 #include <QCursor>
 #include <QMainWindow>
 #include <QMap>
+#include <QRgb>
 #include <QUrl>
 #include "Transformation.h"
 #include "ZoomControl.h"
@@ -24,6 +25,7 @@
 #include "ZoomFactorInitial.h"
 
 class BackgroundStateContext;
+class BitPlane;
 class ChecklistGuide;
 class CmdMediator;
 class CmdStackShadow;
@@ -140,6 +142,9 @@ public:
              QWidget *parent = 0);
   ~MainWindow();
 
+  /// Background image that has been filtered for the current curve, in packed form
+  const BitPlane &bitPlaneFiltered () const;
+
   /// Close file. This is called from a file script command
   void cmdFileClose();
 
@@ -158,12 +163,12 @@ public:
   /// Catch secret keypresses
   virtual bool eventFilter(QObject *, QEvent *);
 
-  /// Background image that has been filtered for the current curve. This asserts if a curve-specific image is not being shown
-  QImage imageFiltered () const;
-
   /// Get method for gnuplot flag
   bool isGnuplot() const;
 
+  /// Most common color in the margins of the original image. This is cached so it is computed only once per image
+  QRgb marginColor () const;
+
   /// Get method for main window model
   MainWindowModel modelMainWindow () const;
 
@@ -14,10 +14,15 @@
 #include <QDebug>
 #include <QDir>
 #include <QFileInfo>
+#include <QList>
 #include <QMessageBox>
 #include <QObject>
+#include <QPoint>
 #include <QProcessEnvironment>
 #include <QStyleFactory>
+#include <QThread>
+#include <QThreadPool>
+#include "SegmentGeometry.h"
 #include "TranslatorContainer.h"
 #include "ZoomFactor.h"
 
@@ -33,6 +38,7 @@ const QString CMD_HELP ("help");
 const QString CMD_REGRESSION ("regression");
 const QString CMD_RESET ("reset");
 const QString CMD_STYLES ("styles"); // Not to be confused with -style option that qt handles
+const QString CMD_THREADS ("threads");
 const QString DASH ("-");
 const QString DASH_DEBUG ("-" + CMD_DEBUG);
 const QString DASH_ERROR_REPORT ("-" + CMD_ERROR_REPORT);
@@ -44,6 +50,7 @@ const QString DASH_HELP ("-" + CMD_HELP);
 const QString DASH_REGRESSION ("-" + CMD_REGRESSION);
 const QString DASH_RESET ("-" + CMD_RESET);
 const QString DASH_STYLES ("-" + CMD_STYLES);
+const QString DASH_THREADS ("-" + CMD_THREADS);
 const QString ENGAUGE_LOG_FILE (".engauge.log");
 
 // Prototypes
@@ -62,6 +69,7 @@ void parseCmdLine (int argc,
                    bool &isExportOnly,
                    bool &isExtractImageOnly,
                    QString &extractImageOnlyExtension,
+                   int &threadCount,
                    QStringList &loadStartupFiles,
                    QStringList &commandLineWithoutLoadStartupFiles);
 void sanityCheckLoadStartupFiles (bool isRepeatingFlag,
@@ -128,6 +136,9 @@ int main(int argc, char *argv[])
 {
   qRegisterMetaType<ColorFilterMode> ("ColorFilterMode");
   qRegisterMetaType<FittingCurveCoefficients> ("FilterCurveCoefficients");
+  qRegisterMetaType<QList<int> > ("QList<int>");
+  qRegisterMetaType<QList<QPoint> > ("QList<QPoint>");
+  qRegisterMetaType<SegmentGeometries> ("SegmentGeometries");
   qRegisterMetaType<ZoomFactor> ("ZoomFactor");
 
   QApplication app(argc, argv);
@@ -138,6 +149,7 @@ int main(int argc, char *argv[])
   // Command line
   bool isDebug, isReset, isGnuplot, isErrorReportRegressionTest, isExportOnly, isExtractImageOnly;
   QString errorReportFile, extractImageOnlyExtension, fileCmdScriptFile;
+  int threadCount;
   QStringList loadStartupFiles, commandLineWithoutLoadStartupFiles;
   parseCmdLine (argc,
                 argv,
@@ -150,9 +162,13 @@ int main(int argc, char *argv[])
                 isExportOnly,
                 isExtractImageOnly,
                 extractImageOnlyExtension,
+                threadCount,
                 loadStartupFiles,
                 commandLineWithoutLoadStartupFiles);
 
+  // Image processing, like the color filtering in FilterImage, is spread across the threads of the global pool
+  QThreadPool::globalInstance()->setMaxThreadCount (threadCount);
+
   // Logging
   initializeLogging ("engauge",
                      engaugeLogFilename(),
@@ -187,6 +203,7 @@ void parseCmdLine (int argc,
                    bool &isExportOnly,
                    bool &isExtractImageOnly,
                    QString &extractImageOnlyExtension,
+                   int &threadCount,
                    QStringList &loadStartupFiles,
                    QStringList &commandLineWithoutLoadStartupFiles)
 {
@@ -198,6 +215,7 @@ void parseCmdLine (int argc,
   bool nextIsErrorReportFile = false;
   bool nextIsExtractImageOnly = false;
   bool nextIsFileCmdScript = false;
+  bool nextIsThreads = false;
 
   // Defaults
   isDebug = false;
@@ -209,6 +227,7 @@ void parseCmdLine (int argc,
   isExportOnly = false;
   isExtractImageOnly = false;
   extractImageOnlyExtension = "";
+  threadCount = QThread::idealThreadCount ();
 
   for (int i = 1; i < argc; i++) {
 
@@ -232,6 +251,13 @@ void parseCmdLine (int argc,
                         QObject::tr ("is not a valid file name"));
       fileCmdScriptFile = argv [i];
       nextIsFileCmdScript = false;
+    } else if (nextIsThreads) {
+      bool ok;
+      threadCount = QString (argv [i]).toInt (&ok);
+      sanityCheckValue (ok && (threadCount > 0),
+                        argv [i],
+                        QObject::tr ("is not a valid thread count"));
+      nextIsThreads = false;
     } else if (strcmp (argv [i], DASH_DEBUG.toLatin1().data()) == 0) {
       isDebug = true;
     } else if (strcmp (argv [i], DASH_ERROR_REPORT.toLatin1().data()) == 0) {
@@ -253,6 +279,8 @@ void parseCmdLine (int argc,
       isReset = true;
     } else if (strcmp (argv [i], DASH_STYLES.toLatin1().data()) == 0) {
       showStylesAndQuit ();
+    } else if (strcmp (argv [i], DASH_THREADS.toLatin1().data()) == 0) {
+      nextIsThreads = true;
     } else if (strncmp (argv [i], DASH.toLatin1().data(), 1) == 0) {
       showUsage = true; // User entered an unrecognized token
     } else {
@@ -287,7 +315,7 @@ void parseCmdLine (int argc,
                                loadStartupFiles);
 
   // Usage
-  if (showUsage || nextIsErrorReportFile || nextIsExtractImageOnly || nextIsFileCmdScript) {
+  if (showUsage || nextIsErrorReportFile || nextIsExtractImageOnly || nextIsFileCmdScript || nextIsThreads) {
 
     showUsageAndQuit ();
 
@@ -359,6 +387,7 @@ void showUsageAndQuit ()
       << "[" << DASH_REGRESSION.toLatin1().data() << "] "
       << "[" << DASH_RESET.toLatin1().data () << "] "
       << "[" << DASH_STYLES.toLatin1().data () << "] "
+      << "[" << DASH_THREADS.toLatin1().data () << " &lt;count&gt;] "
       << "[&lt;load_file1&gt;] [&lt;load_file2&gt;] ..." << endl
       << "<table>"
       << "<tr>"
@@ -422,6 +451,12 @@ void showUsageAndQuit ()
       << "</td>"
       << "</tr>"
       << "<tr>"
+      << "<td>" << DASH_THREADS.toLatin1().data() << "</td>"
+      << "<td>"
+      << QObject::tr ("Number of threads used for image processing. Default is the number of processor cores").toLatin1().data()
+      << "</td>"
+      << "</tr>"
+      << "<tr>"
       << "<td>" << QString ("&lt;load file&gt; ").toLatin1().data() << "</td>"
       << "<td>"
       << QObject::tr ("File(s) to be imported or opened at startup").toLatin1().data()
@@ -0,0 +1,180 @@
+/******************************************************************************************************
+ * (C) 2014 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#include "BitPlane.h"
+#include "EngaugeAssert.h"
+#include <QRgb>
+#include <QtAlgorithms>
+
+const int BITS_PER_WORD = 32;
+
+const QRgb RGB_ON = 0xff000000;
+const QRgb RGB_OFF = 0xffffffff;
+
+BitPlane::BitPlane () :
+  m_width (0),
+  m_height (0),
+  m_wordsPerRow (0)
+{
+}
+
+BitPlane::BitPlane (int width,
+                    int height) :
+  m_width (width),
+  m_height (height),
+  m_wordsPerRow ((width + BITS_PER_WORD - 1) / BITS_PER_WORD),
+  m_words (m_wordsPerRow * height, 0)
+{
+}
+
+BitPlane::BitPlane (const QImage &image,
+                    int thresholdGray) :
+  m_width (image.width ()),
+  m_height (image.height ()),
+  m_wordsPerRow ((image.width () + BITS_PER_WORD - 1) / BITS_PER_WORD),
+  m_words (m_wordsPerRow * image.height (), 0)
+{
+  // Read raw scanlines. Alpha is ignored by qGray, but premultiplied and non-32-bit formats must be converted first
+  QImage image32 = image;
+  if (image.format () != QImage::Format_RGB32 &&
+      image.format () != QImage::Format_ARGB32) {
+    image32 = image.convertToFormat (QImage::Format_RGB32);
+  }
+
+  for (int y = 0; y < m_height; y++) {
+
+    const QRgb *in = (const QRgb *) image32.constScanLine (y);
+    quint32 *out = rowForWriting (y);
+
+    for (int x = 0; x < m_width; x++) {
+      if (qGray (in [x]) < thresholdGray) {
+        out [x >> 5] |= (quint32) 1 << (x & 31);
+      }
+    }
+  }
+}
+
+BitPlane BitPlane::copy (const QRect &rect) const
+{
+  ENGAUGE_ASSERT (QRect (0, 0, m_width, m_height).contains (rect));
+
+  BitPlane bitPlane (rect.width (),
+                     rect.height ());
+
+  // Each word of the copy comes from the two words of this plane that it straddles. The second word is past the end
+  // of the row only when the bits needed from it are all padding
+  int wordFirst = rect.x () / BITS_PER_WORD;
+  int shift = rect.x () % BITS_PER_WORD;
+  int wordsAvailable = m_wordsPerRow - wordFirst;
+  int bitsInLastWord = rect.width () - (bitPlane.m_wordsPerRow - 1) * BITS_PER_WORD;
+  quint32 maskLastWord = (bitsInLastWord == BITS_PER_WORD ?
+                          ~ (quint32) 0 :
+                          ((quint32) 1 << bitsInLastWord) - 1);
+
+  for (int y = 0; y < rect.height (); y++) {
+
+    const quint32 *in = row (rect.y () + y) + wordFirst;
+    quint32 *out = bitPlane.rowForWriting (y);
+
+    for (int w = 0; w < bitPlane.m_wordsPerRow; w++) {
+
+      quint32 word = in [w] >> shift;
+      if ((shift != 0) && (w + 1 < wordsAvailable)) {
+        word |= in [w + 1] << (BITS_PER_WORD - shift);
+      }
+      out [w] = word;
+    }
+
+    // Padding bits must stay zero
+    out [bitPlane.m_wordsPerRow - 1] &= maskLastWord;
+  }
+
+  return bitPlane;
+}
+
+int BitPlane::countOn () const
+{
+  int count = 0;
+  for (int i = 0; i < m_words.count (); i++) {
+    count += qPopulationCount (m_words [i]);
+  }
+
+  return count;
+}
+
+int BitPlane::height () const
+{
+  return m_height;
+}
+
+bool BitPlane::isNull () const
+{
+  return (m_width == 0 || m_height == 0);
+}
+
+bool BitPlane::operator== (const BitPlane &other) const
+{
+  // Padding bits are always zero, so whole words can be compared
+  return (m_width == other.m_width) &&
+         (m_height == other.m_height) &&
+         (m_words == other.m_words);
+}
+
+bool BitPlane::operator!= (const BitPlane &other) const
+{
+  return !(*this == other);
+}
+
+QSize BitPlane::size () const
+{
+  return QSize (m_width, m_height);
+}
+
+QImage BitPlane::toImage () const
+{
+  QImage image (m_width,
+                m_height,
+                QImage::Format_RGB32);
+
+  for (int y = 0; y < m_height; y++) {
+
+    const quint32 *in = row (y);
+    QRgb *out = (QRgb *) image.scanLine (y);
+
+    for (int w = 0; w < m_wordsPerRow; w++) {
+
+      quint32 word = in [w];
+      int xStart = w * BITS_PER_WORD;
+      int xStop = qMin (xStart + BITS_PER_WORD, m_width);
+
+      if (word == 0) {
+
+        // Whole word is off, which is the common case
+        for (int x = xStart; x < xStop; x++) {
+          out [x] = RGB_OFF;
+        }
+
+      } else {
+
+        for (int x = xStart; x < xStop; x++) {
+          out [x] = ((word >> (x - xStart)) & 1) ? RGB_ON : RGB_OFF;
+        }
+      }
+    }
+  }
+
+  return image;
+}
+
+int BitPlane::width () const
+{
+  return m_width;
+}
+
+int BitPlane::wordsPerRow () const
+{
+  return m_wordsPerRow;
+}
@@ -0,0 +1,120 @@
+/******************************************************************************************************
+ * (C) 2014 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#ifndef BIT_PLANE_H
+#define BIT_PLANE_H
+
+#include "ColorConstants.h"
+#include <QImage>
+#include <QRect>
+#include <QVector>
+
+/// Packed black and white image with one bit per pixel, which is 32 times smaller than the equivalent
+/// QImage::Format_RGB32 image. This is the format of the filtered image, so the consumers (segment fill, point match
+/// and grid removal) can test pixels without qGray and QImage overhead, and skip over empty areas a word at a time.
+///
+/// Each row is padded to a whole number of 32-bit words. Bit i of word w in a row holds the pixel at x=32*w+i, and
+/// is set when the pixel is on (black). Padding bits are always zero
+class BitPlane
+{
+public:
+  /// Default constructor for an empty plane
+  BitPlane ();
+
+  /// Constructor for a plane of the specified size with all pixels off
+  BitPlane (int width,
+            int height);
+
+  /// Constructor that thresholds an image, turning on the pixels whose gray level is below thresholdGray. The default
+  /// gives the same on/off decision as ColorFilter::pixelFilteredIsOn
+  explicit BitPlane (const QImage &image,
+                     int thresholdGray = BLACK_WHITE_THRESHOLD);
+
+  /// Copy of the pixels in a rectangle, which must lie within this plane, like QImage::copy. Whole words are shifted
+  /// into place rather than copying one pixel at a time
+  BitPlane copy (const QRect &rect) const;
+
+  /// Number of on pixels
+  int countOn () const;
+
+  /// Height in pixels
+  int height () const;
+
+  /// True if the plane has no pixels
+  bool isNull () const;
+
+  /// True if both planes have the same size and the same pixels
+  bool operator== (const BitPlane &other) const;
+
+  /// True if the planes differ in size or in any pixel
+  bool operator!= (const BitPlane &other) const;
+
+  /// Return true if the pixel is on. Pixels outside the plane are off, like ColorFilter::pixelFilteredIsOn
+  inline bool pixel (int x,
+                     int y) const
+  {
+    if ((0 <= x) &&
+        (0 <= y) &&
+        (x < m_width) &&
+        (y < m_height)) {
+      return (m_words [y * m_wordsPerRow + (x >> 5)] >> (x & 31)) & 1;
+    }
+
+    return false;
+  }
+
+  /// Start of the words for one row
+  inline const quint32 *row (int y) const
+  {
+    return m_words.constData () + y * m_wordsPerRow;
+  }
+
+  /// Start of the words for one row, for writing. Padding bits must be left as zero
+  inline quint32 *rowForWriting (int y)
+  {
+    return m_words.data () + y * m_wordsPerRow;
+  }
+
+  /// Turn pixel on or off. Pixels outside the plane are silently ignored, like QImage::setPixel
+  inline void setPixel (int x,
+                        int y,
+                        bool on)
+  {
+    if ((0 <= x) &&
+        (0 <= y) &&
+        (x < m_width) &&
+        (y < m_height)) {
+      quint32 &word = m_words [y * m_wordsPerRow + (x >> 5)];
+      quint32 mask = (quint32) 1 << (x & 31);
+      if (on) {
+        word |= mask;
+      } else {
+        word &= ~mask;
+      }
+    }
+  }
+
+  /// Size in pixels
+  QSize size () const;
+
+  /// Expand into a QImage::Format_RGB32 image with black on pixels and white off pixels, for display
+  QImage toImage () const;
+
+  /// Width in pixels
+  int width () const;
+
+  /// Number of 32-bit words in each row
+  int wordsPerRow () const;
+
+private:
+
+  int m_width;
+  int m_height;
+  int m_wordsPerRow;
+  QVector<quint32> m_words;
+};
+
+#endif // BIT_PLANE_H
@@ -0,0 +1,382 @@
+/******************************************************************************************************
+ * (C) 2018 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#include "BitPlane.h"
+#include "ConnectedComponents.h"
+#include "EngaugeAssert.h"
+#include "Logger.h"
+#include <QList>
+#include <QtAlgorithms>
+#include <QtConcurrentMap>
+#include <QThreadPool>
+
+const int BANDS_PER_THREAD = 4; // More bands than threads evens out the load when some threads start late
+const int MIN_ROWS_PER_BAND = 64;
+
+/// Rows of a BitPlane that are labeled by one QtConcurrent task. Run indexes are local to the band until the bands
+/// are merged
+struct ConnectedComponentsBand
+{
+  const BitPlane *bitPlane;
+  bool on;
+  int yStart;
+  int yStop;
+  QVector<ConnectedComponentRun> runs;
+  QVector<int> rowStarts; // One entry per row, plus one for the end of the last row
+  QVector<int> parents; // Union-find parent of each run
+};
+
+// Root of the union-find set containing a run. Path halving keeps the trees shallow
+static int findRoot (QVector<int> &parents,
+                     int index)
+{
+  while (parents [index] != index) {
+    parents [index] = parents [parents [index]];
+    index = parents [index];
+  }
+
+  return index;
+}
+
+// Join the sets of two runs. The root with the lower index is kept, so each root is the first run of its set
+static void unite (QVector<int> &parents,
+                   int index0,
+                   int index1)
+{
+  int root0 = findRoot (parents, index0);
+  int root1 = findRoot (parents, index1);
+
+  if (root0 < root1) {
+    parents [root1] = root0;
+  } else if (root1 < root0) {
+    parents [root0] = root1;
+  }
+}
+
+// Join each run of one row to the runs of the row above that touch it, including diagonally. Both rows are sorted
+// from left to right, so this is a merge of two lists of intervals
+static void joinRows (const QVector<ConnectedComponentRun> &runs,
+                      QVector<int> &parents,
+                      int aboveStart,
+                      int aboveStop,
+                      int rowStart,
+                      int rowStop)
+{
+  int above = aboveStart;
+  for (int index = rowStart; index < rowStop; index++) {
+
+    const ConnectedComponentRun &run = runs.at (index);
+
+    // Skip runs above that end too far left to touch this run. They also end too far left for the later runs
+    while ((above < aboveStop) &&
+           (runs.at (above).xStop < run.xStart - 1)) {
+      ++above;
+    }
+
+    for (int i = above; (i < aboveStop) && (runs.at (i).xStart <= run.xStop + 1); i++) {
+      unite (parents,
+             i,
+             index);
+    }
+  }
+}
+
+// Word w of a row, with bits set for the pixels being labeled. Padding bits are never set
+static inline quint32 wordLabeled (const quint32 *row,
+                                   int w,
+                                   int wordsPerRow,
+                                   quint32 maskLast,
+                                   bool on)
+{
+  quint32 word = (on ? row [w] : ~row [w]);
+  if (w == wordsPerRow - 1) {
+    word &= maskLast;
+  }
+
+  return word;
+}
+
+// First column at or after xFrom whose pixel is labeled (if wanted is true) or not labeled (if wanted is false), or
+// the width if there is none. Words without such a pixel are skipped whole
+static int findPixel (const quint32 *row,
+                      int wordsPerRow,
+                      quint32 maskLast,
+                      bool on,
+                      bool wanted,
+                      int xFrom,
+                      int width)
+{
+  int w = xFrom >> 5;
+  if (w >= wordsPerRow) {
+    return width;
+  }
+
+  quint32 bits = wordLabeled (row, w, wordsPerRow, maskLast, on);
+  if (!wanted) {
+    bits = ~bits;
+  }
+  bits &= ~(quint32) 0 << (xFrom & 31);
+
+  while ((bits == 0) && (++w < wordsPerRow)) {
+    bits = wordLabeled (row, w, wordsPerRow, maskLast, on);
+    if (!wanted) {
+      bits = ~bits;
+    }
+  }
+
+  if (bits == 0) {
+    return width;
+  }
+
+  return qMin (width, 32 * w + (int) qCountTrailingZeroBits (bits));
+}
+
+// First pass over the rows of one band
+static void labelBand (ConnectedComponentsBand &band)
+{
+  const BitPlane &bitPlane = *band.bitPlane;
+  int width = bitPlane.width ();
+  int wordsPerRow = bitPlane.wordsPerRow ();
+  quint32 maskLast = ((width & 31) == 0 ? ~(quint32) 0 : ((quint32) 1 << (width & 31)) - 1);
+
+  for (int y = band.yStart; y < band.yStop; y++) {
+
+    const quint32 *row = bitPlane.row (y);
+    int rowStart = band.runs.count ();
+    band.rowStarts.append (rowStart);
+
+    int x = findPixel (row, wordsPerRow, maskLast, band.on, true, 0, width);
+    while (x < width) {
+
+      ConnectedComponentRun run;
+      run.xStart = x;
+      run.xStop = findPixel (row, wordsPerRow, maskLast, band.on, false, x, width) - 1;
+      run.label = -1;
+
+      band.parents.append (band.runs.count ());
+      band.runs.append (run);
+
+      x = findPixel (row, wordsPerRow, maskLast, band.on, true, run.xStop + 1, width);
+    }
+
+    if (y > band.yStart) {
+      joinRows (band.runs,
+                band.parents,
+                band.rowStarts.at (y - band.yStart - 1),
+                rowStart,
+                rowStart,
+                band.runs.count ());
+    }
+  }
+
+  band.rowStarts.append (band.runs.count ());
+}
+
+ConnectedComponents::ConnectedComponents () :
+  m_width (0),
+  m_height (0)
+{
+  m_rowStarts.append (0);
+}
+
+ConnectedComponents::ConnectedComponents (const BitPlane &bitPlane,
+                                          bool on) :
+  m_width (bitPlane.width ()),
+  m_height (bitPlane.height ())
+{
+  int threadCount = QThreadPool::globalInstance()->maxThreadCount();
+  int bandCount = 1;
+  if (threadCount > 1) {
+    bandCount = qMax (1, qMin (threadCount * BANDS_PER_THREAD,
+                               m_height / MIN_ROWS_PER_BAND));
+  }
+
+  QList<ConnectedComponentsBand> bands;
+  for (int band = 0; band < bandCount; band++) {
+
+    ConnectedComponentsBand componentsBand;
+    componentsBand.bitPlane = &bitPlane;
+    componentsBand.on = on;
+    componentsBand.yStart = (band * m_height) / bandCount;
+    componentsBand.yStop = ((band + 1) * m_height) / bandCount;
+
+    bands << componentsBand;
+  }
+
+  if (bandCount == 1) {
+    labelBand (bands.first ());
+  } else {
+    QtConcurrent::blockingMap (bands,
+                               labelBand);
+  }
+
+  // Merge the bands, shifting their run indexes by the number of runs in the bands above
+  QVector<int> parents;
+  m_rowStarts.reserve (m_height + 1);
+  for (int band = 0; band < bandCount; band++) {
+
+    const ConnectedComponentsBand &componentsBand = bands.at (band);
+    int base = m_runs.count ();
+
+    for (int y = componentsBand.yStart; y < componentsBand.yStop; y++) {
+      m_rowStarts.append (base + componentsBand.rowStarts.at (y - componentsBand.yStart));
+    }
+
+    m_runs += componentsBand.runs;
+    for (int i = 0; i < componentsBand.parents.count (); i++) {
+      parents.append (base + componentsBand.parents.at (i));
+    }
+  }
+  m_rowStarts.append (m_runs.count ());
+
+  // Only the runs on either side of each border between bands remain to be joined
+  for (int band = 1; band < bandCount; band++) {
+
+    int y = bands.at (band).yStart;
+    if ((0 < y) && (y < m_height)) {
+      joinRows (m_runs,
+                parents,
+                m_rowStarts.at (y - 1),
+                m_rowStarts.at (y),
+                m_rowStarts.at (y),
+                m_rowStarts.at (y + 1));
+    }
+  }
+
+  labelRuns (parents);
+
+  LOG4CPP_DEBUG_S ((*mainCat)) << "ConnectedComponents::ConnectedComponents"
+                               << " on=" << (on ? "true" : "false")
+                               << " bands=" << bandCount
+                               << " runs=" << m_runs.count ()
+                               << " components=" << m_components.count ();
+}
+
+int ConnectedComponents::area (int x,
+                               int y) const
+{
+  int labelAtPoint = label (x, y);
+  if (labelAtPoint < 0) {
+    return 0;
+  }
+
+  return m_components.at (labelAtPoint).area;
+}
+
+const ConnectedComponent &ConnectedComponents::component (int label) const
+{
+  ENGAUGE_ASSERT ((0 <= label) && (label < m_components.count ()));
+
+  return m_components.at (label);
+}
+
+int ConnectedComponents::count () const
+{
+  return m_components.count ();
+}
+
+int ConnectedComponents::height () const
+{
+  return m_height;
+}
+
+int ConnectedComponents::label (int x,
+                                int y) const
+{
+  if ((x < 0) ||
+      (y < 0) ||
+      (x >= m_width) ||
+      (y >= m_height)) {
+    return -1;
+  }
+
+  // Last run of the row that starts at or before x
+  int low = m_rowStarts.at (y);
+  int high = m_rowStarts.at (y + 1);
+  while (low < high) {
+    int middle = (low + high) / 2;
+    if (m_runs.at (middle).xStart <= x) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  if ((low > m_rowStarts.at (y)) &&
+      (x <= m_runs.at (low - 1).xStop)) {
+    return m_runs.at (low - 1).label;
+  }
+
+  return -1;
+}
+
+void ConnectedComponents::labelRuns (QVector<int> &parents)
+{
+  QVector<double> sumsX, sumsY;
+
+  for (int y = 0; y < m_height; y++) {
+    for (int index = m_rowStarts.at (y); index < m_rowStarts.at (y + 1); index++) {
+
+      ConnectedComponentRun &run = m_runs [index];
+
+      // Roots come before the other runs of their sets, so the label of a root is always known by now
+      int root = findRoot (parents, index);
+      if (root == index) {
+
+        ConnectedComponent component;
+        component.area = 0;
+        component.boundingRect = QRect (run.xStart,
+                                        y,
+                                        run.xStop - run.xStart + 1,
+                                        1);
+        run.label = m_components.count ();
+        m_components.append (component);
+        sumsX.append (0);
+        sumsY.append (0);
+
+      } else {
+
+        run.label = m_runs.at (root).label;
+
+      }
+
+      int length = run.xStop - run.xStart + 1;
+      ConnectedComponent &component = m_components [run.label];
+      component.area += length;
+      if (run.xStart < component.boundingRect.left ()) {
+        component.boundingRect.setLeft (run.xStart);
+      }
+      if (run.xStop > component.boundingRect.right ()) {
+        component.boundingRect.setRight (run.xStop);
+      }
+      component.boundingRect.setBottom (y);
+
+      sumsX [run.label] += length * (run.xStart + run.xStop) / 2.0;
+      sumsY [run.label] += length * (double) y;
+    }
+  }
+
+  for (int label = 0; label < m_components.count (); label++) {
+    ConnectedComponent &component = m_components [label];
+    component.centroid = QPointF (sumsX.at (label) / component.area,
+                                  sumsY.at (label) / component.area);
+  }
+}
+
+const ConnectedComponentRun *ConnectedComponents::rowRuns (int y,
+                                                           int &count) const
+{
+  ENGAUGE_ASSERT ((0 <= y) && (y < m_height));
+
+  count = m_rowStarts.at (y + 1) - m_rowStarts.at (y);
+
+  return m_runs.constData () + m_rowStarts.at (y);
+}
+
+int ConnectedComponents::width () const
+{
+  return m_width;
+}
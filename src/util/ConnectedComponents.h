@@ -0,0 +1,96 @@
+/******************************************************************************************************
+ * (C) 2018 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#ifndef CONNECTED_COMPONENTS_H
+#define CONNECTED_COMPONENTS_H
+
+#include <QPointF>
+#include <QRect>
+#include <QVector>
+
+class BitPlane;
+
+/// Helper class so ConnectedComponents can report the size and location of each component
+struct ConnectedComponent {
+  /// Number of pixels.
+  int area;
+
+  /// Smallest rectangle containing all of the pixels.
+  QRect boundingRect;
+
+  /// Average of the pixel coordinates.
+  QPointF centroid;
+};
+
+/// Helper class so ConnectedComponents can store each row as runs of labeled pixels, rather than one label per pixel
+struct ConnectedComponentRun {
+  /// First column of the run.
+  int xStart;
+
+  /// Last column of the run, inclusive.
+  int xStop;
+
+  /// Component that the run belongs to.
+  int label;
+};
+
+/// Labels the 8-connected regions of on (or off) pixels in a BitPlane, once, so region sizes can be looked up
+/// afterwards instead of being rediscovered with a flood fill for each query.
+///
+/// Labeling uses the classic two passes, but over runs rather than pixels. The first pass extracts the runs of each
+/// row a word at a time, and joins each run to the runs it touches in the row above with union-find. Bands of rows
+/// go through the first pass in parallel, after which only the runs along the band borders are joined. The second
+/// pass gives each union-find set a label, in the order of its first run, and accumulates the component statistics
+class ConnectedComponents
+{
+public:
+  /// Default constructor for an empty image without any components
+  ConnectedComponents ();
+
+  /// Constructor that labels the on pixels, or the off pixels if on is false
+  ConnectedComponents (const BitPlane &bitPlane,
+                       bool on = true);
+
+  /// Number of pixels in the component containing (x,y), or zero if (x,y) was not labeled
+  int area (int x,
+            int y) const;
+
+  /// Component with the specified label, which runs from zero to count()-1
+  const ConnectedComponent &component (int label) const;
+
+  /// Number of components
+  int count () const;
+
+  /// Height in pixels
+  int height () const;
+
+  /// Label of the component containing (x,y), or -1 if (x,y) was not labeled or is outside the image. This is a
+  /// binary search over the runs of row y
+  int label (int x,
+             int y) const;
+
+  /// Runs of row y from left to right, which together with their labels form a run length encoded label image.
+  /// The number of runs is returned in count
+  const ConnectedComponentRun *rowRuns (int y,
+                                        int &count) const;
+
+  /// Width in pixels
+  int width () const;
+
+private:
+
+  // Give each union-find set a label and accumulate the statistics of its component
+  void labelRuns (QVector<int> &parents);
+
+  int m_width;
+  int m_height;
+
+  QVector<ConnectedComponentRun> m_runs; // Runs of all rows, from top to bottom
+  QVector<int> m_rowStarts; // Index of first run of each row, plus one entry for the end of the last row
+  QVector<ConnectedComponent> m_components;
+};
+
+#endif // CONNECTED_COMPONENTS_H
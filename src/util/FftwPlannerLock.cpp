@@ -0,0 +1,20 @@
+/******************************************************************************************************
+ * (C) 2014 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#include "FftwPlannerLock.h"
+#include <QMutex>
+
+static QMutex plannerMutex;
+
+FftwPlannerLock::FftwPlannerLock()
+{
+  plannerMutex.lock ();
+}
+
+FftwPlannerLock::~FftwPlannerLock()
+{
+  plannerMutex.unlock ();
+}
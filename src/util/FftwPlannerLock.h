@@ -0,0 +1,25 @@
+/******************************************************************************************************
+ * (C) 2014 markummitchell@github.com. This file is part of Engauge Digitizer, which is released      *
+ * under GNU General Public License version 2 (GPLv2) or (at your option) any later version. See file *
+ * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
+ ******************************************************************************************************/
+
+#ifndef FFTW_PLANNER_LOCK_H
+#define FFTW_PLANNER_LOCK_H
+
+/// Scoped lock around calls into the FFTW planner. Only fftw_execute is thread safe, so creating and destroying
+/// plans, and importing or exporting wisdom, must happen while one of these is alive, since point match plans are
+/// made in a worker thread while other FFTW users (like Correlation) run in the gui thread
+class FftwPlannerLock
+{
+public:
+  /// Single constructor, which waits until no other thread holds the lock
+  FftwPlannerLock();
+  ~FftwPlannerLock();
+
+private:
+  FftwPlannerLock(const FftwPlannerLock &other);
+  FftwPlannerLock &operator=(const FftwPlannerLock &other);
+};
+
+#endif // FFTW_PLANNER_LOCK_H
@@ -4,67 +4,165 @@
  * LICENSE or go to gnu.org/licenses for details. Distribution requires prior written permission.     *
  ******************************************************************************************************/
 
+#include <algorithm>
+#include "BitPlane.h"
+#include "ConnectedComponents.h"
 #include "Pixels.h"
 #include <QImage>
 #include <qmath.h>
 #include <QRgb>
+#include <QtAlgorithms>
+
+// For the 32-bit formats, whose scanlines are written directly, get the value that setPixel (x, y, Qt::black) would
+// store. That call stores the enum value of Qt::black as is, forcing the alpha to opaque only for Format_RGB32, so
+// the raw writes leave exactly the same pixels as the setPixel loop they replaced
+static inline bool blackInScanLine (const QImage &image,
+                                    QRgb &rgbBlack)
+{
+  switch (image.format ()) {
+    case QImage::Format_RGB32:
+      rgbBlack = 0xff000000 | (QRgb) Qt::black;
+      return true;
+
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+      rgbBlack = (QRgb) Qt::black;
+      return true;
+
+    default:
+      rgbBlack = 0;
+      return false;
+  }
+}
+
+// Bits of word w of a row for the columns that are not in the first or last column of the image
+static inline quint32 columnsInsideBorder (int w,
+                                          int wordsPerRow,
+                                          int width)
+{
+  quint32 mask = ~(quint32) 0;
+  if (w == 0) {
+    mask &= ~(quint32) 1;
+  }
+  if (w == wordsPerRow - 1) {
+    int bitsLast = width - 32 * w; // Between 1 and 32
+    mask &= (bitsLast == 32 ? ~(quint32) 0 : ((quint32) 1 << bitsLast) - 1) >> 1;
+  }
+
+  return mask;
+}
+
+// Full adder applied to all 32 bit positions at once
+static inline void addBits (quint32 a,
+                            quint32 b,
+                            quint32 c,
+                            quint32 &sum,
+                            quint32 &carry)
+{
+  sum = a ^ b ^ c;
+  carry = (a & b) | (c & (a ^ b));
+}
+
+// For word w of the center row, set the bit of each pixel with more than 4 of its 8 neighbors on. The neighbor
+// counts of all 32 pixels are summed at once, bit-sliced, by a tree of full adders
+static inline quint32 moreThanHalfNeighborsBlack (const quint32 *above,
+                                                  const quint32 *center,
+                                                  const quint32 *below,
+                                                  int w,
+                                                  int wordsPerRow)
+{
+  // Left neighbor of column x is bit x-1, which comes from the top bit of the previous word at the start of a word.
+  // Right neighbor is bit x+1, similarly from the next word. Padding bits are zero, like the pixels outside the image
+  quint32 prevAbove = (w > 0 ? above [w - 1] : 0), nextAbove = (w + 1 < wordsPerRow ? above [w + 1] : 0);
+  quint32 prevCenter = (w > 0 ? center [w - 1] : 0), nextCenter = (w + 1 < wordsPerRow ? center [w + 1] : 0);
+  quint32 prevBelow = (w > 0 ? below [w - 1] : 0), nextBelow = (w + 1 < wordsPerRow ? below [w + 1] : 0);
+
+  quint32 aboveLeft = (above [w] << 1) | (prevAbove >> 31);
+  quint32 aboveRight = (above [w] >> 1) | (nextAbove << 31);
+  quint32 centerLeft = (center [w] << 1) | (prevCenter >> 31);
+  quint32 centerRight = (center [w] >> 1) | (nextCenter << 31);
+  quint32 belowLeft = (below [w] << 1) | (prevBelow >> 31);
+  quint32 belowRight = (below [w] >> 1) | (nextBelow << 31);
+
+  // Ones
+  quint32 sum0, carry0, sum1, carry1;
+  addBits (aboveLeft, above [w], aboveRight, sum0, carry0);
+  addBits (belowLeft, below [w], belowRight, sum1, carry1);
+  quint32 sum2 = centerLeft ^ centerRight;
+  quint32 carry2 = centerLeft & centerRight;
+  quint32 ones, carryOnes;
+  addBits (sum0, sum1, sum2, ones, carryOnes);
+
+  // Twos, of which there are up to four
+  quint32 sumTwos, carryTwos;
+  addBits (carry0, carry1, carry2, sumTwos, carryTwos);
+  quint32 twos = sumTwos ^ carryOnes;
+  quint32 carryTwosOnes = sumTwos & carryOnes;
+
+  // Fours and eights
+  quint32 fours = carryTwos ^ carryTwosOnes;
+  quint32 eights = carryTwos & carryTwosOnes;
+
+  // More than 4 is 5 through 8
+  return eights | (fours & (twos | ones));
+}
 
 Pixels::Pixels ()
 {
 }
 
-int Pixels::countBlackPixelsAroundPoint (const QImage &image,
+int Pixels::countBlackPixelsAroundPoint (const BitPlane &bitPlane,
                                          int x,
                                          int y,
                                          int stopCountAt)
 {
-  int count = 0;
-  QueuedPoints queuedPoints;
-  HashLookup hashLookup; // Prevents reprocessing of already-processed pixels
+  // Pixels outside the image are white, so bounds need no separate check
+  if (!pixelIsBlack (bitPlane, x, y)) {
+    return 0;
+  }
 
-  // First point
-  if (pixelIsBlack (image, x, y)) {
-    queuedPoints.push_back (QPoint (x, y));
+  if (m_visited.size () != bitPlane.size ()) {
+    m_visited = BitPlane (bitPlane.width (),
+                          bitPlane.height ());
   }
 
-  while (queuedPoints.count () > 0) {
-    
-    // Pop off queue
-    QPoint p = queuedPoints.front ();
-    queuedPoints.pop_front ();
-
-    QString hash = hashForCoordinates (p.x(),
-                                       p.y());
-
-    // Skip if out of bounds, processed already or not black
-    bool inBounds = (0 <= p.x() &&
-                     0 <= p.y() &&
-                     p.x() < image.width () &&
-                     p.y() < image.height ());
-    if (inBounds &&
-        !hashLookup.contains (hash) &&
-        pixelIsBlack (image, p.x(), p.y())) {
-
-      // Black pixel. Add to count, and remember to not reprocess later
-      ++count;
-      if (count == stopCountAt) {
-        return count; // Reached limit. Stop immediately (probably for speed)
-      }
-      hashLookup [hash] = true;
+  // Each pixel is marked and counted when it is queued, so it is never queued twice. The queue holds every visited
+  // pixel, and the front of the queue is just an index so the pixels remain available for the cleanup below
+  m_queue.clear ();
+  m_queue.append (QPoint (x, y));
+  m_visited.setPixel (x, y, true);
+  int count = 1;
 
-      // Queue neighbors for processing
+  for (int head = 0; (head < m_queue.count ()) && (count != stopCountAt); head++) {
+
+    QPoint p = m_queue.at (head);
+
+    for (int dy = -1; dy <= 1; dy++) {
       for (int dx = -1; dx <= 1; dx++) {
-        for (int dy = -1; dy <= 1; dy++) {
-          if (dx != 0 || dy != 0) {
-            queuedPoints.push_back (QPoint (p.x() + dx,
-                                            p.y() + dy));
-          }
+
+        int xNeighbor = p.x() + dx;
+        int yNeighbor = p.y() + dy;
+
+        if ((count != stopCountAt) &&
+            pixelIsBlack (bitPlane, xNeighbor, yNeighbor) &&
+            !m_visited.pixel (xNeighbor, yNeighbor)) {
+
+          m_visited.setPixel (xNeighbor, yNeighbor, true);
+          m_queue.append (QPoint (xNeighbor, yNeighbor));
+          ++count;
         }
       }
     }
   }
 
-  return count; // Did not reach limit
+  // Unmark only the visited pixels, rather than clearing the whole image, for the next call
+  for (int index = 0; index < m_queue.count (); index++) {
+    m_visited.setPixel (m_queue.at (index).x(),
+                        m_queue.at (index).y(),
+                        false);
+  }
+
+  return count; // Stops at stopCountAt if that was reached
 }
 
 void Pixels::fillHole (QImage &image,
@@ -108,44 +206,46 @@ void Pixels::fillHole (QImage &image,
 void Pixels::fillHoles (QImage &image,
                         int thresholdCount)
 {
-  int height = image.height();
-  int width = image.width();
+  // Label every white region in one pass
+  ConnectedComponents regions (BitPlane (image,
+                                         PIXEL_IS_BLACK_THRESHOLD),
+                               false);
+
+  // Raw scanlines are written for the 32-bit formats, which hold almost every image that gets here
+  QRgb rgbBlack;
+  bool isRgb32 = blackInScanLine (image,
+                                  rgbBlack);
+
+  for (int row = 0; row < regions.height (); row++) {
 
-  // 2d matrix, indexed as 1d vector, of pixel states
-  QVector<PixelFillState> states (image.width() * image.height());
-  states.fill (PIXEL_FILL_STATE_UNPROCESSED);
+    int count;
+    const ConnectedComponentRun *runs = regions.rowRuns (row,
+                                                         count);
 
-  // Search for unprocessed pixels
-  for (int col = 0; col < width; col++) {
-    for (int row = 0; row < height; row++) {
-      if (states [indexCollapse (row, col, width)] == PIXEL_FILL_STATE_UNPROCESSED) {
+    QRgb *line = 0;
+    for (int index = 0; index < count; index++) {
 
-        // Found an unprocessed pixel so process it
-        if (pixelIsBlack (image, col, row)) {
+      const ConnectedComponentRun &run = runs [index];
+      if (regions.component (run.label).area < thresholdCount) {
 
-          // Black pixel needs no processing
-          states [indexCollapse (row, col, width)] = PIXEL_FILL_STATE_PROCESSED;
+        if (isRgb32) {
+
+          // Detach only for rows that are actually filled
+          if (line == 0) {
+            line = (QRgb *) image.scanLine (row);
+          }
+
+          std::fill (line + run.xStart,
+                     line + run.xStop + 1,
+                     rgbBlack);
 
         } else {
 
-          // Get this pixel and all of its white neighbors
-          int pixelsInRegion = fillPass (image,
-                                         states,
-                                         row,
-                                         col,
-                                         PIXEL_FILL_STATE_UNPROCESSED,
-                                         PIXEL_FILL_STATE_IN_PROCESS,
-                                         NO_FILL);
-
-          FillIt fillIt = (pixelsInRegion < thresholdCount) ? YES_FILL : NO_FILL;
-
-          fillPass (image,
-                    states,
-                    row,
-                    col,
-                    PIXEL_FILL_STATE_IN_PROCESS,
-                    PIXEL_FILL_STATE_PROCESSED,
-                    fillIt);
+          for (int col = run.xStart; col <= run.xStop; col++) {
+            image.setPixel (col,
+                            row,
+                            Qt::black);
+          }
         }
       }
     }
@@ -155,132 +255,68 @@ void Pixels::fillHoles (QImage &image,
 void Pixels::fillIsolatedWhitePixels (QImage &image)
 {
   const int BORDER = 1;
-  const int HALF_NUMBER_NEIGHBORS = 4; // 8 neighbors in each direction from (col,row)
 
   int height = image.height();
   int width = image.width();
 
-  // 2d matrix, indexed as 1d vector, of neighbor counts
-  QVector<bool> pixelsAreBlack (image.width() * image.height());
-
-  // Replace slow QImage addressing by faster QVector addressing
-  for (int col = 0; col < width; col++) {
-    for (int row = 0; row < height; row++) {
-      pixelsAreBlack [indexCollapse (row, col, width)] = pixelIsBlack (image, col, row);
-    }
+  if ((width <= 2 * BORDER) ||
+      (height <= 2 * BORDER)) {
+    return; // No pixels away from the borders
   }
 
-  // Search for white pixels. Black pixels will be ignored, and also pixels along the four
-  // borders are ignored so we do not need to worry about going out of bounds
-  for (int col = BORDER; col < width - BORDER; col++) {
-    for (int row = BORDER; row < height - BORDER; row++) {
-      int count = 0;
-      count += pixelsAreBlack [indexCollapse (row - 1, col - 1, width)] ? 1 : 0;
-      count += pixelsAreBlack [indexCollapse (row - 1, col    , width)] ? 1 : 0;
-      count += pixelsAreBlack [indexCollapse (row - 1, col + 1, width)] ? 1 : 0;
-      count += pixelsAreBlack [indexCollapse (row    , col - 1, width)] ? 1 : 0;
-      count += pixelsAreBlack [indexCollapse (row    , col + 1, width)] ? 1 : 0;
-      count += pixelsAreBlack [indexCollapse (row + 1, col - 1, width)] ? 1 : 0;
-      count += pixelsAreBlack [indexCollapse (row + 1, col    , width)] ? 1 : 0;
-      count += pixelsAreBlack [indexCollapse (row + 1, col + 1, width)] ? 1 : 0;
-      if (count > HALF_NUMBER_NEIGHBORS) {
-        image.setPixel (col,
-                          row,
-                          Qt::black);
-      }
-    }
-  }
-}
+  // Snapshot of the black pixels, so filled pixels do not affect their neighbors, packed 32 pixels per word
+  BitPlane bitPlane (image,
+                     PIXEL_IS_BLACK_THRESHOLD);
+  int wordsPerRow = bitPlane.wordsPerRow ();
 
-int Pixels::fillPass (QImage &image,
-                      QVector<PixelFillState> &states,
-                      int rowIn,
-                      int colIn,
-                      PixelFillState stateFrom,
-                      PixelFillState stateTo,
-                      FillIt fillit)
-{
-  int height = image.height();
-  int width = image.width ();
-  int count = 0;
-  QList<QPoint> applicablePoints;
-
-  // Add only applicable points to the running list
-  applicablePoints.append (QPoint (colIn, rowIn));
-
-  while (applicablePoints.count() > 0) {
-
-    QPoint p = applicablePoints.front();
-    applicablePoints.pop_front();
-
-    int col = p.x();
-    int row = p.y();
-
-    // Double check point is still applicable and that has not changed since added to list
-    PixelFillState stateGot = states [indexCollapse (row, col, width)];
-    if (stateGot == stateFrom &&
-        !pixelIsBlack (image,
-                       col,
-                       row)) {
-
-      // Still applicable. Do state-specific stuff here
-      if (stateTo == PIXEL_FILL_STATE_IN_PROCESS) {
-        ++count;
-      } else {
-        if (fillit == YES_FILL) {
-          image.setPixel (col, row, Qt::black);
-        }
-      }
+  QRgb rgbBlack;
+  bool isRgb32 = blackInScanLine (image,
+                                  rgbBlack);
 
-      // Change state to prevent reprocessing
-      states [indexCollapse (row, col, width)] = stateTo;
+  // Pixels along the four borders are ignored so we do not need to worry about going out of bounds
+  for (int row = BORDER; row < height - BORDER; row++) {
 
-      // "Recurse" using list instead of actual recursion (to prevent stack overflow)
-      for (int dx = -1; dx <= 1; dx++) {
-        int colD = col + dx;
-        if (0 <= colD && colD < width) {
-
-          for (int dy = -1; dy <= 1; dy++) {
-            int rowD = row + dy;
-            if (0 <= rowD && rowD < height) {
-
-              if (dx != 0 || dy != 0) {
-
-                PixelFillState stateGot = states [indexCollapse (rowD, colD, width)];
-                if (stateGot == stateFrom &&
-                    !pixelIsBlack (image,
-                                   colD,
-                                   rowD)) {
-
-                  // This point is applicable
-                  applicablePoints.append (QPoint (colD, rowD));
-                }
-              }
-            }
+    const quint32 *above = bitPlane.row (row - 1);
+    const quint32 *center = bitPlane.row (row);
+    const quint32 *below = bitPlane.row (row + 1);
+
+    QRgb *line = 0;
+    for (int w = 0; w < wordsPerRow; w++) {
+
+      // Every pixel that is not in the first or last column is filled, including pixels that are already dark. Those
+      // are not always pure black, such as the pixels of colored curves and jpeg artifacts, so they still change
+      quint32 candidates = columnsInsideBorder (w,
+                                                wordsPerRow,
+                                                width);
+      candidates &= moreThanHalfNeighborsBlack (above,
+                                                center,
+                                                below,
+                                                w,
+                                                wordsPerRow);
+
+      while (candidates != 0) {
+
+        int col = 32 * w + (int) qCountTrailingZeroBits (candidates);
+        candidates &= candidates - 1;
+
+        if (isRgb32) {
+
+          // Detach only for rows that are actually filled
+          if (line == 0) {
+            line = (QRgb *) image.scanLine (row);
           }
+
+          line [col] = rgbBlack;
+
+        } else {
+
+          image.setPixel (col,
+                          row,
+                          Qt::black);
         }
       }
     }
   }
-
-  return count;
-}
-
-QString Pixels::hashForCoordinates (int x,
-                                    int y) const
-{
-  const int FIELD_WIDTH = 6;
-
-  return QString ("%1/%2")
-      .arg (x, FIELD_WIDTH)
-      .arg (y, FIELD_WIDTH);
-}
-
-int Pixels::indexCollapse (int row,
-                           int col,
-                           int width) const
-{
-  return row * width + col;
 }
 
 bool Pixels::pixelIsBlack (const QImage &image,
@@ -288,6 +324,12 @@ bool Pixels::pixelIsBlack (const QImage &image,
                            int y)
 {
   QRgb rgb = image.pixel (x, y);
-  return qGray (rgb) < 128;
+  return qGray (rgb) < PIXEL_IS_BLACK_THRESHOLD;
 }
 
+bool Pixels::pixelIsBlack (const BitPlane &bitPlane,
+                           int x,
+                           int y)
+{
+  return bitPlane.pixel (x, y);
+}
@@ -7,25 +7,15 @@
 #ifndef PIXELS_H
 #define PIXELS_H
 
-#include <QMap>
+#include "BitPlane.h"
 #include <QPoint>
-#include <QQueue>
 #include <QStack>
-#include <QString>
+#include <QVector>
 
 class QImage;
 
-/// Quick lookup table for pixel coordinate hashes processed so far
-typedef QMap<QString, bool> HashLookup;
-
-typedef QQueue<QPoint> QueuedPoints;
-
-/// Each pixel transitions from unprocessed, to in-process, to processed
-enum PixelFillState {
-  PIXEL_FILL_STATE_UNPROCESSED,
-  PIXEL_FILL_STATE_IN_PROCESS,
-  PIXEL_FILL_STATE_PROCESSED
-};
+/// Gray levels below this are black in pixelIsBlack and in the packed images made from a color image
+const int PIXEL_IS_BLACK_THRESHOLD = 128;
 
 /// Utility class for pixel manipulation
 class Pixels
@@ -34,8 +24,10 @@ public:
   /// Single constructor
   Pixels();
 
-  /// Fill triangle between these three points
-  int countBlackPixelsAroundPoint (const QImage &image,
+  /// Count the black pixels connected to (x,y), stopping early once stopCountAt is reached. The visited pixels are
+  /// tracked in scratch buffers that are kept between calls, so repeated calls on the same Pixels instance do not
+  /// allocate memory, and each call costs time proportional to the count rather than to the image size
+  int countBlackPixelsAroundPoint (const BitPlane &bitPlane,
                                    int x,
                                    int y,
                                    int stopCountAt);
@@ -46,40 +38,32 @@ public:
                  int col,
                  int thresholdCount) const;
 
-  /// Fill in white holes, surrounded by black pixels, smaller than some threshold number of pixels. Originally
-  /// this was recursive but the high recursion levels (for big regions) overflowed the stack
+  /// Fill in white holes, surrounded by black pixels, smaller than some threshold number of pixels. All white regions
+  /// are labeled at once by ConnectedComponents, and then the runs of the small regions are filled row by row, so the
+  /// cost is linear in the image size
   void fillHoles (QImage &image,
                   int thresholdCount);
 
   /// Fill in white pixels surrounded by more black pixels than white pixels. This is much faster than
-  /// fillHoles and effectively as good
+  /// fillHoles and effectively as good. The neighbors of 32 pixels are counted at once in the packed image. Dark
+  /// pixels with the same neighbors are also written, so they become pure black like the filled white pixels
   void fillIsolatedWhitePixels (QImage &image);
 
   /// Return true if pixel is black in black and white image
   static bool pixelIsBlack (const QImage &image,
                             int x,
                             int y);
+
+  /// Return true if pixel is black in packed black and white image. Pixels outside the image are white
+  static bool pixelIsBlack (const BitPlane &bitPlane,
+                            int x,
+                            int y);
   
 private:
 
-  enum FillIt {
-    NO_FILL,
-    YES_FILL
-  };
-
-  // Multiple pass algorithm
-  int fillPass (QImage &image,
-                QVector<PixelFillState> &states,
-                int row,
-                int col,
-                PixelFillState stateFrom,
-                PixelFillState stateTo,
-                FillIt fillit);
-  QString hashForCoordinates (int x,
-                              int y) const;
-  int indexCollapse (int row,
-                     int col,
-                     int width) const;
+  // Scratch buffers for countBlackPixelsAroundPoint. Between calls, no pixel in m_visited is on
+  BitPlane m_visited;
+  QVector<QPoint> m_queue;
 };
 
 #endif // PIXELS_H